@@ -1,51 +1,278 @@
 from flask import Flask, request, jsonify
 from flask_cors import CORS
+from collections import OrderedDict
+import hashlib
+import json
 import subprocess
 import os
 import tempfile
+import threading
 
 app = Flask(__name__)
 CORS(app)
 
+# Every submission is compiled with these options; they are part of the
+# cache key, so changing them never serves a stale binary.
+COMPILER_COMMAND = ['gcc']
+
+
+def compiler_version():
+    """What gcc --version prints, also part of the cache key: binaries built
+    by a gcc since upgraded or replaced are not served."""
+    try:
+        return subprocess.run(COMPILER_COMMAND + ['--version'], capture_output=True, text=True).stdout
+    except OSError:
+        return ''
+
+
+COMPILER_VERSION = compiler_version()
+
+# The project's own compiler (backend/compiler), which /check runs in its
+# parse-only mode.
+MINICC_PATH = os.environ.get('MINICC_PATH') or os.path.join(
+    os.path.dirname(os.path.abspath(__file__)), 'compiler', 'compiler')
+
+
+def normalize_source(code):
+    """Line endings, trailing whitespace and trailing blank lines do not
+    change what gcc produces (or which line an error points at), so
+    submissions that differ only in those share one cache entry."""
+    lines = [line.rstrip() for line in code.replace('\r\n', '\n').replace('\r', '\n').split('\n')]
+    while lines and not lines[-1]:
+        lines.pop()
+    return '\n'.join(lines) + '\n'
+
+
+class CompileCache:
+    """Compiled executables and compile errors keyed by a hash of the
+    normalized source and the compiler options. Entries live in memory
+    with LRU eviction (by count and total size) and, when a directory is
+    given, also on disk so they survive restarts. Files on disk are
+    deleted least recently used first once they exceed max_disk_bytes."""
+
+    def __init__(self, max_entries=256, max_bytes=64 << 20, directory=None, max_disk_bytes=1 << 30):
+        self.max_entries = max_entries
+        self.max_bytes = max_bytes
+        self.directory = directory
+        self.max_disk_bytes = max_disk_bytes
+        self.disk_bytes = 0
+        self.disk_lock = threading.Lock()
+        self.entries = OrderedDict()    # key -> (binary or None, errors)
+        self.bytes = 0
+        self.lock = threading.Lock()
+        self.hits = 0
+        self.disk_hits = 0
+        self.misses = 0
+        self.evictions = 0
+        self.disk_evictions = 0
+        if directory:
+            os.makedirs(directory, exist_ok=True)
+            self.disk_bytes = sum(size for _, _, size in self._disk_files())
+
+    @staticmethod
+    def key(source, options):
+        digest = hashlib.blake2b(digest_size=16)
+        digest.update(json.dumps(options).encode())
+        digest.update(b'\0')
+        digest.update(source.encode())
+        return digest.hexdigest()
+
+    def get(self, key):
+        with self.lock:
+            entry = self.entries.get(key)
+            if entry is not None:
+                self.entries.move_to_end(key)
+                self.hits += 1
+                return entry
+        entry = self._load(key)
+        with self.lock:
+            if entry is None:
+                self.misses += 1
+                return None
+            self.disk_hits += 1
+            self._insert(key, entry)
+            return entry
+
+    def put(self, key, binary, errors):
+        entry = (binary, errors)
+        with self.lock:
+            self._insert(key, entry)
+        self._store(key, entry)
+
+    def stats(self):
+        with self.lock:
+            return {
+                'hits': self.hits,
+                'disk_hits': self.disk_hits,
+                'misses': self.misses,
+                'evictions': self.evictions,
+                'entries': len(self.entries),
+                'bytes': self.bytes,
+                'disk_evictions': self.disk_evictions,
+                'disk_bytes': self.disk_bytes,
+            }
+
+    def _insert(self, key, entry):
+        if key in self.entries:
+            self.bytes -= self._size(self.entries.pop(key))
+        self.entries[key] = entry
+        self.bytes += self._size(entry)
+        while len(self.entries) > self.max_entries or (self.bytes > self.max_bytes and len(self.entries) > 1):
+            _, evicted = self.entries.popitem(last=False)
+            self.bytes -= self._size(evicted)
+            self.evictions += 1
+
+    @staticmethod
+    def _size(entry):
+        binary, errors = entry
+        return (len(binary) if binary else 0) + sum(len(e) for e in errors)
+
+    def _path(self, key, suffix):
+        return os.path.join(self.directory, key + suffix)
+
+    def _load(self, key):
+        if not self.directory:
+            return None
+        for suffix in ('.bin', '.err'):
+            path = self._path(key, suffix)
+            try:
+                with open(path, 'rb' if suffix == '.bin' else 'r') as f:
+                    entry = (f.read(), []) if suffix == '.bin' else (None, json.load(f))
+            except (OSError, ValueError):
+                continue
+            # The modification time orders files for pruning.
+            try:
+                os.utime(path)
+            except OSError:
+                pass
+            return entry
+        return None
+
+    def _store(self, key, entry):
+        if not self.directory:
+            return
+        binary, errors = entry
+        suffix = '.bin' if binary else '.err'
+        # Write under a temporary name so a reader never sees half a file.
+        fd, temp_path = tempfile.mkstemp(dir=self.directory)
+        try:
+            with os.fdopen(fd, 'wb' if binary else 'w') as f:
+                if binary:
+                    f.write(binary)
+                else:
+                    json.dump(errors, f)
+            os.replace(temp_path, self._path(key, suffix))
+        except OSError:
+            if os.path.exists(temp_path):
+                os.unlink(temp_path)
+            return
+        with self.disk_lock:
+            self.disk_bytes += len(binary) if binary else len(json.dumps(errors))
+            if self.disk_bytes > self.max_disk_bytes:
+                self._prune()
+
+    def _disk_files(self):
+        """(modification time, path, size) of each entry on disk."""
+        files = []
+        for name in os.listdir(self.directory):
+            if not name.endswith(('.bin', '.err')):
+                continue
+            path = os.path.join(self.directory, name)
+            try:
+                info = os.stat(path)
+            except OSError:
+                continue
+            files.append((info.st_mtime, path, info.st_size))
+        return files
+
+    def _prune(self):
+        """Deletes the least recently used files until those left fill three
+        quarters of max_disk_bytes, so the next few stores do not prune
+        again. The total is recounted from the directory, which other
+        processes may share."""
+        files = sorted(self._disk_files())
+        total = sum(size for _, _, size in files)
+        for _, path, size in files:
+            if total <= self.max_disk_bytes * 3 // 4:
+                break
+            try:
+                os.unlink(path)
+            except OSError:
+                continue
+            total -= size
+            self.disk_evictions += 1
+        self.disk_bytes = total
+
+
+compile_cache = CompileCache(
+    max_entries=int(os.environ.get('COMPILE_CACHE_ENTRIES', 256)),
+    max_bytes=int(os.environ.get('COMPILE_CACHE_BYTES', 64 << 20)),
+    directory=os.environ.get('COMPILE_CACHE_DIR') or None,
+    max_disk_bytes=int(os.environ.get('COMPILE_CACHE_DIR_BYTES', 1 << 30)),
+)
+
+
+def build(source, workdir):
+    """Compiles source with gcc, returning (executable bytes, errors). The
+    file is always called program.c so cached error messages do not name
+    some other request's temporary file."""
+    source_path = os.path.join(workdir, 'program.c')
+    with open(source_path, 'w') as f:
+        f.write(source)
+    compile_result = subprocess.run(COMPILER_COMMAND + ['program.c', '-o', 'program'],
+                                    cwd=workdir,
+                                    capture_output=True,
+                                    text=True)
+    if compile_result.returncode != 0:
+        return None, [compile_result.stderr]
+    with open(os.path.join(workdir, 'program'), 'rb') as f:
+        return f.read(), []
+
+
 @app.route('/compile', methods=['POST'])
 def compile_code():
     try:
         code = request.json.get('code', '')
         input_data = request.json.get('input', '')  # Get input data from request
-        
-        # Create a temporary file for the input code
-        with tempfile.NamedTemporaryFile(mode='w', suffix='.c', delete=False) as temp_file:
-            temp_file.write(code)
-            temp_file.flush()
-            
-            # Compile the code using gcc
-            compile_result = subprocess.run(['gcc', temp_file.name, '-o', temp_file.name + '.out'],
-                                         capture_output=True,
-                                         text=True)
-            
-            if compile_result.returncode != 0:
+
+        source = normalize_source(code)
+        key = CompileCache.key(source, [COMPILER_COMMAND, COMPILER_VERSION])
+
+        with tempfile.TemporaryDirectory() as workdir:
+            cached = compile_cache.get(key)
+            if cached is None:
+                binary, errors = build(source, workdir)
+                compile_cache.put(key, binary, errors)
+            else:
+                binary, errors = cached
+
+            if errors:
                 return jsonify({
                     'success': False,
                     'output': '',
-                    'errors': [compile_result.stderr]
+                    'errors': errors,
+                    'cached': cached is not None
                 })
-            
+
+            executable = os.path.join(workdir, 'program')
+            if cached is not None:
+                with open(executable, 'wb') as f:
+                    f.write(binary)
+                os.chmod(executable, 0o700)
+
             # Run the compiled program with input
-            run_result = subprocess.run([temp_file.name + '.out'],
-                                     input=input_data,  # Provide input to the program
-                                     capture_output=True,
-                                     text=True)
-            
-            # Clean up the temporary files
-            os.unlink(temp_file.name)
-            os.unlink(temp_file.name + '.out')
-            
+            run_result = subprocess.run([executable],
+                                        input=input_data,  # Provide input to the program
+                                        capture_output=True,
+                                        text=True)
+
             return jsonify({
                 'success': True,
                 'output': run_result.stdout,
-                'errors': []
+                'errors': [],
+                'cached': cached is not None
             })
-                
+
     except Exception as e:
         return jsonify({
             'success': False,
@@ -53,5 +280,57 @@ def compile_code():
             'errors': [str(e)]
         })
 
+
+@app.route('/check', methods=['POST'])
+def check_code():
+    """Lexes and parses the code without gcc, fast enough to run as the user
+    types. Returns the compiler's diagnostics (1-based lines and columns)
+    and, if 'ast' is set in the request, the syntax tree."""
+    try:
+        # Only line endings are normalized: positions must match the editor.
+        code = request.json.get('code', '').replace('\r\n', '\n')
+        if not os.access(MINICC_PATH, os.X_OK):
+            return jsonify({
+                'success': False,
+                'diagnostics': [],
+                'errors': [f'{MINICC_PATH} not found: run make in backend/compiler, or set MINICC_PATH']
+            })
+        command = [MINICC_PATH, '--check'] + (['--ast'] if request.json.get('ast') else [])
+        result = subprocess.run(command,
+                                input=code,
+                                capture_output=True,
+                                text=True,
+                                timeout=10)
+        if result.returncode < 0:
+            # Killed by a signal: a compiler bug, not a stale build.
+            return jsonify({
+                'success': False,
+                'diagnostics': [],
+                'errors': [f'compiler crashed (signal {-result.returncode})']
+            })
+        try:
+            return jsonify(json.loads(result.stdout))
+        except ValueError:
+            # An old build without --check; make rebuilds it.
+            return jsonify({
+                'success': False,
+                'diagnostics': [],
+                'errors': [f'{MINICC_PATH} --check did not print JSON (is it out of date? run make): '
+                           + (result.stderr or result.stdout).strip()]
+            })
+
+    except Exception as e:
+        return jsonify({
+            'success': False,
+            'diagnostics': [],
+            'errors': [str(e)]
+        })
+
+
+@app.route('/cache/stats', methods=['GET'])
+def cache_stats():
+    return jsonify(compile_cache.stats())
+
+
 if __name__ == '__main__':
-    app.run(debug=True, port=5000) 
\ No newline at end of file
+    app.run(debug=True, port=5000)
@@ -1,12 +1,35 @@
 #ifndef AST_H
 #define AST_H
 
+#include <string.h>
+
 typedef struct ASTNode {
     char* type;
     char* value;
+    int depth;          // variables: scope depth from resolve_symbols, -1 if unresolved
+    int slot;           // variables: frame slot (global slot at depth 0)
+    int redeclared;     // declarations: the name was already declared in the same scope
+    int offset;         // byte offset of the source it came from, -1 if none
     struct ASTNode* left;
     struct ASTNode* right;
     struct ASTNode* next;
 } ASTNode;
 
-#endif 
\ No newline at end of file
+extern ASTNode* ast_root;
+
+ASTNode* create_node(char* type, char* value);
+ASTNode* create_binary_node(char* type, ASTNode* left, ASTNode* right);
+void free_ast(ASTNode* node);
+void print_ast(ASTNode* node, int level);
+
+static inline int node_is(const ASTNode* node, const char* type) {
+    return node && strcmp(node->type, type) == 0;
+}
+
+// printf/scanf nodes point their value (the format literal) into the
+// string pool instead of owning a copy.
+static inline int holds_literal(const ASTNode* node) {
+    return node_is(node, "printf") || node_is(node, "scanf");
+}
+
+#endif
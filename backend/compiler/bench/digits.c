@@ -0,0 +1,30 @@
+int digit_sum(int n) {
+    int sum = 0;
+    while (n) {
+        sum = sum + (n - n / 10 * 10);
+        n = n / 10;
+    }
+    return sum;
+}
+
+int reverse(int n) {
+    int result = 0;
+    while (n) {
+        result = result * 10 + (n - n / 10 * 10);
+        n = n / 10;
+    }
+    return result;
+}
+
+int main() {
+    int n;
+    int i = 0;
+    int checksum = 0;
+    scanf("%d", &n);
+    while (n - i) {
+        checksum = checksum + digit_sum(i) * reverse(i);
+        i = i + 1;
+    }
+    printf("%d\n", checksum);
+    return 0;
+}
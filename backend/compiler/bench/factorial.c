@@ -0,0 +1,18 @@
+int factorial(int n) {
+    if (n) {
+        return n * factorial(n - 1);
+    }
+    return 1;
+}
+
+int main() {
+    int n;
+    int total = 0;
+    scanf("%d", &n);
+    while (n) {
+        total = total + factorial(n);
+        n = n - 1;
+    }
+    printf("%d\n", total);
+    return 0;
+}
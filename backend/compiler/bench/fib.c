@@ -0,0 +1,15 @@
+int fib(int n) {
+    if (n - n / 2 * 2 + n / 2) {
+        if (n - 1) {
+            return fib(n - 1) + fib(n - 2);
+        }
+    }
+    return n;
+}
+
+int main() {
+    int n;
+    scanf("%d", &n);
+    printf("%d\n", fib(n));
+    return 0;
+}
@@ -0,0 +1,19 @@
+int gcd(int a, int b) {
+    if (b) {
+        return gcd(b, a - a / b * b);
+    }
+    return a;
+}
+
+int main() {
+    int n;
+    int i = 1;
+    int total = 0;
+    scanf("%d", &n);
+    while (n - i) {
+        total = total + gcd(n, i);
+        i = i + 1;
+    }
+    printf("%d\n", total);
+    return 0;
+}
@@ -0,0 +1,11 @@
+// Output-bound: one printf per line, a million lines of mixed-sign values.
+int main() {
+    int n;
+    int x = 12345;
+    scanf("%d", &n);
+    for (int i = 0; i < n; i = i + 1) {
+        x = x * 1103515245 + 12345;
+        printf("%d %d\n", i, x / 65536);
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+// Tight counted loops: the inner loop has a runtime bound and is unrolled
+// by 4, the outer one has a constant trip count.
+int main() {
+    int n;
+    int s = 0;
+    scanf("%d", &n);
+    for (int r = 0; r < 100; r = r + 1) {
+        for (int i = 0; i < n; i = i + 1) {
+            s = s + i % 7 * r;
+        }
+    }
+    printf("%d\n", s);
+    return 0;
+}
@@ -0,0 +1,30 @@
+// 3x3 matrix power held entirely in scalars: high register pressure.
+int main() {
+    int a = 1; int b = 1; int c = 0;
+    int d = 1; int e = 0; int f = 1;
+    int g = 0; int h = 1; int k = 1;
+    int n;
+    scanf("%d", &n);
+    int r11 = 1; int r12 = 0; int r13 = 0;
+    int r21 = 0; int r22 = 1; int r23 = 0;
+    int r31 = 0; int r32 = 0; int r33 = 1;
+    while (n) {
+        int t11 = r11 * a + r12 * d + r13 * g;
+        int t12 = r11 * b + r12 * e + r13 * h;
+        int t13 = r11 * c + r12 * f + r13 * k;
+        int t21 = r21 * a + r22 * d + r23 * g;
+        int t22 = r21 * b + r22 * e + r23 * h;
+        int t23 = r21 * c + r22 * f + r23 * k;
+        int t31 = r31 * a + r32 * d + r33 * g;
+        int t32 = r31 * b + r32 * e + r33 * h;
+        int t33 = r31 * c + r32 * f + r33 * k;
+        r11 = t11 - t11 / 1000 * 1000; r12 = t12 - t12 / 1000 * 1000; r13 = t13 - t13 / 1000 * 1000;
+        r21 = t21 - t21 / 1000 * 1000; r22 = t22 - t22 / 1000 * 1000; r23 = t23 - t23 / 1000 * 1000;
+        r31 = t31 - t31 / 1000 * 1000; r32 = t32 - t32 / 1000 * 1000; r33 = t33 - t33 / 1000 * 1000;
+        n = n - 1;
+    }
+    printf("%d %d %d\n", r11, r12, r13);
+    printf("%d %d %d\n", r21, r22, r23);
+    printf("%d %d %d\n", r31, r32, r33);
+    return 0;
+}
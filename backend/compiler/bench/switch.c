@@ -0,0 +1,156 @@
+// A 64-way dense switch (jump table) and a 64-way sparse switch (binary
+// search) in a hot loop.
+int dense(int x) {
+    int t = 0;
+    switch (x) {
+            case 0: t = t + 0; break;
+            case 1: t = t + 37; break;
+            case 2: t = t + 74; break;
+            case 3: t = t + 10; break;
+            case 4: t = t + 47; break;
+            case 5: t = t + 84; break;
+            case 6: t = t + 20; break;
+            case 7: t = t + 57; break;
+            case 8: t = t + 94; break;
+            case 9: t = t + 30; break;
+            case 10: t = t + 67; break;
+            case 11: t = t + 3; break;
+            case 12: t = t + 40; break;
+            case 13: t = t + 77; break;
+            case 14: t = t + 13; break;
+            case 15: t = t + 50; break;
+            case 16: t = t + 87; break;
+            case 17: t = t + 23; break;
+            case 18: t = t + 60; break;
+            case 19: t = t + 97; break;
+            case 20: t = t + 33; break;
+            case 21: t = t + 70; break;
+            case 22: t = t + 6; break;
+            case 23: t = t + 43; break;
+            case 24: t = t + 80; break;
+            case 25: t = t + 16; break;
+            case 26: t = t + 53; break;
+            case 27: t = t + 90; break;
+            case 28: t = t + 26; break;
+            case 29: t = t + 63; break;
+            case 30: t = t + 100; break;
+            case 31: t = t + 36; break;
+            case 32: t = t + 73; break;
+            case 33: t = t + 9; break;
+            case 34: t = t + 46; break;
+            case 35: t = t + 83; break;
+            case 36: t = t + 19; break;
+            case 37: t = t + 56; break;
+            case 38: t = t + 93; break;
+            case 39: t = t + 29; break;
+            case 40: t = t + 66; break;
+            case 41: t = t + 2; break;
+            case 42: t = t + 39; break;
+            case 43: t = t + 76; break;
+            case 44: t = t + 12; break;
+            case 45: t = t + 49; break;
+            case 46: t = t + 86; break;
+            case 47: t = t + 22; break;
+            case 48: t = t + 59; break;
+            case 49: t = t + 96; break;
+            case 50: t = t + 32; break;
+            case 51: t = t + 69; break;
+            case 52: t = t + 5; break;
+            case 53: t = t + 42; break;
+            case 54: t = t + 79; break;
+            case 55: t = t + 15; break;
+            case 56: t = t + 52; break;
+            case 57: t = t + 89; break;
+            case 58: t = t + 25; break;
+            case 59: t = t + 62; break;
+            case 60: t = t + 99; break;
+            case 61: t = t + 35; break;
+            case 62: t = t + 72; break;
+            case 63: t = t + 8; break;
+        default: t = 1;
+    }
+    return t;
+}
+
+int sparse(int x) {
+    int t = 0;
+    switch (x) {
+            case -900: t = t + 0; break;
+            case -893: t = t + 53; break;
+            case -872: t = t + 9; break;
+            case -837: t = t + 62; break;
+            case -788: t = t + 18; break;
+            case -725: t = t + 71; break;
+            case -648: t = t + 27; break;
+            case -557: t = t + 80; break;
+            case -452: t = t + 36; break;
+            case -333: t = t + 89; break;
+            case -200: t = t + 45; break;
+            case -53: t = t + 1; break;
+            case 108: t = t + 54; break;
+            case 283: t = t + 10; break;
+            case 472: t = t + 63; break;
+            case 675: t = t + 19; break;
+            case 892: t = t + 72; break;
+            case 1123: t = t + 28; break;
+            case 1368: t = t + 81; break;
+            case 1627: t = t + 37; break;
+            case 1900: t = t + 90; break;
+            case 2187: t = t + 46; break;
+            case 2488: t = t + 2; break;
+            case 2803: t = t + 55; break;
+            case 3132: t = t + 11; break;
+            case 3475: t = t + 64; break;
+            case 3832: t = t + 20; break;
+            case 4203: t = t + 73; break;
+            case 4588: t = t + 29; break;
+            case 4987: t = t + 82; break;
+            case 5400: t = t + 38; break;
+            case 5827: t = t + 91; break;
+            case 6268: t = t + 47; break;
+            case 6723: t = t + 3; break;
+            case 7192: t = t + 56; break;
+            case 7675: t = t + 12; break;
+            case 8172: t = t + 65; break;
+            case 8683: t = t + 21; break;
+            case 9208: t = t + 74; break;
+            case 9747: t = t + 30; break;
+            case 10300: t = t + 83; break;
+            case 10867: t = t + 39; break;
+            case 11448: t = t + 92; break;
+            case 12043: t = t + 48; break;
+            case 12652: t = t + 4; break;
+            case 13275: t = t + 57; break;
+            case 13912: t = t + 13; break;
+            case 14563: t = t + 66; break;
+            case 15228: t = t + 22; break;
+            case 15907: t = t + 75; break;
+            case 16600: t = t + 31; break;
+            case 17307: t = t + 84; break;
+            case 18028: t = t + 40; break;
+            case 18763: t = t + 93; break;
+            case 19512: t = t + 49; break;
+            case 20275: t = t + 5; break;
+            case 21052: t = t + 58; break;
+            case 21843: t = t + 14; break;
+            case 22648: t = t + 67; break;
+            case 23467: t = t + 23; break;
+            case 24300: t = t + 76; break;
+            case 25147: t = t + 32; break;
+            case 26008: t = t + 85; break;
+            case 26883: t = t + 41; break;
+        default: t = 2;
+    }
+    return t;
+}
+
+int main() {
+    int n;
+    int total = 0;
+    scanf("%d", &n);
+    for (int i = 0; i < n; i = i + 1) {
+        total = (total + dense(i % 67) + sparse((i % 64) * (i % 64) * 7 - 900)) % 1000003;
+    }
+    printf("%d\n", total);
+    return 0;
+}
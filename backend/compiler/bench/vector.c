@@ -0,0 +1,25 @@
+// Element-wise array updates and a sum over global arrays: both inner
+// loops run as vector kernels with a scalar remainder of n % 16.
+int a[1000];
+int b[1000];
+int c[1000];
+
+int main() {
+    int n;
+    int total = 0;
+    scanf("%d", &n);
+    for (int i = 0; i < n; i = i + 1) {
+        b[i] = i % 97;
+        c[i] = i % 13 - 6;
+    }
+    for (int r = 0; r < 20000; r = r + 1) {
+        for (int i = 0; i < n; i = i + 1) {
+            a[i] = b[i] + c[i] * r;
+        }
+        for (int i = 0; i < n; i = i + 1) {
+            total = total + a[i];
+        }
+    }
+    printf("%d\n", total);
+    return 0;
+}
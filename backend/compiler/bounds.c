@@ -0,0 +1,467 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "bounds.h"
+
+// Every scalar in scope carries the interval of values it can hold at the
+// current point of the walk. Branches refine intervals by their condition
+// and join afterwards; loops are iterated from their entry state with
+// widening until the state at the loop head is stable. Only the final walk
+// over a loop body renames accesses, with the stable head state.
+
+#define MAX_LOOP_ROUNDS 32
+
+typedef struct {
+    long long lo;
+    long long hi;
+} Range;
+
+typedef struct {
+    char* name;
+    Range range;
+    int is_char;
+    int length;         // elements of an array, 0 for scalars
+} Fact;
+
+typedef struct {
+    Fact* facts;
+    int count;
+    int capacity;
+    int dead;           // no execution reaches this point
+} Env;
+
+static const Range full_range = { INT_MIN, INT_MAX };
+static const Range char_range = { -128, 127 };
+
+// Join of the states at the `break`s of the innermost loop or switch being
+// walked, NULL outside of them.
+static Env* break_states;
+
+static void exec_list(Env* env, ASTNode* list, int mark);
+
+static Range make_range(long long lo, long long hi) {
+    Range r = { lo, hi };
+    if (lo < INT_MIN || hi > INT_MAX) return full_range;
+    return r;
+}
+
+static Range clamp(Range r, int is_char) {
+    if (is_char && (r.lo < char_range.lo || r.hi > char_range.hi)) return char_range;
+    return r;
+}
+
+static void env_push(Env* env, char* name, Range range, int is_char, int length) {
+    if (env->count == env->capacity) {
+        env->capacity = env->capacity ? env->capacity * 2 : 16;
+        env->facts = realloc(env->facts, env->capacity * sizeof(Fact));
+    }
+    Fact* fact = &env->facts[env->count++];
+    fact->name = name;
+    fact->range = clamp(range, is_char);
+    fact->is_char = is_char;
+    fact->length = length;
+}
+
+static Fact* env_find(Env* env, char* name) {
+    for (int i = env->count - 1; i >= 0; i--) {
+        if (strcmp(env->facts[i].name, name) == 0) return &env->facts[i];
+    }
+    return NULL;
+}
+
+static void env_copy(Env* dst, Env* src) {
+    if (dst->capacity < src->count) {
+        dst->capacity = src->count;
+        dst->facts = realloc(dst->facts, dst->capacity * sizeof(Fact));
+    }
+    memcpy(dst->facts, src->facts, src->count * sizeof(Fact));
+    dst->count = src->count;
+    dst->dead = src->dead;
+}
+
+// env = env | other. Both sides have the same variables in scope.
+static void env_join(Env* env, Env* other) {
+    if (other->dead) return;
+    if (env->dead) {
+        env_copy(env, other);
+        return;
+    }
+    for (int i = 0; i < env->count && i < other->count; i++) {
+        Range* r = &env->facts[i].range;
+        if (other->facts[i].range.lo < r->lo) r->lo = other->facts[i].range.lo;
+        if (other->facts[i].range.hi > r->hi) r->hi = other->facts[i].range.hi;
+    }
+}
+
+// Bounds that moved since the last round jump to the type limits.
+static int env_widen(Env* head, Env* next) {
+    int changed = head->dead != next->dead;
+
+    if (head->dead) {
+        env_copy(head, next);
+        return changed;
+    }
+    for (int i = 0; i < head->count && !next->dead; i++) {
+        Fact* fact = &head->facts[i];
+        Range limit = fact->is_char ? char_range : full_range;
+        if (next->facts[i].range.lo < fact->range.lo) {
+            fact->range.lo = limit.lo;
+            changed = 1;
+        }
+        if (next->facts[i].range.hi > fact->range.hi) {
+            fact->range.hi = limit.hi;
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+static void env_havoc(Env* env) {
+    for (int i = 0; i < env->count; i++) {
+        env->facts[i].range = env->facts[i].is_char ? char_range : full_range;
+    }
+}
+
+static int is_element(ASTNode* node) {
+    return node_is(node, "element") || node_is(node, "unchecked-element")
+        || node_is(node, "element-assignment") || node_is(node, "unchecked-element-assignment");
+}
+
+static Range range_of(Env* env, ASTNode* expr, int mark);
+static void refine(Env* env, ASTNode* cond, int truth);
+
+// Renames an element access whose index range lies inside the array.
+static void check_access(Env* env, ASTNode* access, int mark) {
+    Range index = range_of(env, access->left, mark);
+    Fact* array = env_find(env, access->value);
+
+    if (!mark || env->dead || !array || !array->length) return;
+    if (index.lo < 0 || index.hi >= array->length) return;
+    if (strncmp(access->type, "unchecked-", 10) == 0) return;
+
+    char* renamed = malloc(strlen(access->type) + 11);
+    sprintf(renamed, "unchecked-%s", access->type);
+    free(access->type);
+    access->type = renamed;
+}
+
+static Range arithmetic(const char* op, Range a, Range b) {
+    long long candidates[4];
+
+    if (strcmp(op, "+") == 0) return make_range(a.lo + b.lo, a.hi + b.hi);
+    if (strcmp(op, "-") == 0) return make_range(a.lo - b.hi, a.hi - b.lo);
+    if (strcmp(op, "*") == 0) {
+        candidates[0] = a.lo * b.lo;
+        candidates[1] = a.lo * b.hi;
+        candidates[2] = a.hi * b.lo;
+        candidates[3] = a.hi * b.hi;
+    } else if (strcmp(op, "/") == 0) {
+        if (b.lo <= 0 && b.hi >= 0) return full_range;
+        // Truncating division is monotonic in both operands while the
+        // divisor keeps its sign.
+        candidates[0] = a.lo / b.lo;
+        candidates[1] = a.lo / b.hi;
+        candidates[2] = a.hi / b.lo;
+        candidates[3] = a.hi / b.hi;
+    } else if (strcmp(op, "%") == 0) {
+        if (b.lo <= 0 && b.hi >= 0) return full_range;
+        long long m = (b.hi > 0 ? b.hi : -b.lo) - 1;
+        long long lo = a.lo >= 0 ? 0 : (a.lo > -m ? a.lo : -m);
+        long long hi = a.hi <= 0 ? 0 : (a.hi < m ? a.hi : m);
+        return make_range(lo, hi);
+    } else {
+        return make_range(0, 1);
+    }
+
+    long long lo = candidates[0], hi = candidates[0];
+    for (int i = 1; i < 4; i++) {
+        if (candidates[i] < lo) lo = candidates[i];
+        if (candidates[i] > hi) hi = candidates[i];
+    }
+    return make_range(lo, hi);
+}
+
+// Range of an expression; visits (and with mark, renames) element accesses
+// inside it. The right operand of && and || only runs under the outcome
+// of the left one, so it is visited in a refined copy of env.
+static Range range_of(Env* env, ASTNode* expr, int mark) {
+    if (!expr) return full_range;
+
+    if (node_is(expr, "number")) {
+        long long value = atoi(expr->value);
+        return make_range(value, value);
+    }
+    if (node_is(expr, "id")) {
+        Fact* fact = env_find(env, expr->value);
+        return fact && !fact->length ? fact->range : full_range;
+    }
+    if (node_is(expr, "element") || node_is(expr, "unchecked-element")) {
+        Fact* array = env_find(env, expr->value);
+        check_access(env, expr, mark);
+        return array && array->is_char ? char_range : full_range;
+    }
+    if (node_is(expr, "call") || node_is(expr, "tail-call")) {
+        for (ASTNode* arg = expr->left; arg; arg = arg->next) range_of(env, arg, mark);
+        return full_range;
+    }
+    if (node_is(expr, "&&") || node_is(expr, "||")) {
+        Env rest = { NULL, 0, 0, 0 };
+        range_of(env, expr->left, mark);
+        env_copy(&rest, env);
+        refine(&rest, expr->left, node_is(expr, "&&"));
+        range_of(&rest, expr->right, mark);
+        free(rest.facts);
+        return make_range(0, 1);
+    }
+
+    Range a = range_of(env, expr->left, mark);
+    if (!expr->right) {
+        if (node_is(expr, "neg")) return make_range(-a.hi, -a.lo);
+        return make_range(0, 1);
+    }
+    Range b = range_of(env, expr->right, mark);
+    return arithmetic(expr->type, a, b);
+}
+
+static void constrain(Env* env, ASTNode* side, const char* op, Range other) {
+    Fact* fact = node_is(side, "id") ? env_find(env, side->value) : NULL;
+    if (!fact || fact->length) return;
+
+    Range* r = &fact->range;
+    if (strcmp(op, "<") == 0 && other.hi - 1 < r->hi) r->hi = other.hi - 1;
+    else if (strcmp(op, "<=") == 0 && other.hi < r->hi) r->hi = other.hi;
+    else if (strcmp(op, ">") == 0 && other.lo + 1 > r->lo) r->lo = other.lo + 1;
+    else if (strcmp(op, ">=") == 0 && other.lo > r->lo) r->lo = other.lo;
+    else if (strcmp(op, "==") == 0) {
+        if (other.lo > r->lo) r->lo = other.lo;
+        if (other.hi < r->hi) r->hi = other.hi;
+    } else if (strcmp(op, "!=") == 0 && other.lo == other.hi) {
+        if (r->lo == other.lo) r->lo++;
+        else if (r->hi == other.lo) r->hi--;
+    }
+    if (r->lo > r->hi) env->dead = 1;
+}
+
+static const char* relations[][3] = {
+    // op, negated, mirrored
+    { "<", ">=", ">" }, { "<=", ">", ">=" }, { ">", "<=", "<" },
+    { ">=", "<", "<=" }, { "==", "!=", "==" }, { "!=", "==", "!=" },
+};
+
+// Narrows env to the states in which cond evaluates to truth.
+static void refine(Env* env, ASTNode* cond, int truth) {
+    if (env->dead) return;
+
+    if (node_is(cond, "!")) {
+        refine(env, cond->left, !truth);
+    } else if ((node_is(cond, "&&") && truth) || (node_is(cond, "||") && !truth)) {
+        refine(env, cond->left, truth);
+        refine(env, cond->right, truth);
+    } else if (node_is(cond, "&&") || node_is(cond, "||")) {
+        // Either the left operand decides, or it does not and the right one does.
+        Env other = { NULL, 0, 0, 0 };
+        env_copy(&other, env);
+        refine(env, cond->left, truth);
+        refine(&other, cond->left, !truth);
+        refine(&other, cond->right, truth);
+        env_join(env, &other);
+        free(other.facts);
+    } else if (node_is(cond, "number")) {
+        if ((atoi(cond->value) != 0) != truth) env->dead = 1;
+    } else if (node_is(cond, "id")) {
+        Range zero = { 0, 0 };
+        constrain(env, cond, truth ? "!=" : "==", zero);
+    } else if (cond && cond->right) {
+        for (int i = 0; i < 6; i++) {
+            if (!node_is(cond, relations[i][0])) continue;
+            const char* op = truth ? relations[i][0] : relations[i][1];
+            Range left = range_of(env, cond->left, 0);
+            Range right = range_of(env, cond->right, 0);
+            constrain(env, cond->left, op, right);
+            for (int j = 0; j < 6; j++) {
+                if (strcmp(relations[j][0], op) == 0) constrain(env, cond->right, relations[j][2], left);
+            }
+            break;
+        }
+    }
+}
+
+// Leaves the construct that set break_states: env becomes the join of
+// itself and the states at its breaks, with the scope it had on entry.
+static void leave_breakable(Env* env, Env* breaks, Env* outer, int count) {
+    env_join(env, breaks);
+    env->count = count;
+    break_states = outer;
+    free(breaks->facts);
+}
+
+// Iterates a loop to a stable head state, then walks the body once more
+// with mark. step (for loops) runs after the body; env ends up as the
+// state on loop exit, including the exits through break.
+static void exec_loop(Env* env, ASTNode* cond, ASTNode* body, ASTNode* step, int mark) {
+    Env head = { NULL, 0, 0, 0 };
+    Env iter = { NULL, 0, 0, 0 };
+    Env breaks = { NULL, 0, 0, 1 };
+    Env* outer = break_states;
+    int count = env->count;
+    int stable = 0;
+
+    break_states = &breaks;
+    env_copy(&head, env);
+    for (int round = 0; round < MAX_LOOP_ROUNDS && !stable; round++) {
+        env_copy(&iter, &head);
+        range_of(&iter, cond, 0);
+        refine(&iter, cond, 1);
+        exec_list(&iter, body, 0);
+        exec_list(&iter, step, 0);
+        env_join(&iter, &head);
+        stable = !env_widen(&head, &iter);
+    }
+    if (!stable) env_havoc(&head);
+
+    range_of(&head, cond, mark);
+    breaks.dead = 1;
+    env_copy(&iter, &head);
+    refine(&iter, cond, 1);
+    exec_list(&iter, body, mark);
+    exec_list(&iter, step, mark);
+
+    env_copy(env, &head);
+    refine(env, cond, 0);
+    leave_breakable(env, &breaks, outer, count);
+    free(head.facts);
+    free(iter.facts);
+}
+
+// A case is entered from the dispatch, with the selector narrowed to the
+// case value, or by falling through from the case before it.
+static void exec_switch(Env* env, ASTNode* stmt, int mark) {
+    Env dispatch = { NULL, 0, 0, 0 };
+    Env entry = { NULL, 0, 0, 0 };
+    Env breaks = { NULL, 0, 0, 1 };
+    Env* outer = break_states;
+    int count = env->count;
+    int has_default = 0;
+
+    range_of(env, stmt->left, mark);
+    env_copy(&dispatch, env);
+    env->dead = 1;
+    break_states = &breaks;
+    for (ASTNode* clause = stmt->right; clause; clause = clause->next) {
+        env_copy(&entry, &dispatch);
+        if (node_is(clause, "case")) {
+            long long value = atoi(clause->value);
+            constrain(&entry, stmt->left, "==", make_range(value, value));
+        } else {
+            has_default = 1;
+        }
+        env_join(env, &entry);
+        exec_list(env, clause->right, mark);
+        env->count = count;
+    }
+    if (!has_default) env_join(env, &dispatch);
+    leave_breakable(env, &breaks, outer, count);
+    free(dispatch.facts);
+    free(entry.facts);
+}
+
+static void exec_statement(Env* env, ASTNode* stmt, int mark) {
+    if (node_is(stmt, "declaration")) {
+        Range init = stmt->right ? range_of(env, stmt->right, mark) : full_range;
+        env_push(env, stmt->value, init, strcmp(stmt->left->value, "char") == 0, 0);
+    } else if (node_is(stmt, "array-declaration")) {
+        env_push(env, stmt->value, full_range, strcmp(stmt->left->value, "char") == 0, atoi(stmt->right->value));
+    } else if (node_is(stmt, "assignment")) {
+        Range value = range_of(env, stmt->right, mark);
+        Fact* fact = env_find(env, stmt->value);
+        if (fact && !fact->length) fact->range = clamp(value, fact->is_char);
+    } else if (is_element(stmt)) {
+        check_access(env, stmt, mark);
+        range_of(env, stmt->right, mark);
+    } else if (node_is(stmt, "if")) {
+        Env taken = { NULL, 0, 0, 0 };
+        range_of(env, stmt->left, mark);
+        env_copy(&taken, env);
+        refine(&taken, stmt->left, 1);
+        exec_list(&taken, stmt->right, mark);
+        refine(env, stmt->left, 0);
+        env_join(env, &taken);
+        free(taken.facts);
+    } else if (node_is(stmt, "if-else")) {
+        Env taken = { NULL, 0, 0, 0 };
+        range_of(env, stmt->left, mark);
+        env_copy(&taken, env);
+        refine(&taken, stmt->left, 1);
+        exec_list(&taken, stmt->right->left, mark);
+        refine(env, stmt->left, 0);
+        exec_list(env, stmt->right->right, mark);
+        env_join(env, &taken);
+        free(taken.facts);
+    } else if (node_is(stmt, "while")) {
+        exec_loop(env, stmt->left, stmt->right, NULL, mark);
+    } else if (node_is(stmt, "for")) {
+        int count = env->count;
+        exec_statement(env, stmt->left->left, mark);
+        exec_loop(env, stmt->left->right, stmt->right->right, stmt->right->left, mark);
+        env->count = count;
+    } else if (node_is(stmt, "switch")) {
+        exec_switch(env, stmt, mark);
+    } else if (node_is(stmt, "break")) {
+        if (break_states) env_join(break_states, env);
+        env->dead = 1;
+    } else if (node_is(stmt, "block")) {
+        exec_list(env, stmt->right, mark);
+    } else if (node_is(stmt, "tail-loop")) {
+        // tail-jumps rebind the parameters and restart the body, so
+        // nothing declared before the loop keeps its range.
+        env_havoc(env);
+        exec_list(env, stmt->right, mark);
+    } else if (node_is(stmt, "return")) {
+        range_of(env, stmt->right, mark);
+        env->dead = 1;
+    } else if (node_is(stmt, "tail-jump")) {
+        for (ASTNode* arg = stmt->left; arg; arg = arg->next) range_of(env, arg, mark);
+        env->dead = 1;
+    } else if (node_is(stmt, "call")) {
+        range_of(env, stmt, mark);
+    } else if (node_is(stmt, "printf")) {
+        for (ASTNode* arg = stmt->left; arg; arg = arg->next) range_of(env, arg, mark);
+    } else if (node_is(stmt, "scanf")) {
+        for (ASTNode* target = stmt->left; target; target = target->next) {
+            Fact* fact = env_find(env, target->value);
+            if (target->left) range_of(env, target->left, mark);
+            else if (fact && !fact->length) fact->range = fact->is_char ? char_range : full_range;
+        }
+    }
+}
+
+// Statements of a block; its declarations go out of scope at the end.
+static void exec_list(Env* env, ASTNode* list, int mark) {
+    int count = env->count;
+    for (ASTNode* stmt = list; stmt && !env->dead; stmt = stmt->next) exec_statement(env, stmt, mark);
+    env->count = count;
+}
+
+void eliminate_bounds_checks(ASTNode* program) {
+    Env env = { NULL, 0, 0, 0 };
+
+    for (ASTNode* global = program; global; global = global->next) {
+        if (node_is(global, "array-declaration")) {
+            env_push(&env, global->value, full_range, strcmp(global->left->value, "char") == 0,
+                     atoi(global->right->value));
+        }
+    }
+    int globals = env.count;
+
+    for (ASTNode* function = program; function; function = function->next) {
+        if (!node_is(function, "function")) continue;
+        env.count = globals;
+        env.dead = 0;
+        for (ASTNode* param = function->right->left; param; param = param->next) {
+            env_push(&env, param->value, full_range, strcmp(param->left->value, "char") == 0, 0);
+        }
+        exec_list(&env, function->right->right, 1);
+    }
+    free(env.facts);
+}
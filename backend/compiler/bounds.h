@@ -0,0 +1,12 @@
+#ifndef BOUNDS_H
+#define BOUNDS_H
+
+#include "ast.h"
+
+// Interval analysis over each function body. Element accesses whose index
+// is proven to lie inside the array are renamed to "unchecked-element" /
+// "unchecked-element-assignment"; the engines drop the run-time check for
+// those. Runs before loop unrolling so the copies inherit the result.
+void eliminate_bounds_checks(ASTNode* program);
+
+#endif
@@ -0,0 +1,1400 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "bytecode.h"
+#include "switch.h"
+#include "strpool.h"
+#include "unitcache.h"
+
+const char* opcode_names[OP_COUNT] = {
+#define OPCODE_NAME(name, jump) #name,
+    OPCODES(OPCODE_NAME)
+#undef OPCODE_NAME
+};
+
+const int opcode_jump_operand[OP_COUNT] = {
+#define OPCODE_JUMP(name, jump) jump,
+    OPCODES(OPCODE_JUMP)
+#undef OPCODE_JUMP
+};
+
+const char* vector_opcode_names[V_COUNT] = {
+#define VECTOR_OPCODE_NAME(name) #name,
+    VECTOR_OPCODES(VECTOR_OPCODE_NAME)
+#undef VECTOR_OPCODE_NAME
+};
+
+typedef struct {
+    char* name;
+    int slot;           // first cell for arrays
+    int is_char;
+    int length;         // elements of an array, 0 for scalars
+    int is_global;
+} Local;
+
+typedef struct {
+    Chunk* chunk;
+    BytecodeOptions* options;
+    ASTNode* function;
+    Instr* code;
+    int count;
+    int capacity;
+    Local* vars;        // indexed by the slots from resolve_symbols
+    int vars_capacity;
+    Local* globals;     // indexed by global slot
+    int nglobals;
+    int nlocals;
+    int nlabels;
+    int tail_label;
+    int break_label;    // end of the innermost loop or switch, -1 outside
+    Format* formats;    // printf/scanf literals of this function
+    int nformats;
+    VectorKernel* kernels;
+    int nkernels;
+    const char** callees; // CALL operands index this; pooled names
+    int ncallees;
+    FILE* diagnostics;  // stderr, or a buffer for a function compiled on the pool
+    char* messages;
+    size_t messages_length;
+    int errors;
+} Compiler;
+
+static void compile_expr(Compiler* c, ASTNode* expr);
+static void compile_cond(Compiler* c, ASTNode* expr, int label, int when_true);
+static void compile_statements(Compiler* c, ASTNode* list);
+
+// Binary operators: the value-producing opcode and, for comparisons, the
+// compare-and-jump opcodes taken when the comparison holds or fails.
+typedef struct {
+    const char* name;
+    int op;
+    int jump_if_true;
+    int jump_if_false;
+} Operator;
+
+static const Operator operators[] = {
+    { "+", OP_ADD, -1, -1 },
+    { "-", OP_SUB, -1, -1 },
+    { "*", OP_MUL, -1, -1 },
+    { "/", OP_DIV, -1, -1 },
+    { "%", OP_MOD, -1, -1 },
+    { "==", OP_EQ, OP_JUMP_IF_EQ, OP_JUMP_IF_NE },
+    { "!=", OP_NE, OP_JUMP_IF_NE, OP_JUMP_IF_EQ },
+    { "<", OP_LT, OP_JUMP_IF_LT, OP_JUMP_IF_GE },
+    { ">", OP_GT, OP_JUMP_IF_GT, OP_JUMP_IF_LE },
+    { "<=", OP_LE, OP_JUMP_IF_LE, OP_JUMP_IF_GT },
+    { ">=", OP_GE, OP_JUMP_IF_GE, OP_JUMP_IF_LT },
+};
+
+static const Operator* find_operator(const char* name) {
+    for (size_t i = 0; i < sizeof(operators) / sizeof(operators[0]); i++) {
+        if (strcmp(operators[i].name, name) == 0) return &operators[i];
+    }
+    return NULL;
+}
+
+static void error(Compiler* c, const char* message, const char* name) {
+    if (node_is(c->function, "function")) {
+        fprintf(c->diagnostics, "Error: %s '%s' in function %s\n", message, name, c->function->value);
+    } else {
+        fprintf(c->diagnostics, "Error: %s '%s'\n", message, name);
+    }
+    c->errors++;
+}
+
+static void emit(Compiler* c, int op, int a, int b) {
+    if (c->count == c->capacity) {
+        c->capacity = c->capacity ? c->capacity * 2 : 64;
+        c->code = realloc(c->code, c->capacity * sizeof(Instr));
+    }
+    c->code[c->count].op = op;
+    c->code[c->count].a = a;
+    c->code[c->count].b = b;
+    c->count++;
+}
+
+static int new_label(Compiler* c) {
+    return c->nlabels++;
+}
+
+// Every declaration gets fresh frame cells, even when it reuses the slot
+// of a variable whose scope has ended.
+static Local* declare(Compiler* c, ASTNode* declaration, ASTNode* type) {
+    if (declaration->slot >= c->vars_capacity) {
+        c->vars_capacity = declaration->slot * 2 + 16;
+        c->vars = realloc(c->vars, c->vars_capacity * sizeof(Local));
+    }
+    Local* local = &c->vars[declaration->slot];
+    local->name = declaration->value;
+    local->slot = c->nlocals++;
+    local->is_char = type && strcmp(type->value, "char") == 0;
+    local->length = 0;
+    local->is_global = 0;
+    return local;
+}
+
+static int array_length(Compiler* c, ASTNode* declaration) {
+    int length = atoi(declaration->right->value);
+    if (length <= 0) error(c, "invalid size for array", declaration->value);
+    return length > 0 ? length : 1;
+}
+
+// Arrays take `length` consecutive local slots.
+static void declare_array(Compiler* c, ASTNode* declaration) {
+    Local* local = declare(c, declaration, declaration->left);
+    local->length = array_length(c, declaration);
+    c->nlocals += local->length - 1;
+}
+
+static Local* find_local(Compiler* c, ASTNode* ref) {
+    if (ref->depth < 0) return NULL;
+    return ref->depth == 0 ? &c->globals[ref->slot] : &c->vars[ref->slot];
+}
+
+static Local* lookup(Compiler* c, ASTNode* ref) {
+    Local* local = find_local(c, ref);
+    if (!local) error(c, "undeclared variable", ref->value);
+    return local;
+}
+
+static Local* lookup_scalar(Compiler* c, ASTNode* ref) {
+    Local* local = lookup(c, ref);
+    if (local && local->length) {
+        error(c, "array used as a value", ref->value);
+        return NULL;
+    }
+    return local;
+}
+
+static Local* lookup_array(Compiler* c, ASTNode* ref) {
+    Local* local = lookup(c, ref);
+    if (local && !local->length) {
+        error(c, "subscripted value is not an array", ref->value);
+        return NULL;
+    }
+    return local;
+}
+
+static int element_opcode(Local* array, int store, int unchecked) {
+    if (array->is_global) {
+        if (store) return unchecked ? OP_STORE_GLOBAL_ELEM_UNCHECKED : OP_STORE_GLOBAL_ELEM;
+        return unchecked ? OP_LOAD_GLOBAL_ELEM_UNCHECKED : OP_LOAD_GLOBAL_ELEM;
+    }
+    if (store) return unchecked ? OP_STORE_ELEM_UNCHECKED : OP_STORE_ELEM;
+    return unchecked ? OP_LOAD_ELEM_UNCHECKED : OP_LOAD_ELEM;
+}
+
+// Emits the load or store of an element whose index (and value) are on the
+// stack. The check is left out where the bounds pass proved the index in
+// range ("unchecked-" nodes) or the index is a constant in range.
+static void emit_element(Compiler* c, ASTNode* access, Local* array, int store) {
+    int unchecked = strncmp(access->type, "unchecked-", 10) == 0;
+    if (c->options->peephole && node_is(access->left, "number")) {
+        int index = atoi(access->left->value);
+        unchecked = index >= 0 && index < array->length;
+    }
+    if (store && array->is_char) emit(c, OP_TRUNC_CHAR, 0, 0);
+    emit(c, element_opcode(array, store, unchecked), array->slot, array->length);
+}
+
+static void emit_store(Compiler* c, Local* local) {
+    if (local) emit(c, local->is_char ? OP_STORE_CHAR : OP_STORE_LOCAL, local->slot, 0);
+    else emit(c, OP_POP, 0, 0);
+}
+
+static int find_function(Chunk* chunk, char* name) {
+    for (int i = 0; i < chunk->nfunctions; i++) {
+        if (strcmp(chunk->functions[i].name, name) == 0) return i;
+    }
+    return -1;
+}
+
+// Turns a STRING token (quotes and escapes included) into its characters.
+static char* unescape_literal(const char* token) {
+    size_t length = strlen(token);
+    char* text = malloc(length + 1);
+    char* out = text;
+
+    for (size_t i = 1; i + 1 < length; i++) {
+        if (token[i] != '\\' || i + 2 >= length) {
+            *out++ = token[i];
+            continue;
+        }
+        switch (token[++i]) {
+        case 'n': *out++ = '\n'; break;
+        case 't': *out++ = '\t'; break;
+        case 'r': *out++ = '\r'; break;
+        case '0': *out++ = '\0'; break;
+        default: *out++ = token[i]; break;
+        }
+    }
+    *out = '\0';
+    return text;
+}
+
+// Tokens come from the string pool, so a literal used by several
+// statements (or by the copies of an unrolled loop) is compiled once per
+// function; link_unit merges the functions' lists.
+static int add_format(Compiler* c, const char* token) {
+    for (int i = 0; i < c->nformats; i++) {
+        if (c->formats[i].literal == token) return i;
+    }
+    c->formats = realloc(c->formats, (c->nformats + 1) * sizeof(Format));
+    compile_format(unescape_literal(token), &c->formats[c->nformats]);
+    c->formats[c->nformats].literal = token;
+    return c->nformats++;
+}
+
+// Formats are checked against the call when compiled, so a bad format is
+// reported before the program runs.
+static void check_format(Compiler* c, const Format* format, int nargs, char* function) {
+    if (format->invalid >= 0) {
+        char conversion[3] = { '%', format->text[format->invalid + 1], '\0' };
+        error(c, "unsupported conversion", conversion);
+    } else if (format->conversions != nargs) {
+        error(c, "wrong number of arguments to", function);
+    }
+}
+
+// Calls name their callee through the function's own list, so a unit can
+// be linked into a program whose function table is numbered differently.
+static int add_callee(Compiler* c, const char* name) {
+    const char* pooled = intern_literal(name);
+    for (int i = 0; i < c->ncallees; i++) {
+        if (c->callees[i] == pooled) return i;
+    }
+    c->callees = realloc(c->callees, (c->ncallees + 1) * sizeof(const char*));
+    c->callees[c->ncallees] = pooled;
+    return c->ncallees++;
+}
+
+static int compile_args(Compiler* c, ASTNode* args) {
+    int nargs = 0;
+    for (; args; args = args->next) {
+        compile_expr(c, args);
+        nargs++;
+    }
+    return nargs;
+}
+
+static void compile_call(Compiler* c, ASTNode* call, int op) {
+    int nargs = compile_args(c, call->left);
+    int index = find_function(c->chunk, call->value);
+
+    if (index < 0) {
+        error(c, "call to undefined function", call->value);
+    } else if (c->chunk->functions[index].nparams != nargs) {
+        error(c, "wrong number of arguments to", call->value);
+    }
+    emit(c, op, add_callee(c, call->value), nargs);
+}
+
+static void compile_expr(Compiler* c, ASTNode* expr) {
+    if (node_is(expr, "number")) {
+        emit(c, OP_PUSH_CONST, atoi(expr->value), 0);
+    } else if (node_is(expr, "id")) {
+        Local* local = lookup_scalar(c, expr);
+        emit(c, OP_LOAD_LOCAL, local ? local->slot : 0, 0);
+    } else if (node_is(expr, "element") || node_is(expr, "unchecked-element")) {
+        Local* array = lookup_array(c, expr);
+        compile_expr(c, expr->left);
+        if (array) emit_element(c, expr, array, 0);
+    } else if (node_is(expr, "call")) {
+        compile_call(c, expr, OP_CALL);
+    } else if (node_is(expr, "tail-call")) {
+        compile_call(c, expr, OP_TAIL_CALL);
+    } else if (node_is(expr, "&&") || node_is(expr, "||")) {
+        int otherwise = new_label(c);
+        int end = new_label(c);
+        compile_cond(c, expr, otherwise, 0);
+        emit(c, OP_PUSH_CONST, 1, 0);
+        emit(c, OP_JUMP, end, 0);
+        emit(c, OP_LABEL, otherwise, 0);
+        emit(c, OP_PUSH_CONST, 0, 0);
+        emit(c, OP_LABEL, end, 0);
+    } else if (!expr->right) {
+        compile_expr(c, expr->left);
+        emit(c, node_is(expr, "!") ? OP_NOT : OP_NEG, 0, 0);
+    } else {
+        const Operator* op = find_operator(expr->type);
+        compile_expr(c, expr->left);
+        compile_expr(c, expr->right);
+        if (op) emit(c, op->op, 0, 0);
+        else error(c, "unsupported operator", expr->type);
+    }
+}
+
+// Jumps to label when expr evaluates to when_true, falls through otherwise.
+// && and || become branch chains and comparisons compare-and-jump, so a
+// condition never materialises a boolean on the stack.
+static void compile_cond(Compiler* c, ASTNode* expr, int label, int when_true) {
+    const Operator* op = expr->right ? find_operator(expr->type) : NULL;
+
+    if (node_is(expr, "&&") || node_is(expr, "||")) {
+        if (node_is(expr, "&&") != when_true) {
+            compile_cond(c, expr->left, label, when_true);
+            compile_cond(c, expr->right, label, when_true);
+        } else {
+            int skip = new_label(c);
+            compile_cond(c, expr->left, skip, !when_true);
+            compile_cond(c, expr->right, label, when_true);
+            emit(c, OP_LABEL, skip, 0);
+        }
+    } else if (node_is(expr, "!")) {
+        compile_cond(c, expr->left, label, !when_true);
+    } else if (op && op->jump_if_true >= 0) {
+        compile_expr(c, expr->left);
+        compile_expr(c, expr->right);
+        emit(c, when_true ? op->jump_if_true : op->jump_if_false, label, 0);
+    } else {
+        compile_expr(c, expr);
+        emit(c, when_true ? OP_JUMP_IF_NOT_ZERO : OP_JUMP_IF_ZERO, label, 0);
+    }
+}
+
+// ---- vector kernels -------------------------------------------------------
+
+// Registers are allocated as a stack: an operator overwrites its left
+// operand, so an expression needs as many registers as it is deep.
+typedef struct {
+    Compiler* c;
+    VectorKernel* kernel;
+    char* counter;
+    int top;
+    int capacity;
+} KernelBuilder;
+
+static void add_vector_instr(KernelBuilder* kb, int op, int dst, int x, int y, int a, int b, int length) {
+    VectorKernel* kernel = kb->kernel;
+    if (kernel->count == kb->capacity) {
+        kb->capacity = kb->capacity ? kb->capacity * 2 : 16;
+        kernel->code = realloc(kernel->code, kb->capacity * sizeof(VectorInstr));
+    }
+    VectorInstr in = { op, dst, x, y, a, b, length };
+    kernel->code[kernel->count++] = in;
+}
+
+// Pushes a register defined by op; -1 when registers run out.
+static int push_vector(KernelBuilder* kb, int op, int a, int b, int length) {
+    if (kb->top == VECTOR_MAX_REGS) return -1;
+    add_vector_instr(kb, op, kb->top, 0, 0, a, b, length);
+    if (kb->top + 1 > kb->kernel->nregs) kb->kernel->nregs = kb->top + 1;
+    return kb->top++;
+}
+
+// Index `counter`, `counter + k`, `k + counter` or `counter - k`.
+static int element_offset(ASTNode* index, char* counter, int* offset) {
+    ASTNode* var = index;
+    ASTNode* k = NULL;
+    if (node_is(index, "+") || node_is(index, "-")) {
+        var = index->left;
+        k = index->right;
+        if (node_is(index, "+") && node_is(var, "number")) {
+            var = index->right;
+            k = index->left;
+        }
+        if (!node_is(k, "number") || (node_is(index, "-") && atoi(k->value) == INT_MIN)) return 0;
+    }
+    if (!node_is(var, "id") || strcmp(var->value, counter) != 0) return 0;
+    *offset = !k ? 0 : node_is(index, "-") ? -atoi(k->value) : atoi(k->value);
+    return 1;
+}
+
+static Local* kernel_array(KernelBuilder* kb, ASTNode* access, int* offset) {
+    Local* array = find_local(kb->c, access);
+    return array && array->length && element_offset(access->left, kb->counter, offset) ? array : NULL;
+}
+
+static int vector_value(KernelBuilder* kb, ASTNode* expr) {
+    Local* local;
+    int offset;
+    int op;
+    int x;
+
+    if (node_is(expr, "number")) return push_vector(kb, V_CONST, atoi(expr->value), 0, 0);
+    if (node_is(expr, "id") && strcmp(expr->value, kb->counter) == 0) return push_vector(kb, V_COUNTER, 0, 0, 0);
+    if (node_is(expr, "id")) {
+        local = find_local(kb->c, expr);
+        return local && !local->length ? push_vector(kb, V_SPLAT, local->slot, 0, 0) : -1;
+    }
+    if (node_is(expr, "element") || node_is(expr, "unchecked-element")) {
+        if (!(local = kernel_array(kb, expr, &offset))) return -1;
+        return push_vector(kb, local->is_global ? V_LOAD_GLOBAL : V_LOAD, local->slot, offset, local->length);
+    }
+    if (node_is(expr, "neg")) {
+        if ((x = vector_value(kb, expr->left)) < 0) return -1;
+        add_vector_instr(kb, V_NEG, x, x, 0, 0, 0, 0);
+        return x;
+    }
+    op = node_is(expr, "+") ? V_ADD : node_is(expr, "-") ? V_SUB : node_is(expr, "*") ? V_MUL : -1;
+    if (op < 0 || (x = vector_value(kb, expr->left)) < 0 || vector_value(kb, expr->right) < 0) return -1;
+    add_vector_instr(kb, op, x, x, x + 1, 0, 0, 0);
+    kb->top = x + 1;
+    return x;
+}
+
+// `a[i + k] = e` or a sum `s = s + e`, `s = e + s`, `s = s - e`, the only
+// statements vectorize_loops lets into a "vector-for" body.
+static int vector_statement(KernelBuilder* kb, ASTNode* stmt, int* sum) {
+    Local* target;
+    ASTNode* value = stmt->right;
+    int offset;
+    int x;
+
+    kb->top = kb->kernel->nsums;
+    if (node_is(stmt, "assignment")) {
+        target = find_local(kb->c, stmt);
+        if (!target || target->length || target->is_char || !(node_is(value, "+") || node_is(value, "-"))) return 0;
+        int left = node_is(value->left, "id") && strcmp(value->left->value, stmt->value) == 0;
+        if ((x = vector_value(kb, left ? value->right : value->left)) < 0) return 0;
+        if (node_is(value, "-")) add_vector_instr(kb, V_NEG, x, x, 0, 0, 0, 0);
+        add_vector_instr(kb, V_SUM, (*sum)++, x, 0, target->slot, 0, 0);
+        return 1;
+    }
+    if (!(target = kernel_array(kb, stmt, &offset)) || (x = vector_value(kb, value)) < 0) return 0;
+    if (target->is_char) add_vector_instr(kb, V_TRUNC_CHAR, x, x, 0, 0, 0, 0);
+    add_vector_instr(kb, target->is_global ? V_STORE_GLOBAL : V_STORE, 0, x, 0, target->slot, offset, target->length);
+    return 1;
+}
+
+// Compiles the body of a "vector-for" loop into a kernel and returns its
+// index, or -1 if some operand does not fit (the loop then stays scalar).
+static int compile_kernel(Compiler* c, ASTNode* loop) {
+    ASTNode* cond = loop->left->right;
+    char* name = loop->right->left->value;
+    Local* counter = find_local(c, loop->right->left);
+    VectorKernel kernel;
+    KernelBuilder kb = { c, &kernel, name, 0, 0 };
+    ASTNode* bound;
+    int sum = 0;
+    int ok = 1;
+
+    memset(&kernel, 0, sizeof(kernel));
+    if (!counter || counter->length || counter->is_char) return -1;
+    if (node_is(cond->left, "id") && strcmp(cond->left->value, name) == 0) bound = cond->right;
+    else bound = cond->left;
+    kernel.counter = counter->slot;
+    kernel.inclusive = node_is(cond, "<=") || node_is(cond, ">=");
+    if (node_is(bound, "number")) {
+        kernel.limit = atoi(bound->value);
+    } else {
+        Local* limit = node_is(bound, "id") ? find_local(c, bound) : NULL;
+        if (!limit || limit->length) return -1;
+        kernel.limit = limit->slot;
+        kernel.limit_is_local = 1;
+    }
+
+    for (ASTNode* stmt = loop->right->right; stmt; stmt = stmt->next) {
+        if (node_is(stmt, "assignment")) kernel.nsums++;
+    }
+    kernel.nregs = kernel.nsums;
+    ok = kernel.nsums < VECTOR_MAX_REGS;
+    for (ASTNode* stmt = loop->right->right; ok && stmt; stmt = stmt->next) ok = vector_statement(&kb, stmt, &sum);
+    if (!ok) {
+        free(kernel.code);
+        return -1;
+    }
+
+    c->kernels = realloc(c->kernels, (c->nkernels + 1) * sizeof(VectorKernel));
+    c->kernels[c->nkernels] = kernel;
+    return c->nkernels++;
+}
+
+// ---------------------------------------------------------------------------
+
+// Binary search over plan->cases[lo..hi) on the selector in slot
+// `selector`; ranges of fewer than SWITCH_MIN_CASES cases compare in turn.
+static void compile_decision(Compiler* c, SwitchPlan* plan, int lo, int hi, int selector, int* labels, int otherwise) {
+    if (hi - lo < SWITCH_MIN_CASES) {
+        for (int i = lo; i < hi; i++) {
+            emit(c, OP_LOAD_LOCAL, selector, 0);
+            emit(c, OP_PUSH_CONST, plan->cases[i].value, 0);
+            emit(c, OP_JUMP_IF_EQ, labels[plan->cases[i].position], 0);
+        }
+        emit(c, OP_JUMP, otherwise, 0);
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    int upper = new_label(c);
+    emit(c, OP_LOAD_LOCAL, selector, 0);
+    emit(c, OP_PUSH_CONST, plan->cases[mid].value, 0);
+    emit(c, OP_JUMP_IF_GE, upper, 0);
+    compile_decision(c, plan, lo, mid, selector, labels, otherwise);
+    emit(c, OP_LABEL, upper, 0);
+    compile_decision(c, plan, mid, hi, selector, labels, otherwise);
+}
+
+// Dispatch (see switch.h for the choice of strategy), then the case bodies
+// in source order so that execution falls through from one to the next.
+static void compile_switch(Compiler* c, ASTNode* stmt) {
+    SwitchPlan plan;
+    int end = new_label(c);
+    int outer = c->break_label;
+
+    plan_switch(stmt, &plan);
+    if (plan.has_duplicate) {
+        char value[16];
+        sprintf(value, "%d", plan.duplicate);
+        error(c, "duplicate case value", value);
+    }
+    if (plan.defaults > 1) error(c, "multiple labels", "default");
+
+    int* labels = malloc((plan.clauses ? plan.clauses : 1) * sizeof(int));
+    for (int i = 0; i < plan.clauses; i++) labels[i] = new_label(c);
+    int otherwise = plan.default_position >= 0 ? labels[plan.default_position] : end;
+
+    compile_expr(c, stmt->left);
+    if (plan.strategy == SWITCH_JUMP_TABLE) {
+        int low = plan.cases[0].value;
+        int size = plan.cases[plan.count - 1].value - low + 1;
+        emit(c, OP_JUMP_TABLE, low, size);
+        for (int i = 0, next = 0; i < size; i++) {
+            int hit = next < plan.count && plan.cases[next].value == low + i;
+            emit(c, OP_TABLE_ENTRY, hit ? labels[plan.cases[next++].position] : otherwise, 0);
+        }
+        emit(c, OP_TABLE_ENTRY, otherwise, 0);
+    } else {
+        int selector = c->nlocals++;
+        emit(c, OP_STORE_LOCAL, selector, 0);
+        compile_decision(c, &plan, 0, plan.count, selector, labels, otherwise);
+    }
+
+    c->break_label = end;
+    int position = 0;
+    for (ASTNode* clause = stmt->right; clause; clause = clause->next) {
+        emit(c, OP_LABEL, labels[position++], 0);
+        compile_statements(c, clause->right);
+    }
+    c->break_label = outer;
+    emit(c, OP_LABEL, end, 0);
+    free(labels);
+    free_switch_plan(&plan);
+}
+
+static void compile_return(Compiler* c, ASTNode* value) {
+    if (value) compile_expr(c, value);
+    else emit(c, OP_PUSH_CONST, 0, 0);
+    if (strcmp(c->function->left->value, "char") == 0) emit(c, OP_TRUNC_CHAR, 0, 0);
+    emit(c, OP_RETURN, 0, 0);
+}
+
+static void compile_statement(Compiler* c, ASTNode* stmt) {
+    if (node_is(stmt, "declaration")) {
+        if (stmt->right) compile_expr(c, stmt->right);
+        Local* local = declare(c, stmt, stmt->left);
+        if (stmt->right) emit_store(c, local);
+    } else if (node_is(stmt, "array-declaration")) {
+        declare_array(c, stmt);
+    } else if (node_is(stmt, "assignment")) {
+        compile_expr(c, stmt->right);
+        emit_store(c, lookup_scalar(c, stmt));
+    } else if (node_is(stmt, "element-assignment") || node_is(stmt, "unchecked-element-assignment")) {
+        Local* array = lookup_array(c, stmt);
+        compile_expr(c, stmt->left);
+        compile_expr(c, stmt->right);
+        if (array) emit_element(c, stmt, array, 1);
+    } else if (node_is(stmt, "if")) {
+        int end = new_label(c);
+        compile_cond(c, stmt->left, end, 0);
+        compile_statements(c, stmt->right);
+        emit(c, OP_LABEL, end, 0);
+    } else if (node_is(stmt, "if-else")) {
+        int otherwise = new_label(c);
+        int end = new_label(c);
+        compile_cond(c, stmt->left, otherwise, 0);
+        compile_statements(c, stmt->right->left);
+        emit(c, OP_JUMP, end, 0);
+        emit(c, OP_LABEL, otherwise, 0);
+        compile_statements(c, stmt->right->right);
+        emit(c, OP_LABEL, end, 0);
+    } else if (node_is(stmt, "while")) {
+        int top = new_label(c);
+        int end = new_label(c);
+        int outer = c->break_label;
+        emit(c, OP_LABEL, top, 0);
+        compile_cond(c, stmt->left, end, 0);
+        c->break_label = end;
+        compile_statements(c, stmt->right);
+        c->break_label = outer;
+        emit(c, OP_JUMP, top, 0);
+        emit(c, OP_LABEL, end, 0);
+    } else if (node_is(stmt, "for") || node_is(stmt, "vector-for")) {
+        // Rotated like the IR loop: one conditional jump per iteration. A
+        // vector kernel takes whole blocks first; the loop does the rest.
+        int top = new_label(c);
+        int end = new_label(c);
+        int outer = c->break_label;
+        compile_statements(c, stmt->left->left);
+        int kernel = node_is(stmt, "vector-for") ? compile_kernel(c, stmt) : -1;
+        if (kernel >= 0) emit(c, OP_VECTOR_LOOP, kernel, 0);
+        compile_cond(c, stmt->left->right, end, 0);
+        emit(c, OP_LABEL, top, 0);
+        c->break_label = end;
+        compile_statements(c, stmt->right->right);
+        c->break_label = outer;
+        compile_statements(c, stmt->right->left);
+        compile_cond(c, stmt->left->right, top, 1);
+        emit(c, OP_LABEL, end, 0);
+    } else if (node_is(stmt, "switch")) {
+        compile_switch(c, stmt);
+    } else if (node_is(stmt, "break")) {
+        if (c->break_label < 0) error(c, "misplaced", "break");
+        emit(c, OP_JUMP, c->break_label, 0);
+    } else if (node_is(stmt, "block")) {
+        compile_statements(c, stmt->right);
+    } else if (node_is(stmt, "return")) {
+        compile_return(c, stmt->right);
+    } else if (node_is(stmt, "tail-loop")) {
+        c->tail_label = new_label(c);
+        emit(c, OP_LABEL, c->tail_label, 0);
+        compile_statements(c, stmt->right);
+    } else if (node_is(stmt, "tail-jump")) {
+        // Parameters are slots 0..n-1; all arguments are on the stack
+        // before the first one is overwritten.
+        int nargs = compile_args(c, stmt->left);
+        for (int i = nargs - 1; i >= 0; i--) emit_store(c, &c->vars[i]);
+        emit(c, OP_JUMP, c->tail_label, 0);
+    } else if (node_is(stmt, "call")) {
+        compile_call(c, stmt, OP_CALL);
+        emit(c, OP_POP, 0, 0);
+    } else if (node_is(stmt, "printf")) {
+        int nargs = compile_args(c, stmt->left);
+        int format = add_format(c, stmt->value);
+        check_format(c, &c->formats[format], nargs, stmt->type);
+        emit(c, OP_PRINTF, format, nargs);
+    } else if (node_is(stmt, "scanf")) {
+        // Targets keep their old value if the input does not match. An
+        // element's index is evaluated once into a hidden slot.
+        Local* targets[64];
+        ASTNode* nodes[64];
+        int index_slot[64];
+        int n = 0;
+        for (ASTNode* target = stmt->left; target && n < 64; target = target->next) {
+            nodes[n] = target;
+            if (target->left) {
+                targets[n] = lookup_array(c, target);
+                index_slot[n] = c->nlocals++;
+                compile_expr(c, target->left);
+                emit(c, OP_STORE_LOCAL, index_slot[n], 0);
+                emit(c, OP_LOAD_LOCAL, index_slot[n], 0);
+                if (targets[n]) emit_element(c, target, targets[n], 0);
+            } else {
+                targets[n] = lookup_scalar(c, target);
+                emit(c, OP_LOAD_LOCAL, targets[n] ? targets[n]->slot : 0, 0);
+            }
+            n++;
+        }
+        int format = add_format(c, stmt->value);
+        check_format(c, &c->formats[format], n, stmt->type);
+        emit(c, OP_SCANF, format, n);
+        while (n > 0) {
+            n--;
+            if (!nodes[n]->left) {
+                emit_store(c, targets[n]);
+                continue;
+            }
+            int value_slot = c->nlocals++;
+            emit(c, OP_STORE_LOCAL, value_slot, 0);
+            emit(c, OP_LOAD_LOCAL, index_slot[n], 0);
+            emit(c, OP_LOAD_LOCAL, value_slot, 0);
+            if (targets[n]) emit_element(c, nodes[n], targets[n], 1);
+        }
+    } else {
+        error(c, "unsupported statement", stmt->type);
+    }
+}
+
+static void compile_statements(Compiler* c, ASTNode* list) {
+    for (ASTNode* stmt = list; stmt; stmt = stmt->next) compile_statement(c, stmt);
+}
+
+// Resolves labels to positions relative to the first instruction and
+// drops the LABELs.
+static void resolve_labels(Compiler* c) {
+    int* label_pc = malloc((c->nlabels ? c->nlabels : 1) * sizeof(int));
+    int pc = 0;
+
+    for (int i = 0; i < c->count; i++) {
+        if (c->code[i].op == OP_LABEL) label_pc[c->code[i].a] = pc;
+        else pc++;
+    }
+    pc = 0;
+    for (int i = 0; i < c->count; i++) {
+        Instr in = c->code[i];
+        if (in.op == OP_LABEL) continue;
+        if (opcode_jump_operand[in.op] == 1) in.a = label_pc[in.a];
+        if (opcode_jump_operand[in.op] == 2) in.b = label_pc[in.b];
+        c->code[pc++] = in;
+    }
+    c->count = pc;
+    free(label_pc);
+}
+
+static int merge_format(Chunk* chunk, Format* format) {
+    for (int i = 0; i < chunk->nformats; i++) {
+        if (chunk->formats[i].literal == format->literal) {
+            free_format(format);
+            return i;
+        }
+    }
+    chunk->formats = realloc(chunk->formats, (chunk->nformats + 1) * sizeof(Format));
+    chunk->formats[chunk->nformats] = *format;
+    return chunk->nformats++;
+}
+
+// Appends a compiled function to the chunk and returns its entry. Jump
+// targets move by the entry, format and kernel numbers by those already in
+// the chunk, callees are looked up by name. Linking in program order gives
+// the same chunk whichever thread compiled what, or whether it came from
+// the unit cache.
+static int link_unit(Chunk* chunk, Compiler* unit) {
+    int entry = chunk->count;
+    int kernel_base = chunk->nkernels;
+    int* format_index = malloc((unit->nformats ? unit->nformats : 1) * sizeof(int));
+    int* callee_index = malloc((unit->ncallees ? unit->ncallees : 1) * sizeof(int));
+
+    for (int i = 0; i < unit->nformats; i++) format_index[i] = merge_format(chunk, &unit->formats[i]);
+    for (int i = 0; i < unit->ncallees; i++) callee_index[i] = find_function(chunk, (char*)unit->callees[i]);
+    if (unit->nkernels) {
+        chunk->kernels = realloc(chunk->kernels, (chunk->nkernels + unit->nkernels) * sizeof(VectorKernel));
+        memcpy(chunk->kernels + chunk->nkernels, unit->kernels, unit->nkernels * sizeof(VectorKernel));
+        chunk->nkernels += unit->nkernels;
+    }
+    if (chunk->count + unit->count > chunk->capacity) {
+        chunk->capacity = (chunk->count + unit->count) * 2;
+        chunk->code = realloc(chunk->code, chunk->capacity * sizeof(Instr));
+    }
+    for (int i = 0; i < unit->count; i++) {
+        Instr in = unit->code[i];
+        if (opcode_jump_operand[in.op] == 1) in.a += entry;
+        if (opcode_jump_operand[in.op] == 2) in.b += entry;
+        if (in.op == OP_PRINTF || in.op == OP_SCANF) in.a = format_index[in.a];
+        if (in.op == OP_VECTOR_LOOP) in.a += kernel_base;
+        if (in.op == OP_CALL || in.op == OP_TAIL_CALL) in.a = callee_index[in.a];
+        chunk->code[chunk->count++] = in;
+    }
+    free(format_index);
+    free(callee_index);
+    free(unit->callees);
+    free(unit->formats);
+    free(unit->kernels);
+    free(unit->code);
+    return entry;
+}
+
+static void compile_function(Compiler* c, ASTNode* function) {
+    c->function = function;
+    c->count = 0;
+    c->nlocals = 0;
+    c->nlabels = 0;
+    c->tail_label = -1;
+    c->break_label = -1;
+
+    for (ASTNode* param = function->right->left; param; param = param->next) {
+        Local* local = declare(c, param, param->left);
+        if (local->is_char) {
+            emit(c, OP_LOAD_LOCAL, local->slot, 0);
+            emit(c, OP_STORE_CHAR, local->slot, 0);
+        }
+    }
+    compile_statements(c, function->right->right);
+    compile_return(c, NULL);
+
+    if (c->options->peephole) c->count = peephole_optimize(c->code, c->count);
+    if (c->options->superinstructions) c->count = fuse_superinstructions(c->code, c->count);
+    resolve_labels(c);
+}
+
+// ---- unit cache ---------------------------------------------------------------
+
+// Bump when the bytecode or the layout below changes.
+#define UNIT_FORMAT_VERSION 1
+
+// Identifies the build; the Makefile passes a checksum of the sources.
+// Keys include it, so a cache directory shared between builds never hands
+// one the code another generated.
+#ifndef MINICC_BUILD_ID
+#define MINICC_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+typedef struct {
+    char* data;
+    size_t length;
+    size_t capacity;
+} Buffer;
+
+typedef struct {
+    const char* data;
+    size_t left;
+    int ok;
+} Reader;
+
+static void put(Buffer* out, const void* data, size_t size) {
+    if (out->length + size > out->capacity) {
+        out->capacity = (out->length + size) * 2;
+        out->data = realloc(out->data, out->capacity);
+    }
+    memcpy(out->data + out->length, data, size);
+    out->length += size;
+}
+
+static void put_int(Buffer* out, int value) {
+    put(out, &value, sizeof(value));
+}
+
+static void put_string(Buffer* out, const char* text) {
+    put_int(out, strlen(text));
+    put(out, text, strlen(text));
+}
+
+static void get(Reader* in, void* data, size_t size) {
+    if (!in->ok || in->left < size) {
+        in->ok = 0;
+        memset(data, 0, size);
+        return;
+    }
+    memcpy(data, in->data, size);
+    in->data += size;
+    in->left -= size;
+}
+
+static int get_int(Reader* in) {
+    int value;
+    get(in, &value, sizeof(value));
+    return value;
+}
+
+// Returns a pooled copy, NULL on a short or corrupt entry.
+static const char* get_string(Reader* in) {
+    int length = get_int(in);
+    if (!in->ok || length < 0 || (size_t)length > in->left) {
+        in->ok = 0;
+        return NULL;
+    }
+    char* text = malloc(length + 1);
+    get(in, text, length);
+    text[length] = '\0';
+    const char* pooled = intern_literal(text);
+    free(text);
+    return pooled;
+}
+
+// A unit as it is linked: code with relative targets, formats by their
+// literal, kernels, callees by name. Only units without errors are saved.
+static void save_unit(Compiler* c, Buffer* out) {
+    put_int(out, UNIT_FORMAT_VERSION);
+    put_int(out, c->nlocals);
+    put_int(out, c->count);
+    put(out, c->code, c->count * sizeof(Instr));
+    put_int(out, c->nformats);
+    for (int i = 0; i < c->nformats; i++) put_string(out, c->formats[i].literal);
+    put_int(out, c->nkernels);
+    for (int i = 0; i < c->nkernels; i++) {
+        VectorKernel* kernel = &c->kernels[i];
+        int header[] = { kernel->counter, kernel->limit, kernel->limit_is_local, kernel->inclusive,
+                         kernel->nregs, kernel->nsums, kernel->count };
+        put(out, header, sizeof(header));
+        put(out, kernel->code, kernel->count * sizeof(VectorInstr));
+    }
+    put_int(out, c->ncallees);
+    for (int i = 0; i < c->ncallees; i++) put_string(out, c->callees[i]);
+}
+
+static int in_range(int value, int count) {
+    return value >= 0 && value < count;
+}
+
+// Whether cells [first, first + length) lie within count.
+static int cells_in_range(int first, int length, int count) {
+    return first >= 0 && length >= 0 && length <= count - first;
+}
+
+static int valid_kernel(VectorKernel* kernel, int nlocals, int nglobals) {
+    if (!in_range(kernel->counter, nlocals) || (kernel->limit_is_local && !in_range(kernel->limit, nlocals))) return 0;
+    if (kernel->nregs < 0 || kernel->nregs > VECTOR_MAX_REGS || kernel->nsums < 0 || kernel->nsums > kernel->nregs) {
+        return 0;
+    }
+    for (int i = 0; i < kernel->count; i++) {
+        VectorInstr* in = &kernel->code[i];
+        // run_blocks addresses all three registers whatever the op.
+        if (!in_range(in->op, V_COUNT) || !in_range(in->dst, VECTOR_MAX_REGS) || !in_range(in->x, VECTOR_MAX_REGS)
+            || !in_range(in->y, VECTOR_MAX_REGS)) {
+            return 0;
+        }
+        switch (in->op) {
+        case V_SPLAT:
+            if (!in_range(in->a, nlocals)) return 0;
+            break;
+        case V_SUM:
+            if (!in_range(in->dst, kernel->nsums) || !in_range(in->a, nlocals)) return 0;
+            break;
+        case V_LOAD:
+        case V_STORE:
+            if (!cells_in_range(in->a, in->length, nlocals)) return 0;
+            break;
+        case V_LOAD_GLOBAL:
+        case V_STORE_GLOBAL:
+            if (!cells_in_range(in->a, in->length, nglobals)) return 0;
+            break;
+        }
+    }
+    return 1;
+}
+
+// How many operands an instruction pops and pushes, as vm_run does it;
+// ends is set for those after which control does not fall through.
+static void stack_effect(Instr* in, int* pops, int* pushes, int* ends) {
+    *pops = *pushes = *ends = 0;
+    switch (in->op) {
+    case OP_PUSH_CONST:
+    case OP_LOAD_LOCAL:
+        *pushes = 1;
+        break;
+    case OP_LOAD_LOCAL2:
+        *pushes = 2;
+        break;
+    case OP_STORE_LOCAL:
+    case OP_STORE_CHAR:
+    case OP_POP:
+    case OP_JUMP_IF_ZERO:
+    case OP_JUMP_IF_NOT_ZERO:
+        *pops = 1;
+        break;
+    case OP_TRUNC_CHAR:
+    case OP_NOT:
+    case OP_NEG:
+    case OP_LOAD_ELEM:
+    case OP_LOAD_GLOBAL_ELEM:
+    case OP_LOAD_ELEM_UNCHECKED:
+    case OP_LOAD_GLOBAL_ELEM_UNCHECKED:
+    case OP_ADD_CONST:
+    case OP_SUB_CONST:
+    case OP_MUL_CONST:
+    case OP_DIV_CONST:
+    case OP_ADD_LOCAL:
+    case OP_SUB_LOCAL:
+    case OP_MUL_LOCAL:
+    case OP_STORE_LOAD_LOCAL:
+        *pops = *pushes = 1;
+        break;
+    case OP_STORE_ELEM:
+    case OP_STORE_GLOBAL_ELEM:
+    case OP_STORE_ELEM_UNCHECKED:
+    case OP_STORE_GLOBAL_ELEM_UNCHECKED:
+    case OP_JUMP_IF_EQ:
+    case OP_JUMP_IF_NE:
+    case OP_JUMP_IF_LT:
+    case OP_JUMP_IF_GT:
+    case OP_JUMP_IF_LE:
+    case OP_JUMP_IF_GE:
+        *pops = 2;
+        break;
+    case OP_ADD:
+    case OP_SUB:
+    case OP_MUL:
+    case OP_DIV:
+    case OP_MOD:
+    case OP_EQ:
+    case OP_NE:
+    case OP_LT:
+    case OP_GT:
+    case OP_LE:
+    case OP_GE:
+        *pops = 2;
+        *pushes = 1;
+        break;
+    case OP_CALL:
+        *pops = in->b;
+        *pushes = 1;
+        break;
+    case OP_PRINTF:
+        *pops = in->b;
+        break;
+    case OP_SCANF:
+        *pops = *pushes = in->b;
+        break;
+    case OP_JUMP:
+    case OP_JUMP_TABLE:
+    case OP_STORE_JUMP:
+        *pops = in->op != OP_JUMP;
+        *ends = 1;
+        break;
+    case OP_TAIL_CALL:
+        *pops = in->b;
+        *ends = 1;
+        break;
+    case OP_RETURN:
+    case OP_HALT:
+        *pops = 1;
+        *ends = 1;
+        break;
+    }
+}
+
+// Follows every path through the code: each instruction must be reached
+// with the same stack depth on all of them, never pop below the frame and
+// never go past BYTECODE_MAX_STACK.
+static int balanced_stack(Compiler* c) {
+    // Even an empty function returns.
+    if (c->count <= 0) return 0;
+    int* depth = malloc(c->count * sizeof(int));
+    int* pending = malloc(c->count * sizeof(int));
+    int npending = 0;
+    int ok = 1;
+
+    for (int i = 0; i < c->count; i++) depth[i] = -1;
+    depth[0] = 0;
+    pending[npending++] = 0;
+    while (ok && npending) {
+        int pc = pending[--npending];
+        Instr* in = &c->code[pc];
+        int pops, pushes, ends;
+        stack_effect(in, &pops, &pushes, &ends);
+        if (pops < 0 || pops > depth[pc] || depth[pc] - pops + pushes > BYTECODE_MAX_STACK) {
+            ok = 0;
+            break;
+        }
+        int after = depth[pc] - pops + pushes;
+        int next[2];
+        int nnext = 0;
+        if (!ends) next[nnext++] = pc + 1;
+        if (opcode_jump_operand[in->op] == 1 && in->op != OP_TABLE_ENTRY) next[nnext++] = in->a;
+        if (opcode_jump_operand[in->op] == 2) next[nnext++] = in->b;
+        if (in->op == OP_JUMP_TABLE) {
+            for (int j = pc + 1; ok && j <= pc + 1 + in->b; j++) {
+                int target = c->code[j].a;
+                if (depth[target] < 0) {
+                    depth[target] = after;
+                    pending[npending++] = target;
+                } else if (depth[target] != after) {
+                    ok = 0;
+                }
+            }
+        }
+        for (int i = 0; ok && i < nnext; i++) {
+            // Falling off the end would run into the next function.
+            if (next[i] >= c->count) {
+                ok = 0;
+            } else if (depth[next[i]] < 0) {
+                depth[next[i]] = after;
+                pending[npending++] = next[i];
+            } else if (depth[next[i]] != after) {
+                ok = 0;
+            }
+        }
+    }
+    free(depth);
+    free(pending);
+    return ok;
+}
+
+// A cache entry is read from disk, so it may be corrupt or written by
+// another build: every operand that the linker or the VM uses as an index
+// is checked against what it indexes, and the stack against the frame. A
+// unit that fails is a miss.
+static int valid_unit(Compiler* c) {
+    int nlocals = c->nlocals;
+    int nglobals = c->chunk->nglobals;
+
+    if (nlocals < 0) return 0;
+    for (int i = 0; i < c->count; i++) {
+        Instr* in = &c->code[i];
+        // Labels are gone once a function is assembled.
+        if (!in_range(in->op, OP_COUNT) || in->op == OP_LABEL) return 0;
+        if (opcode_jump_operand[in->op] == 1 && !in_range(in->a, c->count)) return 0;
+        if (opcode_jump_operand[in->op] == 2 && !in_range(in->b, c->count)) return 0;
+        switch (in->op) {
+        case OP_LOAD_LOCAL:
+        case OP_STORE_LOCAL:
+        case OP_STORE_CHAR:
+        case OP_ADD_LOCAL:
+        case OP_SUB_LOCAL:
+        case OP_MUL_LOCAL:
+        case OP_INC_LOCAL:
+        case OP_STORE_JUMP:
+        case OP_JUMP_IF_LOCAL_ZERO:
+            if (!in_range(in->a, nlocals)) return 0;
+            break;
+        case OP_LOAD_LOCAL2:
+        case OP_STORE_LOAD_LOCAL:
+            if (!in_range(in->a, nlocals) || !in_range(in->b, nlocals)) return 0;
+            break;
+        case OP_LOAD_ELEM:
+        case OP_STORE_ELEM:
+        case OP_LOAD_ELEM_UNCHECKED:
+        case OP_STORE_ELEM_UNCHECKED:
+            if (!cells_in_range(in->a, in->b, nlocals)) return 0;
+            break;
+        case OP_LOAD_GLOBAL_ELEM:
+        case OP_STORE_GLOBAL_ELEM:
+        case OP_LOAD_GLOBAL_ELEM_UNCHECKED:
+        case OP_STORE_GLOBAL_ELEM_UNCHECKED:
+            if (!cells_in_range(in->a, in->b, nglobals)) return 0;
+            break;
+        case OP_DIV_CONST:
+            if (in->a == 0) return 0;
+            break;
+        case OP_JUMP_TABLE:
+            // b entries and the default follow it.
+            if (in->b < 0 || in->b >= c->count - i - 1) return 0;
+            for (int j = i + 1; j <= i + 1 + in->b; j++) {
+                if (c->code[j].op != OP_TABLE_ENTRY) return 0;
+            }
+            break;
+        case OP_CALL:
+        case OP_TAIL_CALL: {
+            if (!in_range(in->a, c->ncallees)) return 0;
+            int callee = find_function(c->chunk, (char*)c->callees[in->a]);
+            if (callee < 0 || c->chunk->functions[callee].nparams != in->b) return 0;
+            break;
+        }
+        case OP_PRINTF:
+        case OP_SCANF:
+            if (!in_range(in->a, c->nformats) || c->formats[in->a].invalid >= 0
+                || c->formats[in->a].conversions != in->b) {
+                return 0;
+            }
+            break;
+        case OP_VECTOR_LOOP:
+            if (!in_range(in->a, c->nkernels)) return 0;
+            break;
+        }
+    }
+    for (int i = 0; i < c->nkernels; i++) {
+        if (!valid_kernel(&c->kernels[i], nlocals, nglobals)) return 0;
+    }
+    return balanced_stack(c);
+}
+
+static int load_unit(Compiler* c, const char* data, size_t size) {
+    Reader in = { data, size, 1 };
+    int count;
+
+    if (get_int(&in) != UNIT_FORMAT_VERSION) return 0;
+    c->nlocals = get_int(&in);
+    count = get_int(&in);
+    if (!in.ok || count < 0 || (size_t)count > in.left / sizeof(Instr)) return 0;
+    c->code = malloc((count ? count : 1) * sizeof(Instr));
+    c->count = count;
+    get(&in, c->code, count * sizeof(Instr));
+    for (int i = 0, n = get_int(&in); in.ok && i < n; i++) {
+        const char* literal = get_string(&in);
+        if (literal) add_format(c, literal);
+    }
+    for (int i = 0, n = get_int(&in); in.ok && i < n; i++) {
+        VectorKernel kernel;
+        int header[7];
+        get(&in, header, sizeof(header));
+        if (!in.ok || header[6] < 0 || (size_t)header[6] > in.left / sizeof(VectorInstr)) {
+            in.ok = 0;
+            break;
+        }
+        kernel.counter = header[0];
+        kernel.limit = header[1];
+        kernel.limit_is_local = header[2];
+        kernel.inclusive = header[3];
+        kernel.nregs = header[4];
+        kernel.nsums = header[5];
+        kernel.count = header[6];
+        kernel.code = malloc((kernel.count ? kernel.count : 1) * sizeof(VectorInstr));
+        get(&in, kernel.code, kernel.count * sizeof(VectorInstr));
+        c->kernels = realloc(c->kernels, (c->nkernels + 1) * sizeof(VectorKernel));
+        c->kernels[c->nkernels++] = kernel;
+    }
+    for (int i = 0, n = get_int(&in); in.ok && i < n; i++) {
+        const char* name = get_string(&in);
+        if (name) add_callee(c, name);
+    }
+    return in.ok && in.left == 0 && valid_unit(c);
+}
+
+// Drops whatever a failed load left behind.
+static void reset_unit(Compiler* c) {
+    for (int i = 0; i < c->nformats; i++) free_format(&c->formats[i]);
+    for (int i = 0; i < c->nkernels; i++) free(c->kernels[i].code);
+    free(c->formats);
+    free(c->kernels);
+    free(c->callees);
+    free(c->code);
+    c->formats = NULL;
+    c->kernels = NULL;
+    c->callees = NULL;
+    c->code = NULL;
+    c->nformats = c->nkernels = c->ncallees = c->count = c->capacity = 0;
+}
+
+typedef struct {
+    Compiler* shared;   // function table and globals, read-only on the pool
+    Compiler* units;    // one per function
+    ASTNode** functions;
+    TreeHash context;   // options and global arrays, part of every key
+    int cache_hits;
+} CodegenRun;
+
+// Runs on a pool thread: lowers, optimizes and assembles one function
+// into its own unit, diagnostics included.
+static void compile_unit(void* context, int task) {
+    CodegenRun* run = context;
+    Compiler* c = &run->units[task];
+
+    memset(c, 0, sizeof(Compiler));
+    c->chunk = run->shared->chunk;
+    c->options = run->shared->options;
+    c->globals = run->shared->globals;
+    c->nglobals = run->shared->nglobals;
+
+    // A function's code depends only on its (optimized, resolved) subtree,
+    // the options and the global arrays; calls are linked by name.
+    const char* directory = c->options->cache_dir;
+    TreeHash key = run->context;
+    if (directory) {
+        hash_tree(&key, run->functions[task]);
+        size_t size;
+        char* data = unit_cache_load(directory, &key, &size);
+        int loaded = data && load_unit(c, data, size);
+        free(data);
+        if (loaded) {
+            __atomic_fetch_add(&run->cache_hits, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        reset_unit(c);
+    }
+
+    c->diagnostics = open_memstream(&c->messages, &c->messages_length);
+    if (!c->diagnostics) c->diagnostics = stderr;
+    compile_function(c, run->functions[task]);
+    free(c->vars);
+    if (c->diagnostics != stderr) fclose(c->diagnostics);
+
+    if (directory && !c->errors) {
+        Buffer out = { NULL, 0, 0 };
+        save_unit(c, &out);
+        unit_cache_store(directory, &key, out.data, out.length);
+        free(out.data);
+    }
+}
+
+Chunk* bytecode_compile(ASTNode* program, BytecodeOptions* options, ThreadPool* pool) {
+    Chunk* chunk = calloc(1, sizeof(Chunk));
+    Compiler c;
+
+    memset(&c, 0, sizeof(Compiler));
+    c.chunk = chunk;
+    c.options = options;
+    c.diagnostics = stderr;
+
+    // Function table first, so calls can refer to functions defined later.
+    for (ASTNode* function = program; function; function = function->next) {
+        if (node_is(function, "function")) chunk->nfunctions++;
+    }
+    chunk->functions = calloc(chunk->nfunctions ? chunk->nfunctions : 1, sizeof(BCFunction));
+    ASTNode** functions = malloc((chunk->nfunctions ? chunk->nfunctions : 1) * sizeof(ASTNode*));
+    chunk->nfunctions = 0;
+    for (ASTNode* function = program; function; function = function->next) {
+        if (!node_is(function, "function")) continue;
+        c.function = function;
+        if (find_function(chunk, function->value) >= 0) error(&c, "redefinition of", function->value);
+        functions[chunk->nfunctions] = function;
+        BCFunction* fn = &chunk->functions[chunk->nfunctions++];
+        fn->name = function->value;
+        for (ASTNode* param = function->right->left; param; param = param->next) fn->nparams++;
+    }
+
+    // Global arrays live in their own zero-initialised area.
+    for (ASTNode* global = program; global; global = global->next) {
+        if (!node_is(global, "array-declaration")) continue;
+        c.function = global;
+        for (int i = 0; i < c.nglobals; i++) {
+            if (strcmp(c.globals[i].name, global->value) == 0) error(&c, "redefinition of", global->value);
+        }
+        c.globals = realloc(c.globals, (c.nglobals + 1) * sizeof(Local));
+        Local* array = &c.globals[c.nglobals++];
+        array->name = global->value;
+        array->slot = chunk->nglobals;
+        array->is_char = strcmp(global->left->value, "char") == 0;
+        array->length = array_length(&c, global);
+        array->is_global = 1;
+        chunk->nglobals += array->length;
+    }
+
+    chunk->main_index = find_function(chunk, "main");
+    if (chunk->main_index < 0) {
+        fprintf(stderr, "Error: no main function\n");
+        c.errors++;
+    }
+
+    // Entry stub: call main and stop with its result.
+    emit(&c, OP_CALL, add_callee(&c, "main"), 0);
+    emit(&c, OP_HALT, 0, 0);
+    link_unit(chunk, &c);
+
+    CodegenRun run = { &c, calloc(chunk->nfunctions ? chunk->nfunctions : 1, sizeof(Compiler)), functions };
+    hash_init(&run.context);
+    hash_int(&run.context, UNIT_FORMAT_VERSION);
+    hash_bytes(&run.context, MINICC_BUILD_ID, sizeof(MINICC_BUILD_ID));
+    hash_int(&run.context, options->peephole);
+    hash_int(&run.context, options->superinstructions);
+    for (ASTNode* global = program; global; global = global->next) {
+        if (node_is(global, "array-declaration")) hash_tree(&run.context, global);
+    }
+    thread_pool_run(pool, chunk->nfunctions, compile_unit, &run);
+    chunk->cached_functions = run.cache_hits;
+    for (int i = 0; i < chunk->nfunctions; i++) {
+        Compiler* unit = &run.units[i];
+        if (unit->messages_length) fputs(unit->messages, stderr);
+        free(unit->messages);
+        c.errors += unit->errors;
+        chunk->functions[i].entry = link_unit(chunk, unit);
+        chunk->functions[i].nlocals = unit->nlocals;
+    }
+
+    free(run.units);
+    free(functions);
+    free(c.vars);
+    free(c.globals);
+    if (c.errors) {
+        bytecode_free(chunk);
+        return NULL;
+    }
+    return chunk;
+}
+
+void bytecode_free(Chunk* chunk) {
+    for (int i = 0; i < chunk->nformats; i++) free_format(&chunk->formats[i]);
+    free(chunk->formats);
+    for (int i = 0; i < chunk->nkernels; i++) free(chunk->kernels[i].code);
+    free(chunk->kernels);
+    free(chunk->functions);
+    free(chunk->code);
+    free(chunk);
+}
+
+void bytecode_disassemble(Chunk* chunk, FILE* out) {
+    for (int pc = 0; pc < chunk->count; pc++) {
+        for (int i = 0; i < chunk->nfunctions; i++) {
+            if (chunk->functions[i].entry == pc) {
+                fprintf(out, "%s: (%d params, %d locals)\n", chunk->functions[i].name,
+                        chunk->functions[i].nparams, chunk->functions[i].nlocals);
+            }
+        }
+        Instr* in = &chunk->code[pc];
+        fprintf(out, "%6d  %-20s %d %d", pc, opcode_names[in->op], in->a, in->b);
+        if (in->op == OP_PRINTF || in->op == OP_SCANF) {
+            fputs("    ", out);
+            print_format(&chunk->formats[in->a], out);
+        }
+        fputc('\n', out);
+    }
+    for (int k = 0; k < chunk->nkernels; k++) {
+        VectorKernel* kernel = &chunk->kernels[k];
+        fprintf(out, "kernel %d: local %d %s %s%d (%d registers, %d sums)\n", k, kernel->counter,
+                kernel->inclusive ? "<=" : "<", kernel->limit_is_local ? "local " : "", kernel->limit,
+                kernel->nregs, kernel->nsums);
+        for (int i = 0; i < kernel->count; i++) {
+            VectorInstr* in = &kernel->code[i];
+            fprintf(out, "%6d  %-20s r%d r%d r%d %d %d %d\n", i, vector_opcode_names[in->op],
+                    in->dst, in->x, in->y, in->a, in->b, in->length);
+        }
+    }
+}
@@ -0,0 +1,187 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "format.h"
+#include "threadpool.h"
+
+// Stack bytecode for the interpreter. Each opcode takes up to two inline
+// operands; JUMP_OPERAND tells which one (if any) is a branch target.
+// The list drives the enum, the disassembler and the VM dispatch table.
+#define OPCODES(X) \
+    X(LABEL, 0)              /* a: label id, removed when assembling      */ \
+    X(PUSH_CONST, 0)         /* push a                                    */ \
+    X(LOAD_LOCAL, 0)         /* push local[a]                             */ \
+    X(STORE_LOCAL, 0)        /* local[a] = pop                            */ \
+    X(STORE_CHAR, 0)         /* local[a] = (char)pop                      */ \
+    X(TRUNC_CHAR, 0)         /* top = (char)top                           */ \
+    X(LOAD_ELEM, 0)          /* i = pop; push local[a + i], checked i < b */ \
+    X(STORE_ELEM, 0)         /* v = pop; i = pop; local[a + i] = v, same  */ \
+    X(LOAD_GLOBAL_ELEM, 0)   /* as above on globals[]                     */ \
+    X(STORE_GLOBAL_ELEM, 0)                                                   \
+    X(LOAD_ELEM_UNCHECKED, 0) /* index proven in bounds at compile time   */ \
+    X(STORE_ELEM_UNCHECKED, 0)                                                \
+    X(LOAD_GLOBAL_ELEM_UNCHECKED, 0)                                          \
+    X(STORE_GLOBAL_ELEM_UNCHECKED, 0)                                         \
+    X(POP, 0)                                                                 \
+    X(ADD, 0)                                                                 \
+    X(SUB, 0)                                                                 \
+    X(MUL, 0)                                                                 \
+    X(DIV, 0)                                                                 \
+    X(MOD, 0)                                                                 \
+    X(EQ, 0)                 /* b = pop; a = pop; push a == b, likewise   */ \
+    X(NE, 0)                                                                  \
+    X(LT, 0)                                                                  \
+    X(GT, 0)                                                                  \
+    X(LE, 0)                                                                  \
+    X(GE, 0)                                                                  \
+    X(NOT, 0)                /* top = !top                                */ \
+    X(NEG, 0)                /* top = -top                                */ \
+    X(JUMP, 1)               /* pc = a                                    */ \
+    X(JUMP_IF_ZERO, 1)       /* if (!pop) pc = a                          */ \
+    X(JUMP_IF_NOT_ZERO, 1)   /* if (pop) pc = a                           */ \
+    X(JUMP_IF_EQ, 1)         /* b = pop; a = pop; if (a == b) pc = a      */ \
+    X(JUMP_IF_NE, 1)                                                          \
+    X(JUMP_IF_LT, 1)                                                          \
+    X(JUMP_IF_GT, 1)                                                          \
+    X(JUMP_IF_LE, 1)                                                          \
+    X(JUMP_IF_GE, 1)                                                          \
+    X(JUMP_TABLE, 0)         /* i = pop - a; go to entry i of the b       */ \
+                             /* TABLE_ENTRYs that follow, else entry b    */ \
+    X(TABLE_ENTRY, 1)        /* a: target, read by JUMP_TABLE only        */ \
+    X(CALL, 0)               /* call function a with b arguments          */ \
+    X(TAIL_CALL, 0)          /* same, reusing the current frame           */ \
+    X(RETURN, 0)             /* return pop                                */ \
+    X(PRINTF, 0)             /* printf(formats[a], b popped arguments)    */ \
+    X(SCANF, 0)              /* scanf(formats[a]) into the top b slots    */ \
+    X(VECTOR_LOOP, 0)        /* run kernels[a] over all whole blocks      */ \
+    X(HALT, 0)                                                                \
+    /* superinstructions chosen from --op-pairs over bench/, see peephole.c */ \
+    X(LOAD_LOCAL2, 0)        /* push local[a]; push local[b]              */ \
+    X(ADD_CONST, 0)          /* top += a                                  */ \
+    X(SUB_CONST, 0)          /* top -= a                                  */ \
+    X(MUL_CONST, 0)          /* top *= a                                  */ \
+    X(DIV_CONST, 0)          /* top /= a, a is not 0                      */ \
+    X(ADD_LOCAL, 0)          /* top += local[a]                           */ \
+    X(SUB_LOCAL, 0)          /* top -= local[a]                           */ \
+    X(MUL_LOCAL, 0)          /* top *= local[a]                           */ \
+    X(INC_LOCAL, 0)          /* local[a] += b                             */ \
+    X(STORE_LOAD_LOCAL, 0)   /* local[a] = pop; push local[b]             */ \
+    X(STORE_JUMP, 2)         /* local[a] = pop; pc = b                    */ \
+    X(JUMP_IF_LOCAL_ZERO, 2) /* if (!local[a]) pc = b                     */
+
+typedef enum {
+#define OPCODE_ENUM(name, jump) OP_##name,
+    OPCODES(OPCODE_ENUM)
+#undef OPCODE_ENUM
+    OP_COUNT
+} Opcode;
+
+typedef struct {
+    int op;
+    int a;
+    int b;
+} Instr;
+
+// Operand stack slots a function may use above its locals; the VM keeps
+// that much room free when it enters one.
+#define BYTECODE_MAX_STACK 256
+
+// Vector kernels execute the body of a "vector-for" loop VECTOR_BLOCK
+// iterations at a time, each operation over the whole block before the
+// next. Registers hold one int per iteration; element operands address
+// array[counter + lane + b] and are range-checked once per run.
+#define VECTOR_BLOCK 16
+#define VECTOR_MAX_REGS 16
+
+#define VECTOR_OPCODES(X) \
+    X(V_CONST)               /* r[dst] = a                                */ \
+    X(V_SPLAT)               /* r[dst] = local[a]                         */ \
+    X(V_COUNTER)             /* r[dst] = counter + lane                   */ \
+    X(V_LOAD)                /* r[dst] = local[a + counter + lane + b]    */ \
+    X(V_LOAD_GLOBAL)         /* same on globals[]                         */ \
+    X(V_STORE)               /* local[a + counter + lane + b] = r[x]      */ \
+    X(V_STORE_GLOBAL)                                                         \
+    X(V_ADD)                 /* r[dst] = r[x] + r[y], likewise            */ \
+    X(V_SUB)                                                                  \
+    X(V_MUL)                                                                  \
+    X(V_NEG)                 /* r[dst] = -r[x]                            */ \
+    X(V_TRUNC_CHAR)          /* r[dst] = (char)r[x]                       */ \
+    X(V_SUM)                 /* r[dst] += r[x]; local[a] += its lanes     */
+
+typedef enum {
+#define VECTOR_OPCODE_ENUM(name) name,
+    VECTOR_OPCODES(VECTOR_OPCODE_ENUM)
+#undef VECTOR_OPCODE_ENUM
+    V_COUNT
+} VectorOpcode;
+
+typedef struct {
+    int op;
+    int dst;
+    int x;
+    int y;
+    int a;
+    int b;
+    int length;         // elements of the array of a V_LOAD / V_STORE
+} VectorInstr;
+
+// Runs while local[counter] < limit (<= when inclusive); the limit is a
+// constant or local[limit]. Registers below nsums are V_SUM accumulators.
+typedef struct {
+    int counter;
+    int limit;
+    int limit_is_local;
+    int inclusive;
+    int nregs;
+    int nsums;
+    VectorInstr* code;
+    int count;
+} VectorKernel;
+
+typedef struct {
+    char* name;
+    int entry;
+    int nparams;
+    int nlocals;
+} BCFunction;
+
+typedef struct {
+    Instr* code;
+    int count;
+    int capacity;
+    BCFunction* functions;
+    int nfunctions;
+    Format* formats;    // printf/scanf literals, parsed once
+    int nformats;
+    int nglobals;       // int cells for global arrays, zero-initialised
+    VectorKernel* kernels;
+    int nkernels;
+    int main_index;
+    int cached_functions; // taken from the unit cache
+} Chunk;
+
+typedef struct {
+    int peephole;
+    int superinstructions;
+    const char* cache_dir; // per-function unit cache, NULL for none
+} BytecodeOptions;
+
+extern const char* opcode_names[OP_COUNT];
+extern const int opcode_jump_operand[OP_COUNT];
+extern const char* vector_opcode_names[V_COUNT];
+
+// Returns NULL (after reporting on stderr) if the program cannot be lowered.
+// Functions are compiled in parallel on the pool and linked in program
+// order, so the chunk does not depend on the number of threads.
+Chunk* bytecode_compile(ASTNode* program, BytecodeOptions* options, ThreadPool* pool);
+void bytecode_free(Chunk* chunk);
+void bytecode_disassemble(Chunk* chunk, FILE* out);
+
+// peephole.c: rewrites one function's code (still containing LABELs) in
+// place and returns the new instruction count.
+int peephole_optimize(Instr* code, int count);
+int fuse_superinstructions(Instr* code, int count);
+
+#endif
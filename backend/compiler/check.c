@@ -0,0 +1,79 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "check.h"
+#include "document.h"
+#include "json.h"
+
+static void write_nodes(FILE* out, Document* doc, int base, ASTNode* node);
+
+// Node offsets count from base, the start of the node's segment.
+static void write_node(FILE* out, Document* doc, int base, ASTNode* node) {
+    fputs("{\"type\":", out);
+    json_write_string(out, node->type, strlen(node->type));
+    if (node->offset >= 0) {
+        int line, column;
+        document_position(doc, base + node->offset, &line, &column);
+        fprintf(out, ",\"line\":%d,\"column\":%d", line + 1, column + 1);
+    }
+    if (node->value) {
+        fputs(",\"value\":", out);
+        json_write_string(out, node->value, strlen(node->value));
+    }
+    if (node->left) {
+        fputs(",\"left\":", out);
+        write_nodes(out, doc, base, node->left);
+    }
+    if (node->right) {
+        fputs(",\"right\":", out);
+        write_nodes(out, doc, base, node->right);
+    }
+    putc('}', out);
+}
+
+// A list linked through next, as an array rather than nested objects.
+static void write_nodes(FILE* out, Document* doc, int base, ASTNode* node) {
+    putc('[', out);
+    for (; node; node = node->next) {
+        write_node(out, doc, base, node);
+        if (node->next) putc(',', out);
+    }
+    putc(']', out);
+}
+
+int check_source(const char* text, int length, int with_ast, FILE* out) {
+    Document* doc = document_open(text, length);
+    Diagnostic* diagnostics = NULL;
+    int capacity = 0;
+    int count = document_diagnostics(doc, &diagnostics, &capacity);
+
+    fprintf(out, "{\"success\":%s,\"diagnostics\":[", count ? "false" : "true");
+    for (int i = 0; i < count; i++) {
+        int line, column, end_line, end_column;
+        document_position(doc, diagnostics[i].start, &line, &column);
+        document_position(doc, diagnostics[i].end, &end_line, &end_column);
+        fprintf(out, "%s{\"line\":%d,\"column\":%d,\"endLine\":%d,\"endColumn\":%d,\"severity\":\"error\",\"message\":",
+                i ? "," : "", line + 1, column + 1, end_line + 1, end_column + 1);
+        json_write_string(out, diagnostics[i].message, strlen(diagnostics[i].message));
+        putc('}', out);
+    }
+    putc(']', out);
+    if (with_ast) {
+        int first = 1;
+        fputs(",\"ast\":[", out);
+        for (int i = 0; i < doc->nsegments; i++) {
+            // A macro can make more than one external of a segment.
+            for (ASTNode* node = doc->segments[i].node; node; node = node->next) {
+                if (!first) putc(',', out);
+                first = 0;
+                write_node(out, doc, doc->segments[i].start, node);
+            }
+        }
+        putc(']', out);
+    }
+    fputs("}\n", out);
+
+    free(diagnostics);
+    document_close(doc);
+    return count;
+}
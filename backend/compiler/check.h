@@ -0,0 +1,24 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+// compiler --check: lexes and parses text, without checking or compiling
+// it, and writes the outcome as one JSON object for the editor:
+//
+//   {"success": true|false,
+//    "diagnostics": [{"line", "column", "endLine", "endColumn",
+//                     "severity": "error", "message"}, ...],
+//    "ast": [...]}
+//
+// Lines and columns count from 1, columns in bytes. The parser recovers
+// after each syntax error, and each function or global parses on its
+// own, so one mistake seldom hides another. "ast" is there only with_ast:
+// the externals that parse, each node as {"type", "value", "line",
+// "column", "left": [...], "right": [...]} with a child list in source
+// order (fields left out when empty).
+//
+// Returns the number of diagnostics.
+int check_source(const char* text, int length, int with_ast, FILE* out);
+
+#endif
@@ -0,0 +1,387 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "document.h"
+#include "preprocess.h"
+
+// Tokens of the range being re-lexed, reused across edits.
+static Token* scratch;
+static int scratch_capacity;
+static Strays scratch_strays;
+// Names of the macros an edit defines or removes.
+static const char** changed_macros;
+static int changed_capacity;
+
+typedef struct {
+    int depth;          // of braces
+    int directive;      // within one: 1, or 2 if it is a segment of its own
+} Nesting;
+
+// Segments end at the "}" closing a function, at a ";" outside any braces
+// or at the end of a directive that starts one. None can run on into the
+// next token, so the text after a segment lexes the same whether or not
+// the segment is lexed with it. opens is whether token starts a segment.
+static int ends_segment(Token* token, Nesting* nesting, int opens) {
+    if (nesting->directive) {
+        if (token->kind != NEWLINE) return 0;
+        int alone = nesting->directive == 2;
+        nesting->directive = 0;
+        return alone;
+    }
+    if (token->kind == HASH) {
+        nesting->directive = opens ? 2 : 1;
+    } else if (token->kind == LBRACE) {
+        nesting->depth++;
+    } else if (token->kind == RBRACE) {
+        if (nesting->depth > 0) nesting->depth--;
+        return nesting->depth == 0;
+    } else if (token->kind == SEMICOLON) {
+        return nesting->depth == 0;
+    }
+    return 0;
+}
+
+// Whether tokens, lexed from a range ending at length, stop exactly at the
+// end of a segment; only then can the range end there. The end of a
+// directive at the end of the range is not one: the lexer makes it up.
+static int ends_cleanly(Token* tokens, int count, int length) {
+    Nesting nesting = { 0, 0 };
+    int closed = 1;
+    for (int i = 0; i < count; i++) closed = ends_segment(&tokens[i], &nesting, closed);
+    return count > 0 && closed && tokens[count - 1].offset + tokens[count - 1].length == length &&
+           tokens[count - 1].length > 0;
+}
+
+static int count_directives(Token* tokens, int count) {
+    int directives = 0;
+    for (int i = 0; i < count; i++) directives += tokens[i].kind == HASH;
+    return directives;
+}
+
+static ASTNode* last_node(ASTNode* node) {
+    while (node->next) node = node->next;
+    return node;
+}
+
+static void parse_segment(Segment* segment) {
+    segment->node = parse_tokens(segment->tokens, segment->ntokens, &segment->errors, &segment->nerrors);
+    segment->tail = segment->node ? last_node(segment->node) : NULL;
+}
+
+// Frees the segment's tree alone, cutting off any segment that
+// document_program linked after it.
+static void free_segment_ast(Segment* segment) {
+    if (!segment->node) return;
+    segment->tail->next = NULL;
+    free_ast(segment->node);
+}
+
+// Replaces the strays in the re-lexed range [start, end) (end as it is
+// after the edit) with found, relative to start, and shifts the ones
+// after it by delta.
+static void update_strays(Strays* strays, Strays* found, int start, int end, int delta) {
+    if (strays->count == 0 && found->count == 0) return;
+    int keep = 0;
+    while (keep < strays->count && strays->offsets[keep] < start) keep++;
+    int after = keep;
+    while (after < strays->count && strays->offsets[after] < end - delta) after++;
+
+    int total = keep + found->count + strays->count - after;
+    if (total > strays->capacity) {
+        strays->capacity = total * 2;
+        strays->offsets = realloc(strays->offsets, strays->capacity * sizeof(int));
+    }
+    memmove(strays->offsets + keep + found->count, strays->offsets + after, (strays->count - after) * sizeof(int));
+    for (int i = keep + found->count; i < total; i++) strays->offsets[i] += delta;
+    for (int i = 0; i < found->count; i++) strays->offsets[keep + i] = start + found->offsets[i];
+    strays->count = total;
+}
+
+static void free_segment(Segment* segment) {
+    free_segment_ast(segment);
+    free(segment->errors);
+    free(segment->tokens);
+}
+
+// Splits tokens (offsets relative to base) into segments, not yet parsed.
+static Segment* split_segments(Token* tokens, int count, int base, int* nsegments) {
+    Segment* segments = NULL;
+    int n = 0, capacity = 0;
+    Nesting nesting = { 0, 0 };
+
+    for (int first = 0; first < count;) {
+        int last = first;
+        while (last < count - 1 && !ends_segment(&tokens[last], &nesting, last == first)) last++;
+        if (last == count - 1) nesting = (Nesting){ 0, 0 };
+        if (n == capacity) {
+            capacity = capacity ? capacity * 2 : 4;
+            segments = realloc(segments, capacity * sizeof(Segment));
+        }
+        Segment* segment = &segments[n++];
+        segment->ntokens = last - first + 1;
+        segment->tokens = malloc(segment->ntokens * sizeof(Token));
+        segment->start = base + tokens[first].offset;
+        segment->end = base + tokens[last].offset + tokens[last].length;
+        segment->node = NULL;
+        segment->tail = NULL;
+        segment->errors = NULL;
+        segment->nerrors = 0;
+        segment->directives = count_directives(tokens + first, segment->ntokens);
+        for (int i = 0; i < segment->ntokens; i++) {
+            segment->tokens[i] = tokens[first + i];
+            segment->tokens[i].offset += base - segment->start;
+        }
+        first = last + 1;
+    }
+    *nsegments = n;
+    return segments;
+}
+
+Document* document_open(const char* text, int length) {
+    Document* doc = calloc(1, sizeof(Document));
+    doc->text = calloc(1, 1);
+    doc->open_quote = -1;
+    document_edit(doc, 0, 0, text, length);
+    return doc;
+}
+
+void document_close(Document* doc) {
+    for (int i = 0; i < doc->nsegments; i++) free_segment(&doc->segments[i]);
+    free(doc->segments);
+    free(doc->strays.offsets);
+    line_table_free(&doc->lines);
+    free(doc->text);
+    free(doc);
+}
+
+int document_find_segment(Document* doc, int offset) {
+    int low = 0, high = doc->nsegments;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (doc->segments[middle].end < offset) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+int document_edit(Document* doc, int offset, int removed, const char* inserted, int inserted_length) {
+    if (offset < 0 || removed < 0 || inserted_length < 0 || offset + removed > doc->length) return -1;
+    int delta = inserted_length - removed;
+
+    if (doc->length + delta + 1 > doc->capacity) {
+        doc->capacity = (doc->length + delta + 1) * 2;
+        doc->text = realloc(doc->text, doc->capacity);
+    }
+    memmove(doc->text + offset + inserted_length, doc->text + offset + removed, doc->length - offset - removed + 1);
+    memcpy(doc->text + offset, inserted, inserted_length);
+    doc->length += delta;
+    line_table_invalidate(&doc->lines, offset);
+
+    // Segments before first end before the edit and keep their tokens.
+    // The rest is re-lexed from the end of the previous one up to the end
+    // of a segment wholly after the edit (the guard), moved further out,
+    // in growing steps, until the new tokens also end a segment there;
+    // from that point on the text lexes as it did before, shifted by delta.
+    int first = document_find_segment(doc, offset);
+    // A segment cut off by the end of the text (an unclosed function) goes
+    // on with whatever is typed after it, and an unmatched quote may now
+    // be matched.
+    if (first > 0) {
+        Segment* previous = &doc->segments[first - 1];
+        if (!ends_cleanly(previous->tokens, previous->ntokens, previous->end - previous->start)) first--;
+    }
+    if (doc->open_quote >= 0 && doc->open_quote < offset) {
+        int quoted = document_find_segment(doc, doc->open_quote);
+        if (quoted < first) first = quoted;
+    }
+    int start = first > 0 ? doc->segments[first - 1].end : 0;
+    int guard = first;
+    while (guard < doc->nsegments && doc->segments[guard].start <= offset + removed) guard++;
+
+    int count, last, end;
+    for (int step = 1;; step *= 2) {
+        end = guard < doc->nsegments ? doc->segments[guard].end + delta : doc->length;
+        count = lex_buffer(doc->text + start, end - start, &scratch, &scratch_capacity, &scratch_strays);
+        if (guard == doc->nsegments) {
+            last = guard;
+            break;
+        }
+        if (scratch_strays.open_quote < 0 && ends_cleanly(scratch, count, end - start)) {
+            last = guard + 1;
+            break;
+        }
+        guard = guard + step < doc->nsegments ? guard + step : doc->nsegments;
+    }
+
+    int nsegments;
+    Segment* segments = split_segments(scratch, count, start, &nsegments);
+
+    // Macros are as the directives before first leave them. Unless the
+    // edit adds, changes or removes a directive, they are as before.
+    int changed = 0;
+    for (int i = first; i < last; i++) {
+        if (doc->segments[i].nerrors) doc->errors--;
+        changed = preprocess_defined_names(doc->segments[i].tokens, doc->segments[i].ntokens, &changed_macros, changed,
+                                           &changed_capacity);
+    }
+    for (int i = 0; i < nsegments; i++) {
+        changed = preprocess_defined_names(segments[i].tokens, segments[i].ntokens, &changed_macros, changed,
+                                           &changed_capacity);
+    }
+    preprocess_reset();
+    for (int i = 0; i < first && doc->directives; i++) {
+        if (doc->segments[i].directives) {
+            preprocess_directives(doc->segments[i].tokens, doc->segments[i].ntokens, NULL, NULL);
+        }
+    }
+
+    // A new segment over the same text as an old one after the edit (the
+    // guard, at least) has the same tokens, so it keeps the old tree, if
+    // no macro it uses has changed.
+    for (int i = 0, j = first; i < nsegments; i++) {
+        Segment* segment = &segments[i];
+        while (j < last && doc->segments[j].start + delta < segment->start) j++;
+        Segment* old = j < last ? &doc->segments[j] : NULL;
+        if (old && old->start >= offset + removed && old->start + delta == segment->start &&
+            old->end + delta == segment->end &&
+            (!changed || !preprocess_uses_macros(segment->tokens, segment->ntokens, changed_macros, changed))) {
+            free(segment->tokens);
+            *segment = *old;
+            segment->start += delta;
+            segment->end += delta;
+            old->tokens = NULL;
+            old->node = NULL;
+            old->errors = NULL;
+            if (segment->directives) {
+                preprocess_directives(segment->tokens, segment->ntokens, NULL, NULL);
+            }
+        } else if (segment->tokens[0].kind != HASH) {
+            parse_segment(segment);
+        } else {
+            // A directive of its own; there is nothing to parse.
+            preprocess_directives(segment->tokens, segment->ntokens, &segment->errors, &segment->nerrors);
+        }
+        if (segment->nerrors) doc->errors++;
+    }
+    for (int i = first; i < last; i++) {
+        doc->directives -= doc->segments[i].directives > 0;
+        free_segment(&doc->segments[i]);
+    }
+    for (int i = 0; i < nsegments; i++) doc->directives += segments[i].directives > 0;
+
+    int total = doc->nsegments - (last - first) + nsegments;
+    if (total > doc->segment_capacity) {
+        doc->segment_capacity = total * 2;
+        doc->segments = realloc(doc->segments, doc->segment_capacity * sizeof(Segment));
+    }
+    memmove(doc->segments + first + nsegments, doc->segments + last, (doc->nsegments - last) * sizeof(Segment));
+    memcpy(doc->segments + first, segments, nsegments * sizeof(Segment));
+    doc->nsegments = total;
+    for (int i = first + nsegments; i < total; i++) {
+        doc->segments[i].start += delta;
+        doc->segments[i].end += delta;
+    }
+    free(segments);
+
+    // Later segments that use a changed macro are parsed again.
+    for (int i = first + nsegments; i < total && changed; i++) {
+        Segment* segment = &doc->segments[i];
+        if (segment->tokens[0].kind != HASH &&
+            preprocess_uses_macros(segment->tokens, segment->ntokens, changed_macros, changed)) {
+            if (segment->nerrors) doc->errors--;
+            free_segment_ast(segment);
+            free(segment->errors);
+            parse_segment(segment);
+            if (segment->nerrors) doc->errors++;
+        } else if (segment->directives) {
+            preprocess_directives(segment->tokens, segment->ntokens, NULL, NULL);
+        }
+    }
+    update_strays(&doc->strays, &scratch_strays, start, end, delta);
+    // A range with an unmatched quote runs to the end of the text; one
+    // past the range is where it was.
+    if (scratch_strays.open_quote >= 0) {
+        doc->open_quote = start + scratch_strays.open_quote;
+    } else if (doc->open_quote >= 0 && doc->open_quote + delta >= end) {
+        doc->open_quote += delta;
+    } else {
+        doc->open_quote = -1;
+    }
+    return doc->errors;
+}
+
+ASTNode* document_program(Document* doc) {
+    if (doc->errors) return NULL;
+    ASTNode* program = NULL;
+    ASTNode* last = NULL;
+    for (int i = 0; i < doc->nsegments; i++) {
+        Segment* segment = &doc->segments[i];
+        if (!segment->node) continue;
+        if (last) {
+            last->next = segment->node;
+        } else {
+            program = segment->node;
+        }
+        last = segment->tail;
+        last->next = NULL;
+    }
+    return program;
+}
+
+static Diagnostic* add_diagnostic(Diagnostic** diagnostics, int* count, int* capacity, int start, int end) {
+    if (*count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 8;
+        *diagnostics = realloc(*diagnostics, *capacity * sizeof(Diagnostic));
+    }
+    Diagnostic* diagnostic = &(*diagnostics)[(*count)++];
+    diagnostic->start = start;
+    diagnostic->end = end;
+    return diagnostic;
+}
+
+int document_diagnostics(Document* doc, Diagnostic** diagnostics, int* capacity) {
+    int count = 0;
+    int segment = 0, error = 0, stray = 0;
+
+    // Both lists are sorted; merge them.
+    for (;;) {
+        while (segment < doc->nsegments && error == doc->segments[segment].nerrors) {
+            segment++;
+            error = 0;
+        }
+        Segment* current = segment < doc->nsegments ? &doc->segments[segment] : NULL;
+        SyntaxError* syntax = current ? &current->errors[error] : NULL;
+        int at = syntax ? current->start + syntax->offset : doc->length + 1;
+        int offset = stray < doc->strays.count ? doc->strays.offsets[stray] : doc->length + 1;
+        if (!syntax && stray == doc->strays.count) break;
+
+        if (at < offset) {
+            Diagnostic* diagnostic = add_diagnostic(diagnostics, &count, capacity, at, at + syntax->length);
+            snprintf(diagnostic->message, sizeof(diagnostic->message), "%s", syntax->message);
+            error++;
+            continue;
+        }
+        Diagnostic* diagnostic = add_diagnostic(diagnostics, &count, capacity, offset, offset + 1);
+        unsigned char c = doc->text[offset];
+        if (c == '"') {
+            snprintf(diagnostic->message, sizeof(diagnostic->message), "missing terminating '\"' character");
+        } else if (c >= 0x20 && c < 0x7F) {
+            snprintf(diagnostic->message, sizeof(diagnostic->message), "stray '%c' in program", c);
+        } else {
+            snprintf(diagnostic->message, sizeof(diagnostic->message), "stray '\\%o' in program", c);
+        }
+        stray++;
+    }
+    return count;
+}
+
+void document_position(Document* doc, int offset, int* line, int* column) {
+    line_position(&doc->lines, doc->text, doc->length, offset, line, column);
+}
+
+int document_offset(Document* doc, int line, int column) {
+    return line_offset(&doc->lines, doc->text, doc->length, line, column);
+}
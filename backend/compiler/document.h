@@ -0,0 +1,106 @@
+#ifndef DOCUMENT_H
+#define DOCUMENT_H
+
+#include "ast.h"
+#include "parser.tab.h"
+#include "syntax.h"
+#include "lines.h"
+
+// A source file kept open in an editor. Its text is split into segments,
+// one per top-level function, array declaration or directive, each with
+// its own tokens and syntax tree, so an edit re-lexes and re-parses only
+// the segments it touches (usually the one enclosing function) and merely
+// shifts the offsets of the others. An edit to a directive also re-parses
+// the later segments that use the macros it changes.
+//
+// The result is always what lexing and parsing the whole text would
+// give, as long as no macro stands for braces or a ";" between functions
+// (segments are found before macros are expanded). Not thread-safe: the
+// lexer, preprocessor and parser have global state.
+
+typedef struct {
+    int kind;           // parser token number
+    int offset;         // in bytes; relative to the segment in a Document
+    int length;
+    YYSTYPE value;
+} Token;
+
+typedef struct {
+    int start;          // byte offset of the first token
+    int end;            // byte offset just past the last token
+    Token* tokens;
+    int ntokens;
+    ASTNode* node;      // NULL if the segment does not parse; node offsets
+                        // are relative to start, like the tokens'
+    ASTNode* tail;      // the last of its externals, which document_program
+                        // links on to the next segment's
+    SyntaxError* errors; // then why (offsets relative to start too)
+    int nerrors;
+    int directives;     // preprocessing directives among the tokens
+} Segment;
+
+// Characters the lexer skips because they start no token.
+typedef struct {
+    int* offsets;
+    int count;
+    int capacity;
+    int open_quote;     // the first such quote, or -1
+} Strays;
+
+typedef struct {
+    char* text;         // NUL-terminated
+    int length;
+    int capacity;
+    Segment* segments;
+    int nsegments;
+    int segment_capacity;
+    int errors;         // segments with errors
+    int directives;     // segments with directives
+    int open_quote;     // offset of the first unmatched quote, or -1
+    Strays strays;      // offsets from the start of the text
+    LineTable lines;
+} Document;
+
+typedef struct {
+    int start;          // byte offsets
+    int end;
+    char message[128];
+} Diagnostic;
+
+Document* document_open(const char* text, int length);
+void document_close(Document* doc);
+
+// Replaces removed bytes at offset with inserted. Returns the number of
+// segments with errors afterwards, or -1 if the range is invalid.
+int document_edit(Document* doc, int offset, int removed, const char* inserted, int inserted_length);
+
+// The externals as one list (linked through next), or NULL while any
+// segment has an error. The nodes belong to the document.
+ASTNode* document_program(Document* doc);
+
+// The lexical and syntax errors in source order, in *diagnostics (grown
+// as needed, like lex_buffer's tokens). Returns the count.
+int document_diagnostics(Document* doc, Diagnostic** diagnostics, int* capacity);
+
+// line_position and line_offset over the document's text.
+void document_position(Document* doc, int offset, int* line, int* column);
+int document_offset(Document* doc, int line, int column);
+
+// The segment containing offset, or the first one after it; nsegments if none.
+int document_find_segment(Document* doc, int offset);
+
+// lexer.l: lexes text[0..length) into *tokens (grown as needed) and
+// returns the token count. The characters it skips go to strays, which is
+// emptied first. An open quote makes the tokens depend on all the text
+// after it (a quote added later closes it).
+int lex_buffer(const char* text, int length, Token** tokens, int* capacity, Strays* strays);
+
+// parser.y: parses tokens as a whole program. Returns NULL on syntax
+// errors, with *errors (malloc'd) the *nerrors of them.
+ASTNode* parse_tokens(Token* tokens, int count, SyntaxError** errors, int* nerrors);
+// parser.y: parses the tokens of a whole input of length bytes the way
+// yyparse parses it from lex_string, leaving ast_root and the syntax
+// errors set; for main.c to time lexing and parsing apart.
+int parse_lexed(Token* tokens, int count, int length);
+
+#endif
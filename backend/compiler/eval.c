@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "eval.h"
+
+typedef enum { EXEC_NORMAL, EXEC_RETURN, EXEC_JUMP, EXEC_BREAK, EXEC_FAIL } ExecStatus;
+
+typedef struct {
+    int value;
+    int is_char;
+    int initialized;
+    int* elements;      // arrays only, NULL for scalars
+    int length;
+} Var;
+
+// Variables are indexed by the slot resolve_symbols gave them; the slots
+// below count are live.
+typedef struct {
+    Var vars[EVAL_MAX_VARS];
+    int count;
+    int nparams;
+    int result;
+} Frame;
+
+typedef struct {
+    ASTNode* program;
+    long steps;
+    int depth;
+} Evaluator;
+
+static int eval_expr(Evaluator* ev, Frame* frame, ASTNode* expr, int* out);
+static ExecStatus exec_list(Evaluator* ev, Frame* frame, ASTNode* list);
+static int call_function(Evaluator* ev, ASTNode* function, int* args, int nargs, int* out);
+
+static int is_char_type(ASTNode* type) {
+    return type && strcmp(type->value, "char") == 0;
+}
+
+static int store(int value, int is_char) {
+    return is_char ? (signed char)value : value;
+}
+
+// Globals (depth 0) are not modelled.
+static Var* lookup(Frame* frame, ASTNode* ref) {
+    return ref->depth > 0 && ref->slot < frame->count ? &frame->vars[ref->slot] : NULL;
+}
+
+static int declare(Frame* frame, ASTNode* declaration, int value, int is_char, int initialized) {
+    if (declaration->slot < 0 || declaration->slot >= EVAL_MAX_VARS) return 0;
+    Var* var = &frame->vars[declaration->slot];
+    frame->count = declaration->slot + 1;
+    var->is_char = is_char;
+    var->value = store(value, is_char);
+    var->initialized = initialized;
+    var->elements = NULL;
+    var->length = 0;
+    return 1;
+}
+
+static int declare_array(Frame* frame, ASTNode* declaration, int length, int is_char) {
+    if (length <= 0 || length > EVAL_MAX_ARRAY || !declare(frame, declaration, 0, is_char, 1)) return 0;
+    frame->vars[declaration->slot].elements = calloc(length, sizeof(int));
+    frame->vars[declaration->slot].length = length;
+    return 1;
+}
+
+// Leaves the variables declared since mark.
+static void pop_vars(Frame* frame, int mark) {
+    while (frame->count > mark) {
+        Var* var = &frame->vars[--frame->count];
+        free(var->elements);
+        var->elements = NULL;
+    }
+}
+
+// Address of array[index], or NULL if access is no array or index is out of bounds.
+static int* element(Frame* frame, ASTNode* access, int index) {
+    Var* var = lookup(frame, access);
+    if (!var || !var->elements || index < 0 || index >= var->length) return NULL;
+    return &var->elements[index];
+}
+
+static ASTNode* find_function(ASTNode* program, char* name) {
+    for (ASTNode* function = program; function; function = function->next) {
+        if (node_is(function, "function") && strcmp(function->value, name) == 0) return function;
+    }
+    return NULL;
+}
+
+int eval_binary(const char* op, int lhs, int rhs, int* result) {
+    unsigned a = (unsigned)lhs, b = (unsigned)rhs;
+    int division = strcmp(op, "/") == 0 || strcmp(op, "%") == 0;
+
+    if (division && (rhs == 0 || (lhs == INT_MIN && rhs == -1))) return 0;
+
+    if (strcmp(op, "+") == 0) *result = (int)(a + b);
+    else if (strcmp(op, "-") == 0) *result = (int)(a - b);
+    else if (strcmp(op, "*") == 0) *result = (int)(a * b);
+    else if (strcmp(op, "/") == 0) *result = lhs / rhs;
+    else if (strcmp(op, "%") == 0) *result = lhs % rhs;
+    else if (strcmp(op, "==") == 0) *result = lhs == rhs;
+    else if (strcmp(op, "!=") == 0) *result = lhs != rhs;
+    else if (strcmp(op, "<") == 0) *result = lhs < rhs;
+    else if (strcmp(op, ">") == 0) *result = lhs > rhs;
+    else if (strcmp(op, "<=") == 0) *result = lhs <= rhs;
+    else if (strcmp(op, ">=") == 0) *result = lhs >= rhs;
+    else if (strcmp(op, "&&") == 0) *result = lhs && rhs;
+    else if (strcmp(op, "||") == 0) *result = lhs || rhs;
+    else return 0;
+    return 1;
+}
+
+int eval_unary(const char* op, int operand, int* result) {
+    if (strcmp(op, "!") == 0) *result = !operand;
+    else if (strcmp(op, "neg") == 0) *result = (int)(0u - (unsigned)operand);
+    else return 0;
+    return 1;
+}
+
+// Evaluates an argument list into `values`; returns the count or -1.
+static int eval_args(Evaluator* ev, Frame* frame, ASTNode* args, int* values) {
+    int n = 0;
+    for (; args; args = args->next) {
+        if (n == EVAL_MAX_VARS || !eval_expr(ev, frame, args, &values[n])) return -1;
+        n++;
+    }
+    return n;
+}
+
+static int eval_expr(Evaluator* ev, Frame* frame, ASTNode* expr, int* out) {
+    if (!expr || ++ev->steps > EVAL_STEP_LIMIT) return 0;
+
+    if (node_is(expr, "number")) {
+        *out = atoi(expr->value);
+        return 1;
+    }
+    if (node_is(expr, "id")) {
+        Var* var = lookup(frame, expr);
+        if (!var || !var->initialized || var->elements) return 0;
+        *out = var->value;
+        return 1;
+    }
+    if (node_is(expr, "element") || node_is(expr, "unchecked-element")) {
+        int index;
+        int* slot;
+        if (!eval_expr(ev, frame, expr->left, &index) || !(slot = element(frame, expr, index))) return 0;
+        *out = *slot;
+        return 1;
+    }
+    if (node_is(expr, "call") || node_is(expr, "tail-call")) {
+        int args[EVAL_MAX_VARS];
+        int nargs = eval_args(ev, frame, expr->left, args);
+        ASTNode* function = find_function(ev->program, expr->value);
+        return nargs >= 0 && function && call_function(ev, function, args, nargs, out);
+    }
+
+    int lhs, rhs;
+    if (!eval_expr(ev, frame, expr->left, &lhs)) return 0;
+    if (!expr->right) return eval_unary(expr->type, lhs, out);
+    // && and || do not evaluate their right operand once the result is known.
+    if ((node_is(expr, "&&") && !lhs) || (node_is(expr, "||") && lhs)) {
+        *out = lhs != 0;
+        return 1;
+    }
+    if (!eval_expr(ev, frame, expr->right, &rhs)) return 0;
+    return eval_binary(expr->type, lhs, rhs, out);
+}
+
+static ExecStatus exec_block(Evaluator* ev, Frame* frame, ASTNode* list) {
+    int mark = frame->count;
+    ExecStatus status = exec_list(ev, frame, list);
+    pop_vars(frame, mark);
+    return status;
+}
+
+static ExecStatus exec_statement(Evaluator* ev, Frame* frame, ASTNode* stmt) {
+    int value;
+
+    if (++ev->steps > EVAL_STEP_LIMIT) return EXEC_FAIL;
+
+    if (node_is(stmt, "declaration")) {
+        value = 0;
+        if (stmt->right && !eval_expr(ev, frame, stmt->right, &value)) return EXEC_FAIL;
+        return declare(frame, stmt, value, is_char_type(stmt->left), stmt->right != NULL)
+            ? EXEC_NORMAL : EXEC_FAIL;
+    }
+    if (node_is(stmt, "array-declaration")) {
+        return declare_array(frame, stmt, atoi(stmt->right->value), is_char_type(stmt->left))
+            ? EXEC_NORMAL : EXEC_FAIL;
+    }
+    if (node_is(stmt, "element-assignment") || node_is(stmt, "unchecked-element-assignment")) {
+        Var* var = lookup(frame, stmt);
+        int index;
+        int* slot;
+        if (!var || !eval_expr(ev, frame, stmt->left, &index) || !eval_expr(ev, frame, stmt->right, &value)
+            || !(slot = element(frame, stmt, index))) {
+            return EXEC_FAIL;
+        }
+        *slot = store(value, var->is_char);
+        return EXEC_NORMAL;
+    }
+    if (node_is(stmt, "assignment")) {
+        Var* var = lookup(frame, stmt);
+        if (!var || var->elements || !eval_expr(ev, frame, stmt->right, &value)) return EXEC_FAIL;
+        var->value = store(value, var->is_char);
+        var->initialized = 1;
+        return EXEC_NORMAL;
+    }
+    if (node_is(stmt, "if")) {
+        if (!eval_expr(ev, frame, stmt->left, &value)) return EXEC_FAIL;
+        return value ? exec_block(ev, frame, stmt->right) : EXEC_NORMAL;
+    }
+    if (node_is(stmt, "if-else")) {
+        if (!eval_expr(ev, frame, stmt->left, &value)) return EXEC_FAIL;
+        return exec_block(ev, frame, value ? stmt->right->left : stmt->right->right);
+    }
+    if (node_is(stmt, "while")) {
+        for (;;) {
+            if (!eval_expr(ev, frame, stmt->left, &value)) return EXEC_FAIL;
+            if (!value) return EXEC_NORMAL;
+            ExecStatus status = exec_block(ev, frame, stmt->right);
+            if (status == EXEC_BREAK) return EXEC_NORMAL;
+            if (status != EXEC_NORMAL) return status;
+        }
+    }
+    if (node_is(stmt, "for") || node_is(stmt, "vector-for")) {
+        ASTNode* control = stmt->left;
+        int mark = frame->count;
+        ExecStatus status = exec_list(ev, frame, control->left);
+        while (status == EXEC_NORMAL) {
+            if (!eval_expr(ev, frame, control->right, &value)) status = EXEC_FAIL;
+            else if (!value) break;
+            else if ((status = exec_block(ev, frame, stmt->right->right)) == EXEC_NORMAL) {
+                status = exec_list(ev, frame, stmt->right->left);
+            }
+        }
+        pop_vars(frame, mark);
+        return status == EXEC_BREAK ? EXEC_NORMAL : status;
+    }
+    if (node_is(stmt, "switch")) {
+        ASTNode* start = NULL;
+        if (!eval_expr(ev, frame, stmt->left, &value)) return EXEC_FAIL;
+        for (ASTNode* clause = stmt->right; clause && !start; clause = clause->next) {
+            if (node_is(clause, "case") && atoi(clause->value) == value) start = clause;
+        }
+        for (ASTNode* clause = stmt->right; clause && !start; clause = clause->next) {
+            if (node_is(clause, "default")) start = clause;
+        }
+        for (ASTNode* clause = start; clause; clause = clause->next) {
+            ExecStatus status = exec_block(ev, frame, clause->right);
+            if (status == EXEC_BREAK) return EXEC_NORMAL;
+            if (status != EXEC_NORMAL) return status;
+        }
+        return EXEC_NORMAL;
+    }
+    if (node_is(stmt, "break")) {
+        return EXEC_BREAK;
+    }
+    if (node_is(stmt, "block")) {
+        return exec_block(ev, frame, stmt->right);
+    }
+    if (node_is(stmt, "return")) {
+        frame->result = 0;
+        if (stmt->right && !eval_expr(ev, frame, stmt->right, &frame->result)) return EXEC_FAIL;
+        return EXEC_RETURN;
+    }
+    if (node_is(stmt, "tail-loop")) {
+        for (;;) {
+            ExecStatus status = exec_block(ev, frame, stmt->right);
+            if (status != EXEC_JUMP) return status;
+        }
+    }
+    if (node_is(stmt, "tail-jump")) {
+        int args[EVAL_MAX_VARS];
+        if (eval_args(ev, frame, stmt->left, args) != frame->nparams) return EXEC_FAIL;
+        for (int i = 0; i < frame->nparams; i++) {
+            frame->vars[i].value = store(args[i], frame->vars[i].is_char);
+        }
+        return EXEC_JUMP;
+    }
+    if (node_is(stmt, "call")) {
+        return eval_expr(ev, frame, stmt, &value) ? EXEC_NORMAL : EXEC_FAIL;
+    }
+    return EXEC_FAIL;
+}
+
+static ExecStatus exec_list(Evaluator* ev, Frame* frame, ASTNode* list) {
+    for (ASTNode* stmt = list; stmt; stmt = stmt->next) {
+        ExecStatus status = exec_statement(ev, frame, stmt);
+        if (status != EXEC_NORMAL) return status;
+    }
+    return EXEC_NORMAL;
+}
+
+static int call_function(Evaluator* ev, ASTNode* function, int* args, int nargs, int* out) {
+    ASTNode* body = function->right;
+    Frame frame;
+    int ok = 0;
+
+    if (ev->depth == EVAL_MAX_DEPTH) return 0;
+    frame.count = 0;
+    for (ASTNode* param = body->left; param; param = param->next) {
+        if (frame.count == nargs || !declare(&frame, param, args[frame.count], is_char_type(param->left), 1)) {
+            pop_vars(&frame, 0);
+            return 0;
+        }
+    }
+    if (frame.count != nargs) return 0;
+    frame.nparams = nargs;
+
+    ev->depth++;
+    if (exec_list(ev, &frame, body->right) == EXEC_RETURN) {
+        *out = store(frame.result, is_char_type(function->left));
+        ok = 1;
+    }
+    pop_vars(&frame, 0);
+    ev->depth--;
+    return ok;
+}
+
+int eval_call(ASTNode* program, ASTNode* function, int* args, int nargs, int* result) {
+    Evaluator ev = { program, 0, 0 };
+    return call_function(&ev, function, args, nargs, result);
+}
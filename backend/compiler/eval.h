@@ -0,0 +1,22 @@
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "ast.h"
+
+// Budget for a single compile-time evaluation. Anything that runs longer,
+// recurses deeper or needs more locals or array elements is left for run time.
+#define EVAL_STEP_LIMIT 100000
+#define EVAL_MAX_DEPTH 128
+#define EVAL_MAX_VARS 64
+#define EVAL_MAX_ARRAY 4096
+
+// Applies a binary operator with the wrap-around semantics of the target.
+// Returns 0 for operations that must not be folded (division by zero, ...).
+int eval_binary(const char* op, int lhs, int rhs, int* result);
+int eval_unary(const char* op, int operand, int* result);
+
+// Runs `function` on constant arguments. Only side-effect free code is
+// modelled: returns 0 if the evaluation fails or exceeds the budget.
+int eval_call(ASTNode* program, ASTNode* function, int* args, int nargs, int* result);
+
+#endif
@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include <string.h>
+#include "format.h"
+
+static void add_op(Format* format, FormatOpKind kind, const char* text, int length) {
+    if (kind == FORMAT_TEXT && length == 0) return;
+    format->ops = realloc(format->ops, (format->count + 1) * sizeof(FormatOp));
+    format->ops[format->count].kind = kind;
+    format->ops[format->count].text = text;
+    format->ops[format->count].length = length;
+    format->count++;
+    if (kind != FORMAT_TEXT) format->conversions++;
+}
+
+void compile_format(char* text, Format* format) {
+    const char* run = text;
+    const char* p = text;
+
+    memset(format, 0, sizeof(Format));
+    format->text = text;
+    format->invalid = -1;
+    while (*p) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        if (!p[1]) {
+            if (format->invalid < 0) format->invalid = p - text;
+            p++;
+            continue;
+        }
+        add_op(format, FORMAT_TEXT, run, p - run);
+        switch (p[1]) {
+        case 'd':
+        case 'i':
+            add_op(format, FORMAT_INT, p, 2);
+            run = p + 2;
+            break;
+        case 'c':
+            add_op(format, FORMAT_CHAR, p, 2);
+            run = p + 2;
+            break;
+        case '%':
+            // The second '%' starts the next text run.
+            run = p + 1;
+            break;
+        default:
+            if (format->invalid < 0) format->invalid = p - text;
+            run = p;
+            break;
+        }
+        p += 2;
+    }
+    add_op(format, FORMAT_TEXT, run, p - run);
+}
+
+void free_format(Format* format) {
+    free(format->ops);
+    free(format->text);
+}
+
+void print_format(const Format* format, FILE* out) {
+    for (int i = 0; i < format->count; i++) {
+        const FormatOp* op = &format->ops[i];
+        if (i > 0) fputc(' ', out);
+        if (op->kind == FORMAT_INT) {
+            fputs("int", out);
+        } else if (op->kind == FORMAT_CHAR) {
+            fputs("char", out);
+        } else {
+            fputc('"', out);
+            for (int k = 0; k < op->length; k++) {
+                char ch = op->text[k];
+                if (ch == '\n') fputs("\\n", out);
+                else if (ch == '\t') fputs("\\t", out);
+                else if (ch == '\r') fputs("\\r", out);
+                else if (ch == '"' || ch == '\\') fprintf(out, "\\%c", ch);
+                else fputc(ch, out);
+            }
+            fputc('"', out);
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef FORMAT_H
+#define FORMAT_H
+
+#include <stdio.h>
+
+// A printf/scanf format literal, parsed once when the bytecode is built.
+// printf copies text runs verbatim; scanf matches them against the input
+// (whitespace matches any amount of whitespace). Each conversion consumes
+// one argument or fills one target.
+typedef enum {
+    FORMAT_TEXT,        // text[0 .. length)
+    FORMAT_INT,         // %d, %i
+    FORMAT_CHAR         // %c
+} FormatOpKind;
+
+typedef struct {
+    FormatOpKind kind;
+    int length;
+    const char* text;   // points into Format.text
+} FormatOp;
+
+typedef struct {
+    const char* literal; // the pooled token, quotes and escapes included
+    char* text;         // unescaped literal, owned
+    FormatOp* ops;
+    int count;
+    int conversions;
+    int invalid;        // offset of the first unsupported conversion, or -1
+} Format;
+
+// Takes ownership of text. "%%" becomes text. Anything else after a '%'
+// (flags, widths, other conversions, a '%' ending the literal) is left in
+// the text as well and recorded in invalid; the compiler rejects such
+// formats.
+void compile_format(char* text, Format* format);
+void free_format(Format* format);
+
+// Writes the ops as e.g. `"x = " int "\n"` for the disassembler.
+void print_format(const Format* format, FILE* out);
+
+#endif
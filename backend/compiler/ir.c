@@ -0,0 +1,546 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ir.h"
+#include "switch.h"
+
+typedef struct {
+    int vreg;           // -1 for arrays
+    int length;         // elements of an array, 0 for scalars
+} Binding;
+
+typedef struct {
+    IRFunction* fn;
+    Binding* vars;      // indexed by the slots from resolve_symbols
+    int vars_capacity;
+    Binding* globals;   // indexed by global slot
+    int vreg_capacity;
+    int tail_label;
+    int break_label;    // end of the innermost loop or switch
+} Lowering;
+
+static int lower_expr(Lowering* lw, ASTNode* expr);
+static void lower_cond(Lowering* lw, ASTNode* expr, int label, int when_true);
+static void lower_statements(Lowering* lw, ASTNode* list);
+
+static IRInstr* emit(Lowering* lw, IROp op) {
+    IRFunction* fn = lw->fn;
+    if (fn->count == fn->capacity) {
+        fn->capacity = fn->capacity ? fn->capacity * 2 : 64;
+        fn->code = realloc(fn->code, fn->capacity * sizeof(IRInstr));
+    }
+    IRInstr* instr = &fn->code[fn->count++];
+    memset(instr, 0, sizeof(IRInstr));
+    instr->op = op;
+    instr->dst = instr->a = instr->b = instr->label = -1;
+    return instr;
+}
+
+static int new_vreg(Lowering* lw, char* name) {
+    IRFunction* fn = lw->fn;
+    if (fn->nvregs == lw->vreg_capacity) {
+        lw->vreg_capacity = lw->vreg_capacity ? lw->vreg_capacity * 2 : 32;
+        fn->vreg_names = realloc(fn->vreg_names, lw->vreg_capacity * sizeof(char*));
+        fn->address_taken = realloc(fn->address_taken, lw->vreg_capacity);
+    }
+    fn->vreg_names[fn->nvregs] = name ? strdup(name) : NULL;
+    fn->address_taken[fn->nvregs] = 0;
+    return fn->nvregs++;
+}
+
+// Binding of a local slot; a slot is rebound by each declaration that
+// reuses it.
+static Binding* bind(Lowering* lw, ASTNode* declaration) {
+    if (declaration->slot >= lw->vars_capacity) {
+        lw->vars_capacity = declaration->slot * 2 + 16;
+        lw->vars = realloc(lw->vars, lw->vars_capacity * sizeof(Binding));
+    }
+    return &lw->vars[declaration->slot];
+}
+
+static int declare(Lowering* lw, ASTNode* declaration) {
+    int vreg = new_vreg(lw, declaration->value);
+    if (declaration->slot >= 0) {
+        Binding* binding = bind(lw, declaration);
+        binding->vreg = vreg;
+        binding->length = 0;
+    }
+    return vreg;
+}
+
+static void declare_array(Lowering* lw, ASTNode* declaration) {
+    if (declaration->slot < 0) return;
+    Binding* binding = declaration->depth == 0 ? &lw->globals[declaration->slot] : bind(lw, declaration);
+    binding->vreg = -1;
+    binding->length = atoi(declaration->right->value);
+}
+
+static Binding* find(Lowering* lw, ASTNode* ref) {
+    if (ref->depth < 0) return NULL;
+    return ref->depth == 0 ? &lw->globals[ref->slot] : &lw->vars[ref->slot];
+}
+
+static int lookup(Lowering* lw, ASTNode* ref) {
+    Binding* binding = find(lw, ref);
+    // Undeclared names (and arrays used as values) get a register of
+    // their own so lowering can go on.
+    return binding && binding->vreg >= 0 ? binding->vreg : new_vreg(lw, ref->value);
+}
+
+static int new_label(Lowering* lw) {
+    return lw->fn->nlabels++;
+}
+
+static void emit_label(Lowering* lw, int label) {
+    emit(lw, IR_LABEL)->label = label;
+}
+
+static void emit_jump(Lowering* lw, int label) {
+    emit(lw, IR_JUMP)->label = label;
+}
+
+// b == -1 compares a with the immediate imm.
+static void emit_cond_jump(Lowering* lw, const char* op, int a, int b, int imm, int label) {
+    IRInstr* instr = emit(lw, IR_COND_JUMP);
+    strncpy(instr->op_name, op, sizeof(instr->op_name) - 1);
+    instr->a = a;
+    instr->b = b;
+    instr->imm = imm;
+    instr->label = label;
+}
+
+static void emit_move(Lowering* lw, int dst, int a) {
+    IRInstr* instr = emit(lw, IR_MOVE);
+    instr->dst = dst;
+    instr->a = a;
+}
+
+static int lower_call(Lowering* lw, char* name, ASTNode* arg_list, int want_result) {
+    int args[64];
+    int nargs = 0;
+
+    for (ASTNode* arg = arg_list; arg && nargs < 64; arg = arg->next) {
+        args[nargs++] = lower_expr(lw, arg);
+    }
+    for (int i = 0; i < nargs; i++) {
+        IRInstr* instr = emit(lw, IR_ARG);
+        instr->a = args[i];
+        instr->imm = i;
+    }
+    int dst = want_result ? new_vreg(lw, NULL) : -1;
+    IRInstr* instr = emit(lw, IR_CALL);
+    instr->dst = dst;
+    instr->imm = nargs;
+    instr->name = name;
+    return dst;
+}
+
+// Lowers the index of an element access and checks it unless the bounds
+// pass proved it in range or it is a constant in range.
+static int lower_index(Lowering* lw, ASTNode* access) {
+    Binding* array = find(lw, access);
+    int length = array ? array->length : 0;
+    int index = lower_expr(lw, access->left);
+    int unchecked = strncmp(access->type, "unchecked-", 10) == 0;
+
+    if (node_is(access->left, "number")) {
+        unchecked = atoi(access->left->value) >= 0 && atoi(access->left->value) < length;
+    }
+    if (!unchecked) {
+        IRInstr* check = emit(lw, IR_CHECK);
+        check->a = index;
+        check->imm = length;
+    }
+    return index;
+}
+
+static int lower_expr(Lowering* lw, ASTNode* expr) {
+    if (node_is(expr, "number")) {
+        IRInstr* instr = emit(lw, IR_CONST);
+        instr->dst = new_vreg(lw, NULL);
+        instr->imm = atoi(expr->value);
+        return instr->dst;
+    }
+    if (node_is(expr, "id")) {
+        return lookup(lw, expr);
+    }
+    if (node_is(expr, "call") || node_is(expr, "tail-call")) {
+        return lower_call(lw, expr->value, expr->left, 1);
+    }
+    if (node_is(expr, "element") || node_is(expr, "unchecked-element")) {
+        int index = lower_index(lw, expr);
+        IRInstr* instr = emit(lw, IR_LOAD_ELEM);
+        instr->dst = new_vreg(lw, NULL);
+        instr->a = index;
+        instr->name = expr->value;
+        return instr->dst;
+    }
+    if (node_is(expr, "&&") || node_is(expr, "||")) {
+        // Materialise the branch chain as 0/1.
+        int dst = new_vreg(lw, NULL);
+        int end = new_label(lw);
+        IRInstr* instr = emit(lw, IR_CONST);
+        instr->dst = dst;
+        instr->imm = 0;
+        lower_cond(lw, expr, end, 0);
+        instr = emit(lw, IR_CONST);
+        instr->dst = dst;
+        instr->imm = 1;
+        emit_label(lw, end);
+        return dst;
+    }
+    if (!expr->right) {
+        int a = lower_expr(lw, expr->left);
+        IRInstr* instr = emit(lw, IR_UNARY);
+        instr->dst = new_vreg(lw, NULL);
+        instr->a = a;
+        strncpy(instr->op_name, expr->type, sizeof(instr->op_name) - 1);
+        return instr->dst;
+    }
+
+    int a = lower_expr(lw, expr->left);
+    int b = lower_expr(lw, expr->right);
+    IRInstr* instr = emit(lw, IR_BINARY);
+    instr->dst = new_vreg(lw, NULL);
+    instr->a = a;
+    instr->b = b;
+    strncpy(instr->op_name, expr->type, sizeof(instr->op_name) - 1);
+    return instr->dst;
+}
+
+static const char* relations[][2] = {
+    { "==", "!=" }, { "!=", "==" }, { "<", ">=" }, { ">=", "<" }, { ">", "<=" }, { "<=", ">" }
+};
+
+// Returns op, or its negation when negate is set; NULL if op is no relation.
+static const char* relation(const char* op, int negate) {
+    for (int i = 0; i < 6; i++) {
+        if (strcmp(relations[i][0], op) == 0) return relations[i][negate];
+    }
+    return NULL;
+}
+
+// Jumps to label when expr evaluates to when_true and falls through
+// otherwise. && and || become branch chains and comparisons become
+// compare-and-jump, so no boolean is ever materialised for a condition.
+static void lower_cond(Lowering* lw, ASTNode* expr, int label, int when_true) {
+    const char* op;
+
+    if (node_is(expr, "&&") || node_is(expr, "||")) {
+        if (node_is(expr, "&&") != when_true) {
+            lower_cond(lw, expr->left, label, when_true);
+            lower_cond(lw, expr->right, label, when_true);
+        } else {
+            int skip = new_label(lw);
+            lower_cond(lw, expr->left, skip, !when_true);
+            lower_cond(lw, expr->right, label, when_true);
+            emit_label(lw, skip);
+        }
+    } else if (node_is(expr, "!")) {
+        lower_cond(lw, expr->left, label, !when_true);
+    } else if (node_is(expr, "number")) {
+        if ((atoi(expr->value) != 0) == when_true) emit_jump(lw, label);
+    } else if (expr->right && (op = relation(expr->type, !when_true))) {
+        int a = lower_expr(lw, expr->left);
+        if (node_is(expr->right, "number")) {
+            emit_cond_jump(lw, op, a, -1, atoi(expr->right->value), label);
+        } else {
+            emit_cond_jump(lw, op, a, lower_expr(lw, expr->right), 0, label);
+        }
+    } else {
+        emit_cond_jump(lw, when_true ? "!=" : "==", lower_expr(lw, expr), -1, 0, label);
+    }
+}
+
+// Binary search over plan->cases[lo..hi) with compare chains at the
+// leaves. The IR has no indirect jump, so dense switches take this path
+// too.
+static void lower_decision(Lowering* lw, SwitchPlan* plan, int lo, int hi, int selector, int* labels, int otherwise) {
+    if (hi - lo < SWITCH_MIN_CASES) {
+        for (int i = lo; i < hi; i++) {
+            emit_cond_jump(lw, "==", selector, -1, plan->cases[i].value, labels[plan->cases[i].position]);
+        }
+        emit_jump(lw, otherwise);
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    int upper = new_label(lw);
+    emit_cond_jump(lw, ">=", selector, -1, plan->cases[mid].value, upper);
+    lower_decision(lw, plan, lo, mid, selector, labels, otherwise);
+    emit_label(lw, upper);
+    lower_decision(lw, plan, mid, hi, selector, labels, otherwise);
+}
+
+static void lower_switch(Lowering* lw, ASTNode* stmt) {
+    SwitchPlan plan;
+    int end = new_label(lw);
+    int outer = lw->break_label;
+
+    plan_switch(stmt, &plan);
+    int* labels = malloc((plan.clauses ? plan.clauses : 1) * sizeof(int));
+    for (int i = 0; i < plan.clauses; i++) labels[i] = new_label(lw);
+    lower_decision(lw, &plan, 0, plan.count, lower_expr(lw, stmt->left), labels,
+                   plan.default_position >= 0 ? labels[plan.default_position] : end);
+
+    lw->break_label = end;
+    int position = 0;
+    for (ASTNode* clause = stmt->right; clause; clause = clause->next) {
+        emit_label(lw, labels[position++]);
+        lower_statements(lw, clause->right);
+    }
+    lw->break_label = outer;
+    emit_label(lw, end);
+    free(labels);
+    free_switch_plan(&plan);
+}
+
+static void lower_statement(Lowering* lw, ASTNode* stmt) {
+    if (node_is(stmt, "array-declaration")) {
+        declare_array(lw, stmt);
+        lw->fn->array_bytes += atoi(stmt->right->value) * (strcmp(stmt->left->value, "char") == 0 ? 1 : 4);
+    } else if (node_is(stmt, "element-assignment") || node_is(stmt, "unchecked-element-assignment")) {
+        int index = lower_index(lw, stmt);
+        int value = lower_expr(lw, stmt->right);
+        IRInstr* instr = emit(lw, IR_STORE_ELEM);
+        instr->a = index;
+        instr->b = value;
+        instr->name = stmt->value;
+    } else if (node_is(stmt, "declaration")) {
+        int value = stmt->right ? lower_expr(lw, stmt->right) : -1;
+        int var = declare(lw, stmt);
+        if (value >= 0) emit_move(lw, var, value);
+    } else if (node_is(stmt, "assignment")) {
+        emit_move(lw, lookup(lw, stmt), lower_expr(lw, stmt->right));
+    } else if (node_is(stmt, "if")) {
+        int end = new_label(lw);
+        lower_cond(lw, stmt->left, end, 0);
+        lower_statements(lw, stmt->right);
+        emit_label(lw, end);
+    } else if (node_is(stmt, "if-else")) {
+        int otherwise = new_label(lw);
+        int end = new_label(lw);
+        lower_cond(lw, stmt->left, otherwise, 0);
+        lower_statements(lw, stmt->right->left);
+        emit_jump(lw, end);
+        emit_label(lw, otherwise);
+        lower_statements(lw, stmt->right->right);
+        emit_label(lw, end);
+    } else if (node_is(stmt, "while")) {
+        int top = new_label(lw);
+        int end = new_label(lw);
+        int outer = lw->break_label;
+        emit_label(lw, top);
+        lower_cond(lw, stmt->left, end, 0);
+        lw->break_label = end;
+        lower_statements(lw, stmt->right);
+        lw->break_label = outer;
+        emit_jump(lw, top);
+        emit_label(lw, end);
+    } else if (node_is(stmt, "for") || node_is(stmt, "vector-for")) {
+        // Rotated loop: the condition is tested once on entry and then at
+        // the bottom, so an iteration takes a single branch. The IR has no
+        // vector instructions; vector loops are lowered as scalar loops.
+        int top = new_label(lw);
+        int end = new_label(lw);
+        int outer = lw->break_label;
+        lower_statements(lw, stmt->left->left);
+        lower_cond(lw, stmt->left->right, end, 0);
+        emit_label(lw, top);
+        lw->break_label = end;
+        lower_statements(lw, stmt->right->right);
+        lw->break_label = outer;
+        lower_statements(lw, stmt->right->left);
+        lower_cond(lw, stmt->left->right, top, 1);
+        emit_label(lw, end);
+    } else if (node_is(stmt, "switch")) {
+        lower_switch(lw, stmt);
+    } else if (node_is(stmt, "break")) {
+        if (lw->break_label >= 0) emit_jump(lw, lw->break_label);
+    } else if (node_is(stmt, "block")) {
+        lower_statements(lw, stmt->right);
+    } else if (node_is(stmt, "return")) {
+        int value = stmt->right ? lower_expr(lw, stmt->right) : -1;
+        emit(lw, IR_RETURN)->a = value;
+    } else if (node_is(stmt, "tail-loop")) {
+        lw->tail_label = new_label(lw);
+        emit_label(lw, lw->tail_label);
+        lower_statements(lw, stmt->right);
+    } else if (node_is(stmt, "tail-jump")) {
+        // Evaluate every argument before any parameter is overwritten.
+        int args[64];
+        int nargs = 0;
+        for (ASTNode* arg = stmt->left; arg && nargs < 64; arg = arg->next) {
+            int value = lower_expr(lw, arg);
+            args[nargs] = new_vreg(lw, NULL);
+            emit_move(lw, args[nargs++], value);
+        }
+        for (int i = 0; i < nargs && i < lw->fn->nparams; i++) emit_move(lw, i, args[i]);
+        emit_jump(lw, lw->tail_label);
+    } else if (node_is(stmt, "call")) {
+        lower_call(lw, stmt->value, stmt->left, 0);
+    } else if (node_is(stmt, "printf")) {
+        lower_call(lw, stmt->type, stmt->left, 0);
+    } else if (node_is(stmt, "scanf")) {
+        for (ASTNode* target = stmt->left; target; target = target->next) {
+            if (target->left) lower_index(lw, target);
+            else lw->fn->address_taken[lookup(lw, target)] = 1;
+        }
+        IRInstr* instr = emit(lw, IR_CALL);
+        instr->imm = 0;
+        instr->name = stmt->type;
+    }
+}
+
+static void lower_statements(Lowering* lw, ASTNode* list) {
+    for (ASTNode* stmt = list; stmt; stmt = stmt->next) lower_statement(lw, stmt);
+}
+
+static void lower_function(IRFunction* fn, Binding* globals, ASTNode* function) {
+    Lowering lw = { fn, NULL, 0, globals, 0, -1, -1 };
+
+    memset(fn, 0, sizeof(IRFunction));
+    fn->name = function->value;
+    // Parameters take the first virtual registers, in order.
+    for (ASTNode* param = function->right->left; param; param = param->next) {
+        declare(&lw, param);
+        fn->nparams++;
+    }
+    lower_statements(&lw, function->right->right);
+    if (fn->count == 0 || fn->code[fn->count - 1].op != IR_RETURN) emit(&lw, IR_RETURN);
+    free(lw.vars);
+}
+
+typedef struct {
+    IRProgram* ir;
+    Binding* globals;   // shared by all functions, read-only while lowering
+    ASTNode** functions;
+} LoweringRun;
+
+static void lower_task(void* context, int task) {
+    LoweringRun* run = context;
+    lower_function(&run->ir->functions[task], run->globals, run->functions[task]);
+}
+
+IRProgram* ir_lower_program(ASTNode* program, ThreadPool* pool) {
+    IRProgram* ir = malloc(sizeof(IRProgram));
+    Lowering lw;
+    int nglobals = 0;
+
+    ir->count = 0;
+    for (ASTNode* node = program; node; node = node->next) {
+        if (node_is(node, "function")) ir->count++;
+        else if (node_is(node, "array-declaration")) nglobals++;
+    }
+    ir->functions = calloc(ir->count ? ir->count : 1, sizeof(IRFunction));
+
+    memset(&lw, 0, sizeof(Lowering));
+    lw.globals = calloc(nglobals ? nglobals : 1, sizeof(Binding));
+    for (ASTNode* global = program; global; global = global->next) {
+        if (node_is(global, "array-declaration")) declare_array(&lw, global);
+    }
+
+    // Functions lower independently, each into its own slot.
+    LoweringRun run = { ir, lw.globals, malloc((ir->count ? ir->count : 1) * sizeof(ASTNode*)) };
+    int i = 0;
+    for (ASTNode* function = program; function; function = function->next) {
+        if (node_is(function, "function")) run.functions[i++] = function;
+    }
+    thread_pool_run(pool, ir->count, lower_task, &run);
+    free(run.functions);
+    free(lw.globals);
+    return ir;
+}
+
+void ir_free_program(IRProgram* program) {
+    for (int i = 0; i < program->count; i++) {
+        IRFunction* fn = &program->functions[i];
+        for (int v = 0; v < fn->nvregs; v++) free(fn->vreg_names[v]);
+        free(fn->vreg_names);
+        free(fn->address_taken);
+        free(fn->code);
+    }
+    free(program->functions);
+    free(program);
+}
+
+static void print_vreg(IRFunction* fn, int vreg, FILE* out) {
+    if (fn->vreg_names[vreg]) fprintf(out, "%%%s.%d", fn->vreg_names[vreg], vreg);
+    else fprintf(out, "%%t%d", vreg);
+}
+
+void ir_print_function(IRFunction* fn, FILE* out) {
+    fprintf(out, "function %s(%d)\n", fn->name, fn->nparams);
+    for (int i = 0; i < fn->count; i++) {
+        IRInstr* in = &fn->code[i];
+        if (in->op == IR_LABEL) {
+            fprintf(out, "L%d:\n", in->label);
+            continue;
+        }
+        fprintf(out, "  ");
+        if (in->dst >= 0) {
+            print_vreg(fn, in->dst, out);
+            fprintf(out, " = ");
+        }
+        switch (in->op) {
+        case IR_CONST:
+            fprintf(out, "%d", in->imm);
+            break;
+        case IR_MOVE:
+            print_vreg(fn, in->a, out);
+            break;
+        case IR_BINARY:
+            print_vreg(fn, in->a, out);
+            fprintf(out, " %s ", in->op_name);
+            print_vreg(fn, in->b, out);
+            break;
+        case IR_UNARY:
+            fprintf(out, "%s ", in->op_name);
+            print_vreg(fn, in->a, out);
+            break;
+        case IR_JUMP:
+            fprintf(out, "jump L%d", in->label);
+            break;
+        case IR_COND_JUMP:
+            fprintf(out, "if ");
+            print_vreg(fn, in->a, out);
+            fprintf(out, " %s ", in->op_name);
+            if (in->b >= 0) print_vreg(fn, in->b, out);
+            else fprintf(out, "%d", in->imm);
+            fprintf(out, " jump L%d", in->label);
+            break;
+        case IR_CHECK:
+            fprintf(out, "check ");
+            print_vreg(fn, in->a, out);
+            fprintf(out, " < %d", in->imm);
+            break;
+        case IR_LOAD_ELEM:
+            fprintf(out, "%s[", in->name);
+            print_vreg(fn, in->a, out);
+            fprintf(out, "]");
+            break;
+        case IR_STORE_ELEM:
+            fprintf(out, "%s[", in->name);
+            print_vreg(fn, in->a, out);
+            fprintf(out, "] = ");
+            print_vreg(fn, in->b, out);
+            break;
+        case IR_ARG:
+            fprintf(out, "arg %d ", in->imm);
+            print_vreg(fn, in->a, out);
+            break;
+        case IR_CALL:
+            fprintf(out, "call %s/%d", in->name, in->imm);
+            break;
+        case IR_RETURN:
+            fprintf(out, "return");
+            if (in->a >= 0) {
+                fprintf(out, " ");
+                print_vreg(fn, in->a, out);
+            }
+            break;
+        default:
+            break;
+        }
+        fprintf(out, "\n");
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef IR_H
+#define IR_H
+
+#include <stdio.h>
+#include "ast.h"
+#include "threadpool.h"
+
+// Three-address IR used by the native code generator. Every variable and
+// every temporary lives in its own virtual register; variables keep the
+// same register for their whole lifetime (the IR is not SSA).
+typedef enum {
+    IR_CONST,     // dst = imm
+    IR_MOVE,      // dst = a
+    IR_BINARY,    // dst = a op b
+    IR_UNARY,     // dst = op a
+    IR_LABEL,     // label:
+    IR_JUMP,      // goto label
+    IR_COND_JUMP, // if (a op b) goto label, b == -1 compares with imm
+    IR_CHECK,     // trap unless 0 <= a < imm (array bounds)
+    IR_LOAD_ELEM, // dst = name[a]
+    IR_STORE_ELEM,// name[a] = b
+    IR_ARG,       // argument #imm = a
+    IR_CALL,      // dst = name(imm arguments), dst may be -1
+    IR_RETURN     // return a, a may be -1
+} IROp;
+
+typedef struct {
+    IROp op;
+    char op_name[4];
+    int dst;
+    int a;
+    int b;
+    int imm;
+    int label;
+    char* name;
+} IRInstr;
+
+typedef struct {
+    char* name;
+    IRInstr* code;
+    int count;
+    int capacity;
+    int nparams;
+    int nvregs;
+    int nlabels;
+    char** vreg_names;    // variable name, NULL for temporaries
+    char* address_taken;  // variables passed to scanf must live in memory
+    int array_bytes;      // local arrays, always in memory
+} IRFunction;
+
+typedef struct {
+    IRFunction* functions;
+    int count;
+} IRProgram;
+
+IRProgram* ir_lower_program(ASTNode* program, ThreadPool* pool);
+void ir_free_program(IRProgram* program);
+void ir_print_function(IRFunction* function, FILE* out);
+
+#endif
@@ -0,0 +1,257 @@
+#include <stdlib.h>
+#include <string.h>
+#include "json.h"
+
+typedef struct {
+    const char* p;
+    const char* end;
+    int failed;
+} Parser;
+
+static void skip_space(Parser* ps) {
+    while (ps->p < ps->end && (*ps->p == ' ' || *ps->p == '\t' || *ps->p == '\n' || *ps->p == '\r')) ps->p++;
+}
+
+static int take(Parser* ps, char c) {
+    skip_space(ps);
+    if (ps->p < ps->end && *ps->p == c) {
+        ps->p++;
+        return 1;
+    }
+    return 0;
+}
+
+static int take_word(Parser* ps, const char* word) {
+    size_t n = strlen(word);
+    if ((size_t)(ps->end - ps->p) < n || memcmp(ps->p, word, n) != 0) return 0;
+    ps->p += n;
+    return 1;
+}
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static unsigned read_hex4(Parser* ps) {
+    unsigned code = 0;
+    for (int i = 0; i < 4; i++) {
+        int digit = ps->p < ps->end ? hex_digit(*ps->p++) : -1;
+        if (digit < 0) {
+            ps->failed = 1;
+            return 0;
+        }
+        code = code << 4 | digit;
+    }
+    return code;
+}
+
+static int put_utf8(char* out, unsigned code) {
+    if (code < 0x80) {
+        out[0] = code;
+        return 1;
+    }
+    if (code < 0x800) {
+        out[0] = 0xC0 | code >> 6;
+        out[1] = 0x80 | (code & 0x3F);
+        return 2;
+    }
+    if (code < 0x10000) {
+        out[0] = 0xE0 | code >> 12;
+        out[1] = 0x80 | (code >> 6 & 0x3F);
+        out[2] = 0x80 | (code & 0x3F);
+        return 3;
+    }
+    out[0] = 0xF0 | code >> 18;
+    out[1] = 0x80 | (code >> 12 & 0x3F);
+    out[2] = 0x80 | (code >> 6 & 0x3F);
+    out[3] = 0x80 | (code & 0x3F);
+    return 4;
+}
+
+// After the opening quote. An escape never grows, so the raw length
+// bounds the result.
+static char* parse_string(Parser* ps, int* length) {
+    const char* close = ps->p;
+    while (close < ps->end && *close != '"') close += *close == '\\' ? 2 : 1;
+    char* text = malloc(close - ps->p + 1);
+    int n = 0;
+
+    while (ps->p < ps->end && *ps->p != '"') {
+        char c = *ps->p++;
+        if (c != '\\') {
+            text[n++] = c;
+            continue;
+        }
+        if (ps->p == ps->end) break;
+        switch (c = *ps->p++) {
+        case 'n': text[n++] = '\n'; break;
+        case 't': text[n++] = '\t'; break;
+        case 'r': text[n++] = '\r'; break;
+        case 'b': text[n++] = '\b'; break;
+        case 'f': text[n++] = '\f'; break;
+        case 'u': {
+            unsigned code = read_hex4(ps);
+            if (code >= 0xD800 && code < 0xDC00 && take_word(ps, "\\u")) {
+                unsigned low = read_hex4(ps);
+                code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            }
+            n += put_utf8(text + n, code);
+            break;
+        }
+        default: text[n++] = c; break;
+        }
+    }
+    if (ps->p == ps->end) ps->failed = 1;
+    ps->p++;
+    text[n] = '\0';
+    *length = n;
+    return text;
+}
+
+static void parse_value(Parser* ps, JsonValue* value);
+
+// Elements (or members, with keys) up to close.
+static void parse_items(Parser* ps, JsonValue* value, char close, int keyed) {
+    int capacity = 0;
+    if (take(ps, close)) return;
+    do {
+        if (value->count == capacity) {
+            capacity = capacity ? capacity * 2 : 4;
+            value->items = realloc(value->items, capacity * sizeof(JsonValue));
+        }
+        JsonValue* item = &value->items[value->count++];
+        memset(item, 0, sizeof(JsonValue));
+        if (keyed) {
+            int length;
+            if (!take(ps, '"')) {
+                ps->failed = 1;
+                return;
+            }
+            item->key = parse_string(ps, &length);
+            if (!take(ps, ':')) {
+                ps->failed = 1;
+                return;
+            }
+        }
+        parse_value(ps, item);
+    } while (!ps->failed && take(ps, ','));
+    if (!take(ps, close)) ps->failed = 1;
+}
+
+static void parse_value(Parser* ps, JsonValue* value) {
+    skip_space(ps);
+    if (ps->p == ps->end) {
+        ps->failed = 1;
+    } else if (*ps->p == '"') {
+        ps->p++;
+        value->type = JSON_STRING;
+        value->string = parse_string(ps, &value->length);
+    } else if (*ps->p == '{') {
+        ps->p++;
+        value->type = JSON_OBJECT;
+        parse_items(ps, value, '}', 1);
+    } else if (*ps->p == '[') {
+        ps->p++;
+        value->type = JSON_ARRAY;
+        parse_items(ps, value, ']', 0);
+    } else if (take_word(ps, "true")) {
+        value->type = JSON_TRUE;
+    } else if (take_word(ps, "false")) {
+        value->type = JSON_FALSE;
+    } else if (take_word(ps, "null")) {
+        value->type = JSON_NULL;
+    } else {
+        char* end;
+        value->type = JSON_NUMBER;
+        value->number = strtod(ps->p, &end);
+        if (end == ps->p || end > ps->end) ps->failed = 1;
+        ps->p = end;
+    }
+}
+
+static void free_items(JsonValue* value) {
+    for (int i = 0; i < value->count; i++) {
+        free_items(&value->items[i]);
+        free(value->items[i].key);
+    }
+    free(value->items);
+    free(value->string);
+}
+
+JsonValue* json_parse(const char* text, int length) {
+    Parser ps = { text, text + length, 0 };
+    JsonValue* value = calloc(1, sizeof(JsonValue));
+    parse_value(&ps, value);
+    skip_space(&ps);
+    if (ps.failed || ps.p != ps.end) {
+        json_free(value);
+        return NULL;
+    }
+    return value;
+}
+
+void json_free(JsonValue* value) {
+    if (!value) return;
+    free_items(value);
+    free(value);
+}
+
+JsonValue* json_get(JsonValue* value, const char* key) {
+    if (!value || value->type != JSON_OBJECT) return NULL;
+    for (int i = 0; i < value->count; i++) {
+        if (strcmp(value->items[i].key, key) == 0) return &value->items[i];
+    }
+    return NULL;
+}
+
+int json_int(JsonValue* value, const char* key, int fallback) {
+    JsonValue* member = json_get(value, key);
+    return member && member->type == JSON_NUMBER ? (int)member->number : fallback;
+}
+
+// The length of the UTF-8 sequence at text, or 0 if it is not one.
+static int utf8_length(const unsigned char* text, int available) {
+    unsigned char c = text[0];
+    int n = c >= 0xF5 ? 0 : c >= 0xF0 ? 4 : c >= 0xE0 ? 3 : c >= 0xC2 ? 2 : 0;
+    if (n > available) return 0;
+    for (int i = 1; i < n; i++) {
+        if ((text[i] & 0xC0) != 0x80) return 0;
+    }
+    return n;
+}
+
+void json_write_string(FILE* out, const char* text, int length) {
+    putc('"', out);
+    for (int i = 0; i < length; i++) {
+        unsigned char c = text[i];
+        if (c >= 0x80) {
+            // Source text is not always valid UTF-8; JSON must be.
+            int n = utf8_length((const unsigned char*)text + i, length - i);
+            if (n) {
+                fwrite(text + i, 1, n, out);
+                i += n - 1;
+            } else {
+                fputs("\\ufffd", out);
+            }
+            continue;
+        }
+        if (c == '"' || c == '\\') {
+            putc('\\', out);
+            putc(c, out);
+        } else if (c == '\n') {
+            fputs("\\n", out);
+        } else if (c == '\t') {
+            fputs("\\t", out);
+        } else if (c == '\r') {
+            fputs("\\r", out);
+        } else if (c < 0x20) {
+            fprintf(out, "\\u%04x", c);
+        } else {
+            putc(c, out);
+        }
+    }
+    putc('"', out);
+}
@@ -0,0 +1,41 @@
+#ifndef JSON_H
+#define JSON_H
+
+#include <stdio.h>
+
+// Just enough JSON for the language server's messages and the compiler's
+// machine-readable output.
+
+typedef enum {
+    JSON_NULL,
+    JSON_FALSE,
+    JSON_TRUE,
+    JSON_NUMBER,
+    JSON_STRING,
+    JSON_ARRAY,
+    JSON_OBJECT
+} JsonType;
+
+typedef struct JsonValue {
+    JsonType type;
+    double number;
+    char* string;               // strings, unescaped and NUL-terminated
+    int length;
+    char* key;                  // members of an object
+    struct JsonValue* items;    // elements of an array or members of an object
+    int count;
+} JsonValue;
+
+// Returns NULL if text is not a single JSON value.
+JsonValue* json_parse(const char* text, int length);
+void json_free(JsonValue* value);
+
+// The member named key, or NULL if value is not an object or has none.
+JsonValue* json_get(JsonValue* value, const char* key);
+// The number at key, or fallback.
+int json_int(JsonValue* value, const char* key, int fallback);
+
+// Writes text as a quoted JSON string.
+void json_write_string(FILE* out, const char* text, int length);
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef LINES_H
+#define LINES_H
+
+// Where each line of a text starts, so that byte offsets (all that tokens,
+// nodes and errors record) turn into lines and columns only when a
+// position is actually shown. The table is built on first use with one
+// pass over the text and then answers by binary search; after an edit
+// only the part from the edit on is scanned again.
+typedef struct {
+    int* starts;        // starts[0] = 0, then one past each newline
+    int count;          // entries valid so far
+    int capacity;
+    int scanned;        // the entries cover text[0, scanned)
+} LineTable;
+
+// The line and column (both from 0, the column in bytes) of offset.
+void line_position(LineTable* table, const char* text, int length, int offset, int* line, int* column);
+// The offset of a line and column, clamped to the line and the text.
+int line_offset(LineTable* table, const char* text, int length, int line, int column);
+
+// The text changed from offset on.
+void line_table_invalidate(LineTable* table, int offset);
+void line_table_free(LineTable* table);
+
+#endif
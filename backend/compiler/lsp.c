@@ -0,0 +1,741 @@
+// Language server for the editor: the Language Server Protocol over
+// stdin/stdout, on the compiler's own lexer and parser. Every open file is
+// a Document (document.c), so an edit re-lexes and re-parses only the
+// function it touches; the tokens and trees stay in memory between
+// requests, and the table of global names is rebuilt (cheaply) on the
+// first request after an edit.
+//
+// Implements incremental sync, syntax diagnostics, semantic tokens,
+// go-to-definition and completion. Positions count bytes when the client
+// offers the utf-8 position encoding, else UTF-16 code units, the
+// protocol's default.
+//
+// Identifiers and literals are interned in the compiler's string pool,
+// which only grows: names typed and since deleted stay in it. It is freed
+// whenever the last open file is closed; a session that keeps a file open
+// throughout holds every name lexed in it.
+//
+//   make lsp
+//   ./lsp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include "document.h"
+#include "json.h"
+#include "preprocess.h"
+#include "strpool.h"
+
+// Semantic token legend; the order is the one announced in initialize.
+enum { TOKEN_KEYWORD, TOKEN_TYPE, TOKEN_FUNCTION, TOKEN_VARIABLE, TOKEN_PARAMETER, TOKEN_NUMBER, TOKEN_STRING, TOKEN_OPERATOR, TOKEN_MACRO };
+enum { MODIFIER_DECLARATION = 1, MODIFIER_DEFAULT_LIBRARY = 2 };
+
+// LSP CompletionItemKind values.
+enum { COMPLETION_FUNCTION = 3, COMPLETION_VARIABLE = 6, COMPLETION_KEYWORD = 14 };
+
+// A global name and the segment that defines it.
+typedef struct {
+    const char* name;
+    int segment;
+} IndexEntry;
+
+typedef struct OpenFile {
+    char* uri;
+    Document* doc;
+    IndexEntry* index;          // open addressing on the interned name
+    int index_capacity;         // a power of two, or 0 while stale
+    struct OpenFile* next;
+} OpenFile;
+
+// A local variable or parameter in scope.
+typedef struct {
+    const char* name;
+    int token;                  // its declaring token
+    int depth;                  // brace depth of its block
+    int parameter;
+} Local;
+
+// Tracks which locals a function's tokens have in scope, token by token.
+typedef struct {
+    Local* locals;
+    int count;
+    int capacity;
+    int depth;
+} Scope;
+
+static FILE* rpc;
+static OpenFile* files;
+
+static const char* keywords[] = {
+    "if", "else", "while", "for", "switch", "case", "default", "break", "return",
+    "int", "char", "void", "printf", "scanf"
+};
+
+// -- Positions
+
+// Whether the client agreed to count columns in bytes.
+static int utf8_positions;
+
+// The length of the length bytes at offset in the client's encoding.
+// Four-byte UTF-8 sequences are two UTF-16 code units, the others one.
+static int encoded_length(Document* doc, int offset, int length) {
+    if (utf8_positions) return length;
+    int units = 0;
+    for (int i = offset; i < offset + length; i++) {
+        unsigned char c = doc->text[i];
+        if ((c & 0xC0) != 0x80) units += c >= 0xF0 ? 2 : 1;
+    }
+    return units;
+}
+
+static int position_offset(Document* doc, JsonValue* position) {
+    int line = json_int(position, "line", 0);
+    int character = json_int(position, "character", 0);
+    if (utf8_positions) return document_offset(doc, line, character);
+    int offset = document_offset(doc, line, 0);
+    for (int units = 0; units < character && offset < doc->length && doc->text[offset] != '\n';) {
+        units += (unsigned char)doc->text[offset] >= 0xF0 ? 2 : 1;
+        offset++;
+        while (offset < doc->length && (doc->text[offset] & 0xC0) == 0x80) offset++;
+    }
+    return offset;
+}
+
+static void write_position(FILE* out, Document* doc, int offset) {
+    int line, column;
+    document_position(doc, offset, &line, &column);
+    fprintf(out, "{\"line\":%d,\"character\":%d}", line, encoded_length(doc, offset - column, column));
+}
+
+static void write_range(FILE* out, Document* doc, int start, int end) {
+    fputs("{\"start\":", out);
+    write_position(out, doc, start);
+    fputs(",\"end\":", out);
+    write_position(out, doc, end);
+    putc('}', out);
+}
+
+// -- Names
+
+static int is_type(int kind) {
+    return kind == INT || kind == CHAR || kind == VOID;
+}
+
+// The name a segment defines (a function or global array), or NULL.
+static const char* defined_name(Segment* segment) {
+    if (segment->ntokens < 2 || !is_type(segment->tokens[0].kind) || segment->tokens[1].kind != ID) return NULL;
+    return segment->tokens[1].value.id;
+}
+
+static int defines_function(Segment* segment) {
+    return segment->ntokens > 2 && segment->tokens[2].kind == LPAREN;
+}
+
+static unsigned hash_name(const char* name) {
+    return (unsigned)((size_t)name >> 3) * 2654435761u;
+}
+
+static void build_index(OpenFile* file) {
+    Document* doc = file->doc;
+    int capacity = 16;
+    while (capacity < doc->nsegments * 2) capacity *= 2;
+    free(file->index);
+    file->index = calloc(capacity, sizeof(IndexEntry));
+    file->index_capacity = capacity;
+    for (int i = 0; i < doc->nsegments; i++) {
+        const char* name = defined_name(&doc->segments[i]);
+        if (!name) continue;
+        unsigned slot = hash_name(name) & (capacity - 1);
+        while (file->index[slot].name && file->index[slot].name != name) slot = (slot + 1) & (capacity - 1);
+        // The first definition wins, as it would for the checker.
+        if (!file->index[slot].name) file->index[slot] = (IndexEntry){ name, i };
+    }
+}
+
+// The segment defining name, or -1.
+static int find_global(OpenFile* file, const char* name) {
+    if (!file->index_capacity) build_index(file);
+    unsigned mask = file->index_capacity - 1;
+    for (unsigned slot = hash_name(name) & mask; file->index[slot].name; slot = (slot + 1) & mask) {
+        if (file->index[slot].name == name) return file->index[slot].segment;
+    }
+    return -1;
+}
+
+// -- Scopes
+
+static Local* find_local(Scope* scope, const char* name) {
+    for (int i = scope->count - 1; i >= 0; i--) {
+        if (scope->locals[i].name == name) return &scope->locals[i];
+    }
+    return NULL;
+}
+
+// Moves the scope past token i of segment. Returns 1 if the token
+// declares a local (now on top of the scope).
+static int scope_step(Scope* scope, Segment* segment, int i) {
+    Token* token = &segment->tokens[i];
+    if (token->kind == LBRACE) {
+        scope->depth++;
+    } else if (token->kind == RBRACE) {
+        if (scope->depth > 0) scope->depth--;
+        while (scope->count > 0 && scope->locals[scope->count - 1].depth > scope->depth) scope->count--;
+    } else if (token->kind == ID && i >= 2 && is_type(segment->tokens[i - 1].kind)) {
+        if (scope->count == scope->capacity) {
+            scope->capacity = scope->capacity ? scope->capacity * 2 : 16;
+            scope->locals = realloc(scope->locals, scope->capacity * sizeof(Local));
+        }
+        // Parameters come before the body's brace but belong to it.
+        int parameter = scope->depth == 0;
+        scope->locals[scope->count++] = (Local){ token->value.id, i, parameter ? 1 : scope->depth, parameter };
+        return 1;
+    }
+    return 0;
+}
+
+// -- Messages
+
+static void send_message(char* body, size_t length) {
+    fprintf(rpc, "Content-Length: %zu\r\n\r\n", length);
+    fwrite(body, 1, length, rpc);
+    fflush(rpc);
+    free(body);
+}
+
+static void write_id(FILE* out, JsonValue* id) {
+    if (id && id->type == JSON_STRING) {
+        json_write_string(out, id->string, id->length);
+    } else if (id && id->type == JSON_NUMBER) {
+        fprintf(out, "%.0f", id->number);
+    } else {
+        fputs("null", out);
+    }
+}
+
+// Opens a response; the caller writes the result and calls end_message.
+static FILE* begin_response(JsonValue* id, char** body, size_t* length) {
+    FILE* out = open_memstream(body, length);
+    fputs("{\"jsonrpc\":\"2.0\",\"id\":", out);
+    write_id(out, id);
+    fputs(",\"result\":", out);
+    return out;
+}
+
+static void end_message(FILE* out, char** body, size_t* length) {
+    putc('}', out);
+    fclose(out);
+    send_message(*body, *length);
+}
+
+static void respond(JsonValue* id, const char* result) {
+    char* body;
+    size_t length;
+    FILE* out = begin_response(id, &body, &length);
+    fputs(result, out);
+    end_message(out, &body, &length);
+}
+
+static void respond_error(JsonValue* id, int code, const char* message) {
+    char* body;
+    size_t length;
+    FILE* out = open_memstream(&body, &length);
+    fputs("{\"jsonrpc\":\"2.0\",\"id\":", out);
+    write_id(out, id);
+    fprintf(out, ",\"error\":{\"code\":%d,\"message\":", code);
+    json_write_string(out, message, strlen(message));
+    fputs("}}", out);
+    fclose(out);
+    send_message(body, length);
+}
+
+// -- Documents
+
+static OpenFile* find_file(JsonValue* params) {
+    JsonValue* uri = json_get(json_get(params, "textDocument"), "uri");
+    if (!uri || uri->type != JSON_STRING) return NULL;
+    for (OpenFile* file = files; file; file = file->next) {
+        if (strcmp(file->uri, uri->string) == 0) return file;
+    }
+    return NULL;
+}
+
+static void write_diagnostic(FILE* out, Document* doc, Diagnostic* diagnostic, int* first) {
+    if (!*first) putc(',', out);
+    *first = 0;
+    fputs("{\"range\":", out);
+    write_range(out, doc, diagnostic->start, diagnostic->end);
+    fputs(",\"severity\":1,\"source\":\"minicc\",\"message\":", out);
+    json_write_string(out, diagnostic->message, strlen(diagnostic->message));
+    putc('}', out);
+}
+
+static Diagnostic* diagnostics;
+static int diagnostics_capacity;
+
+static void publish_diagnostics(OpenFile* file) {
+    Document* doc = file->doc;
+    char* body;
+    size_t length;
+    FILE* out = open_memstream(&body, &length);
+    int first = 1;
+
+    fputs("{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":", out);
+    json_write_string(out, file->uri, strlen(file->uri));
+    fputs(",\"diagnostics\":[", out);
+    int count = document_diagnostics(doc, &diagnostics, &diagnostics_capacity);
+    for (int i = 0; i < count; i++) {
+        write_diagnostic(out, doc, &diagnostics[i], &first);
+    }
+    fputs("]}", out);
+    end_message(out, &body, &length);
+}
+
+static void did_open(JsonValue* params) {
+    JsonValue* item = json_get(params, "textDocument");
+    JsonValue* uri = json_get(item, "uri");
+    JsonValue* text = json_get(item, "text");
+    if (!uri || uri->type != JSON_STRING || !text || text->type != JSON_STRING) return;
+
+    OpenFile* file = find_file(params);
+    if (file) {
+        document_close(file->doc);
+    } else {
+        file = calloc(1, sizeof(OpenFile));
+        file->uri = strdup(uri->string);
+        file->next = files;
+        files = file;
+    }
+    file->doc = document_open(text->string, text->length);
+    file->index_capacity = 0;
+    publish_diagnostics(file);
+}
+
+static void did_change(JsonValue* params) {
+    OpenFile* file = find_file(params);
+    JsonValue* changes = json_get(params, "contentChanges");
+    if (!file || !changes || changes->type != JSON_ARRAY) return;
+
+    // Changes apply one after another, each to the text the last one left.
+    for (int i = 0; i < changes->count; i++) {
+        JsonValue* change = &changes->items[i];
+        JsonValue* range = json_get(change, "range");
+        JsonValue* text = json_get(change, "text");
+        if (!text || text->type != JSON_STRING) continue;
+        if (range) {
+            int start = position_offset(file->doc, json_get(range, "start"));
+            int end = position_offset(file->doc, json_get(range, "end"));
+            if (end < start) end = start;
+            document_edit(file->doc, start, end - start, text->string, text->length);
+        } else {
+            document_edit(file->doc, 0, file->doc->length, text->string, text->length);
+        }
+    }
+    file->index_capacity = 0;
+    publish_diagnostics(file);
+}
+
+static void did_close(JsonValue* params) {
+    OpenFile* file = find_file(params);
+    if (!file) return;
+    for (OpenFile** link = &files; *link; link = &(*link)->next) {
+        if (*link == file) {
+            *link = file->next;
+            break;
+        }
+    }
+    document_close(file->doc);
+    free(file->index);
+    free(file->uri);
+    free(file);
+    // Nothing refers to the pooled strings now, macro names included.
+    if (!files) {
+        preprocess_reset();
+        free_string_pool();
+    }
+}
+
+// -- Semantic tokens
+
+// The legend entry of token i of segment, or -1 for punctuation; scope
+// must have been stepped through token i.
+static int classify(OpenFile* file, Scope* scope, Segment* segment, int i, int declares, int* modifiers) {
+    Token* token = &segment->tokens[i];
+    *modifiers = 0;
+    switch (token->kind) {
+    case IF: case ELSE: case WHILE: case FOR: case SWITCH: case CASE: case DEFAULT: case BREAK: case RETURN:
+        return TOKEN_KEYWORD;
+    case INT: case CHAR: case VOID:
+        return TOKEN_TYPE;
+    case MAIN:
+        if (i == 1) *modifiers = MODIFIER_DECLARATION;
+        return TOKEN_FUNCTION;
+    case PRINTF: case SCANF:
+        *modifiers = MODIFIER_DEFAULT_LIBRARY;
+        return TOKEN_FUNCTION;
+    case NUMBER:
+        return TOKEN_NUMBER;
+    case STRING: case HEADER_NAME:
+        return TOKEN_STRING;
+    case HASH:
+        return TOKEN_KEYWORD;
+    case PLUS: case MINUS: case TIMES: case DIVIDE: case MOD: case EQUALS:
+    case EQ: case NEQ: case LT: case GT: case LTE: case GTE: case AND: case OR: case NOT: case ADDRESS:
+        return TOKEN_OPERATOR;
+    case ID:
+        break;
+    default:
+        return -1;
+    }
+    // The name of a directive, and the macro a #define or #undef names.
+    if (i > 0 && segment->tokens[i - 1].kind == HASH) return TOKEN_KEYWORD;
+    if (i > 1 && segment->tokens[i - 2].kind == HASH) {
+        const char* directive = segment->tokens[i - 1].kind == ID ? segment->tokens[i - 1].value.id : "";
+        if (strcmp(directive, "define") == 0) {
+            *modifiers = MODIFIER_DECLARATION;
+            return TOKEN_MACRO;
+        }
+        if (strcmp(directive, "undef") == 0) return TOKEN_MACRO;
+    }
+    if (declares) {
+        *modifiers = MODIFIER_DECLARATION;
+        return scope->locals[scope->count - 1].parameter ? TOKEN_PARAMETER : TOKEN_VARIABLE;
+    }
+    if (i == 1 && defined_name(segment)) {
+        *modifiers = MODIFIER_DECLARATION;
+        return defines_function(segment) ? TOKEN_FUNCTION : TOKEN_VARIABLE;
+    }
+    Local* local = find_local(scope, token->value.id);
+    if (local) return local->parameter ? TOKEN_PARAMETER : TOKEN_VARIABLE;
+    int global = find_global(file, token->value.id);
+    if (global >= 0) return defines_function(&file->doc->segments[global]) ? TOKEN_FUNCTION : TOKEN_VARIABLE;
+    return i + 1 < segment->ntokens && segment->tokens[i + 1].kind == LPAREN ? TOKEN_FUNCTION : TOKEN_VARIABLE;
+}
+
+// Tokens overlapping [start, end), in the relative encoding of the protocol.
+static void semantic_tokens(JsonValue* id, OpenFile* file, int start, int end) {
+    Document* doc = file->doc;
+    char* body;
+    size_t length;
+    FILE* out = begin_response(id, &body, &length);
+    Scope scope = { 0 };
+    int previous_line = 0, previous_character = 0;
+    int first = 1;
+
+    fputs("{\"data\":[", out);
+    for (int s = document_find_segment(doc, start); s < doc->nsegments && doc->segments[s].start < end; s++) {
+        Segment* segment = &doc->segments[s];
+        scope.count = scope.depth = 0;
+        for (int i = 0; i < segment->ntokens; i++) {
+            int declares = scope_step(&scope, segment, i);
+            Token* token = &segment->tokens[i];
+            int offset = segment->start + token->offset;
+            if (offset + token->length <= start) continue;
+            if (offset >= end) break;
+
+            int modifiers;
+            int type = classify(file, &scope, segment, i, declares, &modifiers);
+            if (type < 0) continue;
+            int line, character;
+            document_position(doc, offset, &line, &character);
+            character = encoded_length(doc, offset - character, character);
+            // A token may not span lines; a string literal with a line
+            // break is marked up to it.
+            const char* newline = memchr(doc->text + offset, '\n', token->length);
+            int token_length = encoded_length(doc, offset, newline ? newline - (doc->text + offset) : token->length);
+            fprintf(out, "%s%d,%d,%d,%d,%d", first ? "" : ",", line - previous_line,
+                    line == previous_line ? character - previous_character : character,
+                    token_length, type, modifiers);
+            first = 0;
+            previous_line = line;
+            previous_character = character;
+        }
+    }
+    fputs("]}", out);
+    end_message(out, &body, &length);
+    free(scope.locals);
+}
+
+// -- Definition and completion
+
+// The index of the token of segment at offset (touching it from either
+// side), or -1.
+static int token_at(Segment* segment, int offset) {
+    int low = 0, high = segment->ntokens - 1;
+    offset -= segment->start;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        Token* token = &segment->tokens[middle];
+        if (offset < token->offset) {
+            high = middle - 1;
+        } else if (offset > token->offset + token->length) {
+            low = middle + 1;
+        } else {
+            // At the boundary of two tokens prefer the identifier.
+            if (offset == token->offset && middle > 0 && token->kind != ID &&
+                segment->tokens[middle - 1].kind == ID &&
+                segment->tokens[middle - 1].offset + segment->tokens[middle - 1].length == offset) {
+                return middle - 1;
+            }
+            return middle;
+        }
+    }
+    return -1;
+}
+
+static void write_location(FILE* out, OpenFile* file, int start, int end) {
+    fputs("{\"uri\":", out);
+    json_write_string(out, file->uri, strlen(file->uri));
+    fputs(",\"range\":", out);
+    write_range(out, file->doc, start, end);
+    putc('}', out);
+}
+
+static void definition(JsonValue* id, JsonValue* params) {
+    OpenFile* file = find_file(params);
+    if (!file) {
+        respond(id, "null");
+        return;
+    }
+    Document* doc = file->doc;
+    int offset = position_offset(doc, json_get(params, "position"));
+    int s = document_find_segment(doc, offset);
+    int i = s < doc->nsegments ? token_at(&doc->segments[s], offset) : -1;
+    if (i < 0 || doc->segments[s].tokens[i].kind != ID) {
+        respond(id, "null");
+        return;
+    }
+
+    Segment* segment = &doc->segments[s];
+    const char* name = segment->tokens[i].value.id;
+    Scope scope = { 0 };
+    for (int t = 0; t < i; t++) scope_step(&scope, segment, t);
+    Local* local = scope_step(&scope, segment, i) ? &scope.locals[scope.count - 1] : find_local(&scope, name);
+
+    Segment* target = segment;
+    Token* declaration = NULL;
+    if (local) {
+        declaration = &segment->tokens[local->token];
+    } else {
+        int global = find_global(file, name);
+        if (global >= 0) {
+            target = &doc->segments[global];
+            declaration = &target->tokens[1];
+        }
+    }
+    free(scope.locals);
+    if (!declaration) {
+        respond(id, "null");
+        return;
+    }
+
+    char* body;
+    size_t length;
+    FILE* out = begin_response(id, &body, &length);
+    write_location(out, file, target->start + declaration->offset, target->start + declaration->offset + declaration->length);
+    end_message(out, &body, &length);
+}
+
+static int has_prefix(const char* name, const char* prefix, int prefix_length) {
+    return strncmp(name, prefix, prefix_length) == 0;
+}
+
+static void write_item(FILE* out, const char* label, int kind, int* first) {
+    if (!*first) putc(',', out);
+    *first = 0;
+    fputs("{\"label\":", out);
+    json_write_string(out, label, strlen(label));
+    fprintf(out, ",\"kind\":%d}", kind);
+}
+
+// Locals in scope at the cursor, global functions and arrays, then
+// keywords, all starting with the identifier being typed.
+static void completion(JsonValue* id, JsonValue* params) {
+    OpenFile* file = find_file(params);
+    if (!file) {
+        respond(id, "[]");
+        return;
+    }
+    Document* doc = file->doc;
+    int offset = position_offset(doc, json_get(params, "position"));
+    int prefix_start = offset;
+    while (prefix_start > 0) {
+        char c = doc->text[prefix_start - 1];
+        if (!(c == '_' || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9'))) break;
+        prefix_start--;
+    }
+    const char* prefix = doc->text + prefix_start;
+    int prefix_length = offset - prefix_start;
+
+    char* body;
+    size_t length;
+    FILE* out = begin_response(id, &body, &length);
+    int first = 1;
+    fputs("{\"isIncomplete\":false,\"items\":[", out);
+
+    int s = document_find_segment(doc, offset);
+    if (s < doc->nsegments && doc->segments[s].start < offset) {
+        Segment* segment = &doc->segments[s];
+        Scope scope = { 0 };
+        for (int i = 0; i < segment->ntokens && segment->start + segment->tokens[i].offset + segment->tokens[i].length < offset; i++) {
+            scope_step(&scope, segment, i);
+        }
+        for (int i = scope.count - 1; i >= 0; i--) {
+            Local* local = &scope.locals[i];
+            // Inner declarations shadow outer ones.
+            if (find_local(&scope, local->name) != local) continue;
+            if (has_prefix(local->name, prefix, prefix_length)) write_item(out, local->name, COMPLETION_VARIABLE, &first);
+        }
+        free(scope.locals);
+    }
+    for (int i = 0; i < doc->nsegments; i++) {
+        Segment* segment = &doc->segments[i];
+        const char* name = defined_name(segment);
+        if (name && find_global(file, name) == i && has_prefix(name, prefix, prefix_length)) {
+            write_item(out, name, defines_function(segment) ? COMPLETION_FUNCTION : COMPLETION_VARIABLE, &first);
+        }
+    }
+    for (size_t i = 0; i < sizeof(keywords) / sizeof(keywords[0]); i++) {
+        if (has_prefix(keywords[i], prefix, prefix_length)) write_item(out, keywords[i], COMPLETION_KEYWORD, &first);
+    }
+    fputs("]}", out);
+    end_message(out, &body, &length);
+}
+
+// -- Main loop
+
+// A format for the result of initialize, taking the position encoding.
+static const char* capabilities =
+    "{\"capabilities\":{"
+    "\"positionEncoding\":\"%s\","
+    "\"textDocumentSync\":{\"openClose\":true,\"change\":2},"
+    "\"definitionProvider\":true,"
+    "\"completionProvider\":{\"triggerCharacters\":[]},"
+    "\"semanticTokensProvider\":{\"legend\":{"
+    "\"tokenTypes\":[\"keyword\",\"type\",\"function\",\"variable\",\"parameter\",\"number\",\"string\",\"operator\",\"macro\"],"
+    "\"tokenModifiers\":[\"declaration\",\"defaultLibrary\"]},"
+    "\"full\":true,\"range\":true}},"
+    "\"serverInfo\":{\"name\":\"minicc-lsp\"}}";
+
+static void initialize(JsonValue* id, JsonValue* params) {
+    JsonValue* encodings = json_get(json_get(json_get(params, "capabilities"), "general"), "positionEncodings");
+    utf8_positions = 0;
+    for (int i = 0; encodings && encodings->type == JSON_ARRAY && i < encodings->count; i++) {
+        JsonValue* encoding = &encodings->items[i];
+        if (encoding->type == JSON_STRING && strcmp(encoding->string, "utf-8") == 0) utf8_positions = 1;
+    }
+    char result[1024];
+    snprintf(result, sizeof(result), capabilities, utf8_positions ? "utf-8" : "utf-16");
+    respond(id, result);
+}
+
+// Longer bodies are skipped instead of read, and answered as unparsable.
+#define MAX_MESSAGE_LENGTH (64 << 20)
+
+static void skip_input(long length) {
+    char buffer[4096];
+    while (length > 0) {
+        size_t n = fread(buffer, 1, length < (long)sizeof(buffer) ? (size_t)length : sizeof(buffer), stdin);
+        if (n == 0) return;
+        length -= n;
+    }
+}
+
+// Reads one message body, NUL-terminated. Returns NULL at end of input.
+// A body too long to hold comes back empty, so it gets a parse error.
+static char* read_message(int* length) {
+    char line[256];
+    long declared = -1;
+    while (fgets(line, sizeof(line), stdin)) {
+        if (strcmp(line, "\r\n") == 0 || strcmp(line, "\n") == 0) {
+            if (declared < 0) continue;
+            char* body = declared <= MAX_MESSAGE_LENGTH ? malloc(declared + 1) : NULL;
+            if (!body) {
+                skip_input(declared);
+                *length = 0;
+                return calloc(1, 1);
+            }
+            if (fread(body, 1, declared, stdin) != (size_t)declared) {
+                free(body);
+                return NULL;
+            }
+            body[declared] = '\0';
+            *length = (int)declared;
+            return body;
+        }
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            // strtol saturates, so a huge length stays huge.
+            declared = strtol(line + 15, NULL, 10);
+            if (declared < 0) declared = -1;
+        }
+    }
+    return NULL;
+}
+
+int main(void) {
+    // Stray prints from the front end must not corrupt the protocol
+    // stream, so stdout is the log from here on.
+    rpc = fdopen(dup(STDOUT_FILENO), "w");
+    dup2(STDERR_FILENO, STDOUT_FILENO);
+
+    int shutdown = 0;
+    int length;
+    char* message;
+    while ((message = read_message(&length))) {
+        JsonValue* request = json_parse(message, length);
+        free(message);
+        JsonValue* method = json_get(request, "method");
+        JsonValue* id = json_get(request, "id");
+        JsonValue* params = json_get(request, "params");
+        const char* name = method && method->type == JSON_STRING ? method->string : "";
+
+        if (!request) {
+            respond_error(NULL, -32700, "parse error");
+        } else if (strcmp(name, "initialize") == 0) {
+            initialize(id, params);
+        } else if (strcmp(name, "shutdown") == 0) {
+            shutdown = 1;
+            respond(id, "null");
+        } else if (strcmp(name, "exit") == 0) {
+            json_free(request);
+            break;
+        } else if (strcmp(name, "textDocument/didOpen") == 0) {
+            did_open(params);
+        } else if (strcmp(name, "textDocument/didChange") == 0) {
+            did_change(params);
+        } else if (strcmp(name, "textDocument/didClose") == 0) {
+            did_close(params);
+        } else if (strcmp(name, "textDocument/semanticTokens/full") == 0 ||
+                   strcmp(name, "textDocument/semanticTokens/range") == 0) {
+            OpenFile* file = find_file(params);
+            JsonValue* range = json_get(params, "range");
+            if (!file) {
+                respond(id, "null");
+            } else if (range) {
+                semantic_tokens(id, file, position_offset(file->doc, json_get(range, "start")),
+                                position_offset(file->doc, json_get(range, "end")));
+            } else {
+                semantic_tokens(id, file, 0, file->doc->length);
+            }
+        } else if (strcmp(name, "textDocument/definition") == 0) {
+            definition(id, params);
+        } else if (strcmp(name, "textDocument/completion") == 0) {
+            completion(id, params);
+        } else if (id) {
+            respond_error(id, -32601, "method not found");
+        }
+        json_free(request);
+    }
+
+    while (files) {
+        OpenFile* next = files->next;
+        document_close(files->doc);
+        free(files->index);
+        free(files->uri);
+        free(files);
+        files = next;
+    }
+    free_string_pool();
+    return shutdown ? 0 : 1;
+}
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ast.h"
+#include "optimize.h"
+#include "bounds.h"
+#include "ir.h"
+#include "regalloc.h"
+#include "bytecode.h"
+#include "vm.h"
+#include "strpool.h"
+#include "symtab.h"
+#include "semantic.h"
+#include "threadpool.h"
+#include "check.h"
+#include "syntax.h"
+#include "lines.h"
+#include "preprocess.h"
+#include "document.h"
+#include "stats.h"
+
+int yyparse(void);
+
+// Runs statement as phase, for --stats.
+#define PHASE(phase, statement) \
+    do {                        \
+        stats_begin(phase);     \
+        statement;              \
+        stats_end(phase);       \
+    } while (0)
+
+// The whole of in, NUL-terminated.
+static char* read_all(FILE* in, int* length) {
+    size_t capacity = 4096, n = 0, got;
+    char* text = malloc(capacity);
+    while ((got = fread(text + n, 1, capacity - n - 1, in)) > 0) {
+        n += got;
+        if (n + 1 == capacity) text = realloc(text, capacity *= 2);
+    }
+    text[n] = '\0';
+    *length = n;
+    return text;
+}
+
+// What yyparse does with the lexer, in two steps timed apart: all the
+// tokens first.
+static int lex_then_parse(const char* text, int length) {
+    Token* tokens = NULL;
+    int capacity = 0;
+    Strays strays = { 0 };
+    int count;
+    PHASE(PHASE_LEX, count = lex_buffer(text, length, &tokens, &capacity, &strays));
+    // The lexer prints these as it goes when it feeds the parser.
+    for (int i = 0; i < strays.count; i++) printf("Unexpected character: %c\n", text[strays.offsets[i]]);
+    int status;
+    PHASE(PHASE_PARSE, status = parse_lexed(tokens, count, length));
+    stats_count("tokens", count);
+    free(strays.offsets);
+    free(tokens);
+    return status;
+}
+
+static void write_stats(void) {
+    stats_write(stderr);
+}
+
+int main(int argc, char** argv) {
+    int optimize = 1;
+    int dump_ir = 0;
+    int regalloc_stats = 0;
+    int dump_bytecode = 0;
+    int run = 0;
+    int op_pairs = 0;
+    int superinstructions = 1;
+    int vectorize = 1;
+    int threads = default_thread_count();
+    const char* cache_dir = NULL;
+    FILE* in = stdin;
+    int check = 0;
+    int with_ast = 0;
+    int stats = 0;
+    int status = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-O0") == 0) {
+            optimize = 0;
+        } else if (strcmp(argv[i], "--ir") == 0) {
+            dump_ir = 1;
+        } else if (strcmp(argv[i], "--regalloc-stats") == 0) {
+            regalloc_stats = 1;
+        } else if (strcmp(argv[i], "--bytecode") == 0) {
+            dump_bytecode = 1;
+        } else if (strcmp(argv[i], "--run") == 0) {
+            run = 1;
+        } else if (strcmp(argv[i], "--op-pairs") == 0) {
+            op_pairs = 1;
+        } else if (strcmp(argv[i], "--no-super") == 0) {
+            superinstructions = 0;
+        } else if (strcmp(argv[i], "--no-vectorize") == 0) {
+            vectorize = 0;
+        } else if (strcmp(argv[i], "--check") == 0) {
+            check = 1;
+        } else if (strcmp(argv[i], "--ast") == 0) {
+            with_ast = 1;
+        } else if (strcmp(argv[i], "--stats") == 0) {
+            stats = 1;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            cache_dir = argv[++i];
+        } else if (!(in = fopen(argv[i], "r"))) {
+            fprintf(stderr, "Error: cannot open %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    if (stats) {
+        // At exit, so that a run stopped by errors is reported too.
+        stats_enable();
+        atexit(write_stats);
+    }
+
+    int length;
+    char* text = read_all(in, &length);
+    if (in != stdin) fclose(in);
+    if (check) {
+        status = check_source(text, length, with_ast, stdout) ? 1 : 0;
+        preprocess_reset();
+        free(text);
+        free_string_pool();
+        return status;
+    }
+
+    int parsed;
+    if (stats) {
+        parsed = lex_then_parse(text, length) == 0;
+    } else {
+        lex_string(text, length);
+        parsed = yyparse() == 0;
+        yylex_destroy();
+    }
+    preprocess_reset();
+    if (syntax_error_count) {
+        LineTable lines = { 0 };
+        for (int i = 0; i < syntax_error_count; i++) {
+            int line, column;
+            line_position(&lines, text, length, syntax_errors[i].offset, &line, &column);
+            fprintf(stderr, "Error: line %d, column %d: %s\n", line + 1, column + 1, syntax_errors[i].message);
+        }
+        if (syntax_error_count == MAX_SYNTAX_ERRORS) fprintf(stderr, "Error: too many syntax errors, stopping\n");
+        line_table_free(&lines);
+    }
+    free(text);
+    if (!parsed || syntax_error_count) {
+        if (parsed) free_ast(ast_root);
+        free_string_pool();
+        return 1;
+    }
+    ThreadPool* pool = thread_pool_create(threads);
+    if (ast_root) {
+        if (stats) stats_count("nodes", stats_count_nodes(ast_root));
+        stats_count("threads", thread_pool_size(pool));
+        stats_begin(PHASE_SEMANTIC);
+        resolve_symbols(ast_root);
+        int failed = check_program(ast_root, pool);
+        stats_end(PHASE_SEMANTIC);
+        if (failed) {
+            free_ast(ast_root);
+            free_string_pool();
+            thread_pool_destroy(pool);
+            return 1;
+        }
+        if (optimize) {
+            PHASE(PHASE_TAIL_CALLS, optimize_tail_calls(ast_root));
+            PHASE(PHASE_BOUNDS_CHECKS, eliminate_bounds_checks(ast_root));
+            if (vectorize) PHASE(PHASE_VECTORIZE, vectorize_loops(ast_root));
+            PHASE(PHASE_UNROLL, unroll_loops(ast_root));
+        }
+        // Every engine, including the evaluator behind fold_pure_calls,
+        // addresses variables by the slots resolved here; the rewrites above
+        // add variables of their own.
+        if (optimize) PHASE(PHASE_RESOLVE, resolve_symbols(ast_root));
+        if (optimize) PHASE(PHASE_FOLD_PURE_CALLS, fold_pure_calls(ast_root));
+        if (stats && optimize) stats_count("nodes_optimized", stats_count_nodes(ast_root));
+        if (dump_ir || regalloc_stats) {
+            IRProgram* ir;
+            PHASE(PHASE_CODEGEN, ir = ir_lower_program(ast_root, pool));
+            for (int i = 0; dump_ir && i < ir->count; i++) ir_print_function(&ir->functions[i], stdout);
+            if (regalloc_stats) regalloc_print_stats(ir, stdout);
+            ir_free_program(ir);
+        } else if (dump_bytecode || run) {
+            BytecodeOptions options = { optimize, optimize && superinstructions, cache_dir };
+            Chunk* chunk;
+            PHASE(PHASE_CODEGEN, chunk = bytecode_compile(ast_root, &options, pool));
+            if (!chunk) {
+                status = 1;
+            } else {
+                stats_count("functions", chunk->nfunctions);
+                stats_count("instructions", chunk->count);
+                if (dump_bytecode) bytecode_disassemble(chunk, stdout);
+                if (run) {
+                    VMProfile* profile = op_pairs ? calloc(1, sizeof(VMProfile)) : NULL;
+                    int ran;
+                    PHASE(PHASE_EXECUTE, ran = vm_run(chunk, profile, &status));
+                    if (!ran) status = 1;
+                    if (profile) vm_print_profile(profile, stderr);
+                    free(profile);
+                }
+                bytecode_free(chunk);
+            }
+        } else {
+            print_ast(ast_root, 0);
+        }
+        free_ast(ast_root);
+    }
+    free_string_pool();
+    thread_pool_destroy(pool);
+    return status;
+}
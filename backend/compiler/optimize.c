@@ -0,0 +1,841 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "optimize.h"
+#include "eval.h"
+
+// Name of the accumulator introduced for `return e op f(...)`. It cannot
+// collide with user identifiers because the lexer never produces '$'.
+#define ACC_NAME "$acc"
+
+typedef struct {
+    ASTNode* program;
+    ASTNode* function;
+    int nparams;
+    int self_tail;      // returns of the form `return f(...)`
+    int accumulating;   // returns of the form `return e op f(...)`
+    char op;            // operator shared by all accumulating returns
+} TailInfo;
+
+static void set_type(ASTNode* node, char* type) {
+    free(node->type);
+    node->type = strdup(type);
+}
+
+// Frees a node whose children have been moved elsewhere.
+static void free_shell(ASTNode* node) {
+    if (node->value && !holds_literal(node)) free(node->value);
+    free(node->type);
+    free(node);
+}
+
+static int list_length(ASTNode* node) {
+    int n = 0;
+    for (; node; node = node->next) n++;
+    return n;
+}
+
+static int is_self_call(ASTNode* expr, TailInfo* info) {
+    return node_is(expr, "call")
+        && strcmp(expr->value, info->function->value) == 0
+        && list_length(expr->left) == info->nparams;
+}
+
+// Matches `e op f(...)` and `f(...) op e` for op in {+, *}.
+static ASTNode* accumulated_call(ASTNode* expr, TailInfo* info, ASTNode** operand) {
+    if (!node_is(expr, "+") && !node_is(expr, "*")) return NULL;
+    if (is_self_call(expr->right, info)) {
+        *operand = expr->left;
+        return expr->right;
+    }
+    if (is_self_call(expr->left, info)) {
+        *operand = expr->right;
+        return expr->left;
+    }
+    return NULL;
+}
+
+// A tail call hands the callee's result back unconverted, so a char
+// function may only tail-call another char function: the result of an
+// int one still needs truncating.
+static int keeps_result(ASTNode* call, TailInfo* info) {
+    if (strcmp(info->function->left->value, "char") != 0) return 1;
+    for (ASTNode* function = info->program; function; function = function->next) {
+        if (node_is(function, "function") && strcmp(function->value, call->value) == 0) {
+            return strcmp(function->left->value, "char") == 0;
+        }
+    }
+    return 0;
+}
+
+static void visit_blocks(ASTNode* stmt, void (*visit)(ASTNode*, TailInfo*), TailInfo* info) {
+    if (node_is(stmt, "if") || node_is(stmt, "while") || node_is(stmt, "tail-loop") || node_is(stmt, "block")) {
+        visit(stmt->right, info);
+    } else if (node_is(stmt, "for") || node_is(stmt, "vector-for")) {
+        visit(stmt->right->right, info);
+    } else if (node_is(stmt, "if-else")) {
+        visit(stmt->right->left, info);
+        visit(stmt->right->right, info);
+    } else if (node_is(stmt, "switch")) {
+        for (ASTNode* clause = stmt->right; clause; clause = clause->next) visit(clause->right, info);
+    }
+}
+
+static void scan_returns(ASTNode* list, TailInfo* info) {
+    for (ASTNode* stmt = list; stmt; stmt = stmt->next) {
+        if (node_is(stmt, "return") && stmt->right) {
+            ASTNode* operand;
+            if (is_self_call(stmt->right, info)) {
+                info->self_tail++;
+            } else if (accumulated_call(stmt->right, info, &operand)) {
+                char op = stmt->right->type[0];
+                if (info->accumulating++ == 0) info->op = op;
+                else if (info->op != op) info->op = 0;
+            }
+        } else {
+            visit_blocks(stmt, scan_returns, info);
+        }
+    }
+}
+
+static void rewrite_returns(ASTNode* list, TailInfo* info) {
+    char op[2] = { info->op, '\0' };
+
+    for (ASTNode* stmt = list; stmt; stmt = stmt->next) {
+        if (!node_is(stmt, "return") || !stmt->right) {
+            visit_blocks(stmt, rewrite_returns, info);
+            continue;
+        }
+
+        ASTNode* value = stmt->right;
+        ASTNode* operand;
+        ASTNode* call;
+        if (is_self_call(value, info)) {
+            // return f(args)  =>  tail-jump(args)
+            set_type(stmt, "tail-jump");
+            stmt->value = strdup(value->value);
+            stmt->left = value->left;
+            stmt->right = NULL;
+            free_shell(value);
+        } else if (info->op && (call = accumulated_call(value, info, &operand))) {
+            // return e op f(args)  =>  $acc = $acc op e; tail-jump(args)
+            ASTNode* jump = create_node("tail-jump", call->value);
+            jump->left = call->left;
+            jump->next = stmt->next;
+            set_type(stmt, "assignment");
+            stmt->value = strdup(ACC_NAME);
+            stmt->right = create_binary_node(op, create_node("id", ACC_NAME), operand);
+            stmt->next = jump;
+            free_shell(call);
+            free_shell(value);
+            stmt = jump;
+        } else if (info->op) {
+            // return e  =>  return $acc op e
+            stmt->right = create_binary_node(op, create_node("id", ACC_NAME), value);
+        } else if (node_is(value, "call") && keeps_result(value, info)) {
+            set_type(value, "tail-call");
+        }
+    }
+}
+
+static void optimize_function(ASTNode* program, ASTNode* function) {
+    ASTNode* body = function->right;
+    char* return_type = function->left->value;
+    TailInfo info = { program, function, list_length(body->left), 0, 0, 0 };
+
+    scan_returns(body->right, &info);
+    if (strcmp(return_type, "int") != 0 && strcmp(return_type, "char") != 0) info.op = 0;
+    rewrite_returns(body->right, &info);
+    if (!info.self_tail && !info.op) return;
+
+    ASTNode* loop = create_node("tail-loop", NULL);
+    loop->right = body->right;
+    body->right = loop;
+    if (info.op) {
+        ASTNode* acc = create_node("declaration", ACC_NAME);
+        acc->left = create_node("type", return_type);
+        acc->right = create_node("number", info.op == '+' ? "0" : "1");
+        acc->next = loop;
+        body->right = acc;
+    }
+}
+
+void optimize_tail_calls(ASTNode* program) {
+    for (ASTNode* function = program; function; function = function->next) {
+        if (node_is(function, "function")) optimize_function(program, function);
+    }
+}
+
+typedef struct {
+    ASTNode* function;
+    int pure;
+} Purity;
+
+typedef struct {
+    ASTNode* program;
+    Purity* table;
+    int count;
+} FoldContext;
+
+typedef struct {
+    char** items;
+    int count;
+    int capacity;
+} NameList;
+
+static void add_name(NameList* list, char* name) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        list->items = realloc(list->items, list->capacity * sizeof(char*));
+    }
+    list->items[list->count++] = name;
+}
+
+static int has_name(NameList* list, char* name) {
+    for (int i = 0; i < list->count; i++) {
+        if (strcmp(list->items[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
+static void collect_locals(ASTNode* node, NameList* locals) {
+    for (; node; node = node->next) {
+        if (node_is(node, "param") || node_is(node, "declaration") || node_is(node, "array-declaration")) {
+            add_name(locals, node->value);
+        }
+        collect_locals(node->left, locals);
+        collect_locals(node->right, locals);
+    }
+}
+
+static int names_variable(ASTNode* node) {
+    return node_is(node, "id") || node_is(node, "assignment")
+        || node_is(node, "element") || node_is(node, "unchecked-element")
+        || node_is(node, "element-assignment") || node_is(node, "unchecked-element-assignment");
+}
+
+// No I/O, and every variable read or written is a parameter or a local.
+static int is_self_contained(ASTNode* node, NameList* locals) {
+    for (; node; node = node->next) {
+        if (node_is(node, "printf") || node_is(node, "scanf")) return 0;
+        if (names_variable(node) && !has_name(locals, node->value)) return 0;
+        if (!is_self_contained(node->left, locals) || !is_self_contained(node->right, locals)) return 0;
+    }
+    return 1;
+}
+
+static Purity* find_purity(FoldContext* ctx, char* name) {
+    for (int i = 0; i < ctx->count; i++) {
+        if (strcmp(ctx->table[i].function->value, name) == 0) return &ctx->table[i];
+    }
+    return NULL;
+}
+
+static int calls_only_pure(ASTNode* node, FoldContext* ctx) {
+    for (; node; node = node->next) {
+        if (node_is(node, "call") || node_is(node, "tail-call") || node_is(node, "tail-jump")) {
+            Purity* callee = find_purity(ctx, node->value);
+            if (!callee || !callee->pure) return 0;
+        }
+        if (!calls_only_pure(node->left, ctx) || !calls_only_pure(node->right, ctx)) return 0;
+    }
+    return 1;
+}
+
+// A function is pure if it is self-contained and only calls pure functions.
+// Starts from the self-contained set and drops callers of impure functions
+// until nothing changes, so (mutually) recursive pure functions stay pure.
+static void analyze_purity(FoldContext* ctx) {
+    for (int i = 0; i < ctx->count; i++) {
+        NameList locals = { NULL, 0, 0 };
+        collect_locals(ctx->table[i].function->right, &locals);
+        ctx->table[i].pure = is_self_contained(ctx->table[i].function->right->right, &locals);
+        free(locals.items);
+    }
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < ctx->count; i++) {
+            if (ctx->table[i].pure && !calls_only_pure(ctx->table[i].function->right->right, ctx)) {
+                ctx->table[i].pure = 0;
+                changed = 1;
+            }
+        }
+    }
+}
+
+static void make_number(ASTNode* node, int value) {
+    char buffer[16];
+
+    free_ast(node->left);
+    free_ast(node->right);
+    node->left = node->right = NULL;
+    set_type(node, "number");
+    if (node->value) free(node->value);
+    sprintf(buffer, "%d", value);
+    node->value = strdup(buffer);
+}
+
+static void fold_expr(ASTNode* expr, FoldContext* ctx);
+
+static void fold_args(ASTNode* args, FoldContext* ctx) {
+    for (; args; args = args->next) fold_expr(args, ctx);
+}
+
+static void fold_expr(ASTNode* expr, FoldContext* ctx) {
+    int value;
+
+    if (!expr || node_is(expr, "number") || node_is(expr, "id")) return;
+    if (node_is(expr, "element") || node_is(expr, "unchecked-element")) {
+        fold_expr(expr->left, ctx);
+        return;
+    }
+
+    if (node_is(expr, "call") || node_is(expr, "tail-call")) {
+        int args[EVAL_MAX_VARS];
+        int nargs = 0;
+        Purity* callee = find_purity(ctx, expr->value);
+
+        fold_args(expr->left, ctx);
+        if (!callee || !callee->pure) return;
+        for (ASTNode* arg = expr->left; arg; arg = arg->next) {
+            if (!node_is(arg, "number") || nargs == EVAL_MAX_VARS) return;
+            args[nargs++] = atoi(arg->value);
+        }
+        if (eval_call(ctx->program, callee->function, args, nargs, &value)) make_number(expr, value);
+        return;
+    }
+
+    fold_expr(expr->left, ctx);
+    fold_expr(expr->right, ctx);
+    if (!expr->right) {
+        if (node_is(expr->left, "number") && eval_unary(expr->type, atoi(expr->left->value), &value)) {
+            make_number(expr, value);
+        }
+    } else if (node_is(expr->left, "number") && node_is(expr->right, "number")
+        && eval_binary(expr->type, atoi(expr->left->value), atoi(expr->right->value), &value)) {
+        make_number(expr, value);
+    }
+}
+
+static void fold_statements(ASTNode* list, FoldContext* ctx) {
+    for (ASTNode* stmt = list; stmt; stmt = stmt->next) {
+        if (node_is(stmt, "if") || node_is(stmt, "while")) {
+            fold_expr(stmt->left, ctx);
+            fold_statements(stmt->right, ctx);
+        } else if (node_is(stmt, "if-else")) {
+            fold_expr(stmt->left, ctx);
+            fold_statements(stmt->right->left, ctx);
+            fold_statements(stmt->right->right, ctx);
+        } else if (node_is(stmt, "tail-loop") || node_is(stmt, "block")) {
+            fold_statements(stmt->right, ctx);
+        } else if (node_is(stmt, "for") || node_is(stmt, "vector-for")) {
+            fold_statements(stmt->left->left, ctx);
+            fold_expr(stmt->left->right, ctx);
+            fold_statements(stmt->right->left, ctx);
+            fold_statements(stmt->right->right, ctx);
+        } else if (node_is(stmt, "call") || node_is(stmt, "printf") || node_is(stmt, "tail-jump")) {
+            fold_args(stmt->left, ctx);
+        } else if (node_is(stmt, "element-assignment") || node_is(stmt, "unchecked-element-assignment")) {
+            fold_expr(stmt->left, ctx);
+            fold_expr(stmt->right, ctx);
+        } else if (node_is(stmt, "scanf")) {
+            for (ASTNode* target = stmt->left; target; target = target->next) fold_expr(target->left, ctx);
+        } else if (node_is(stmt, "switch")) {
+            fold_expr(stmt->left, ctx);
+            for (ASTNode* clause = stmt->right; clause; clause = clause->next) fold_statements(clause->right, ctx);
+        } else {
+            fold_expr(stmt->right, ctx);
+        }
+    }
+}
+
+void fold_pure_calls(ASTNode* program) {
+    FoldContext ctx = { program, NULL, 0 };
+
+    for (ASTNode* function = program; function; function = function->next) {
+        if (node_is(function, "function")) ctx.count++;
+    }
+    ctx.table = calloc(ctx.count ? ctx.count : 1, sizeof(Purity));
+    ctx.count = 0;
+    for (ASTNode* function = program; function; function = function->next) {
+        if (node_is(function, "function")) ctx.table[ctx.count++].function = function;
+    }
+
+    analyze_purity(&ctx);
+    for (int i = 0; i < ctx.count; i++) {
+        fold_statements(ctx.table[i].function->right->right, &ctx);
+    }
+    free(ctx.table);
+}
+
+// ---- for-loop unrolling ---------------------------------------------------
+
+// Loops with a known trip count up to UNROLL_MAX_TRIPS are unrolled
+// completely if the copies stay within UNROLL_FULL_BUDGET nodes. Other
+// counted loops get their body replicated UNROLL_FACTOR times (fewer for
+// bodies above UNROLL_BODY_BUDGET / factor nodes), followed by the original
+// loop for the remaining iterations.
+#define UNROLL_MAX_TRIPS 16
+#define UNROLL_FULL_BUDGET 256
+#define UNROLL_BODY_BUDGET 64
+#define UNROLL_FACTOR 4
+
+// `for (init; var cmp bound; var = var + step)` where neither var nor
+// bound changes in the body.
+typedef struct {
+    char* var;
+    const char* cmp;
+    ASTNode* bound;
+    int step;
+    int has_start;
+    int start;
+    long long trips;    // -1 when not known at compile time
+} CountedLoop;
+
+static ASTNode* copy_tree(ASTNode* node) {
+    if (!node) return NULL;
+    ASTNode* copy = create_node(node->type, node->value);
+    copy->depth = node->depth;
+    copy->slot = node->slot;
+    copy->left = copy_tree(node->left);
+    copy->right = copy_tree(node->right);
+    copy->next = copy_tree(node->next);
+    return copy;
+}
+
+static int count_nodes(ASTNode* node) {
+    int n = 0;
+    for (; node; node = node->next) n += 1 + count_nodes(node->left) + count_nodes(node->right);
+    return n;
+}
+
+static void collect_char_variables(ASTNode* node, NameList* names) {
+    for (; node; node = node->next) {
+        if ((node_is(node, "param") || node_is(node, "declaration"))
+            && node->left && strcmp(node->left->value, "char") == 0) {
+            add_name(names, node->value);
+        }
+        collect_char_variables(node->left, names);
+        collect_char_variables(node->right, names);
+    }
+}
+
+// Any assignment, scanf target or (shadowing) declaration of name.
+static int writes_name(ASTNode* node, char* name) {
+    for (; node; node = node->next) {
+        if ((node_is(node, "assignment") || node_is(node, "declaration") || node_is(node, "address")
+             || node_is(node, "array-declaration"))
+            && strcmp(node->value, name) == 0) {
+            return 1;
+        }
+        if (writes_name(node->left, name) || writes_name(node->right, name)) return 1;
+    }
+    return 0;
+}
+
+// A `break` that leaves the loop with body list; breaks inside nested
+// loops and switches leave those instead.
+static int has_break(ASTNode* list) {
+    for (; list; list = list->next) {
+        if (node_is(list, "break")) return 1;
+        if ((node_is(list, "if") || node_is(list, "block")) && has_break(list->right)) return 1;
+        if (node_is(list, "if-else") && (has_break(list->right->left) || has_break(list->right->right))) return 1;
+    }
+    return 0;
+}
+
+static int has_declaration(ASTNode* list) {
+    for (; list; list = list->next) {
+        if (node_is(list, "declaration") || node_is(list, "array-declaration")) return 1;
+    }
+    return 0;
+}
+
+// Negative literals parse as unary minus; this pass runs before folding.
+static int is_literal(ASTNode* node) {
+    int value;
+    if (node_is(node, "neg") && node_is(node->left, "number") && eval_unary("neg", atoi(node->left->value), &value)) {
+        make_number(node, value);
+    }
+    return node_is(node, "number");
+}
+
+// Returns step if expr is `var + step`, `step + var` or `var - step`, else 0.
+static int induction_step(ASTNode* expr, char* var) {
+    if (node_is(expr, "+") && node_is(expr->left, "id") && node_is(expr->right, "number")
+        && strcmp(expr->left->value, var) == 0) {
+        return atoi(expr->right->value);
+    }
+    if (node_is(expr, "+") && node_is(expr->right, "id") && node_is(expr->left, "number")
+        && strcmp(expr->right->value, var) == 0) {
+        return atoi(expr->left->value);
+    }
+    if (node_is(expr, "-") && node_is(expr->left, "id") && node_is(expr->right, "number")
+        && strcmp(expr->left->value, var) == 0 && atoi(expr->right->value) != INT_MIN) {
+        return -atoi(expr->right->value);
+    }
+    return 0;
+}
+
+// Iterations of a counted loop with constant start and bound, or -1 if
+// the loop does not terminate without the induction variable wrapping.
+static long long trip_count(CountedLoop* loop) {
+    long long start = loop->start;
+    long long bound = atoi(loop->bound->value);
+    long long step = loop->step;
+    long long trips;
+
+    if (strcmp(loop->cmp, "<") == 0) trips = start < bound ? (bound - start + step - 1) / step : 0;
+    else if (strcmp(loop->cmp, "<=") == 0) trips = start <= bound ? (bound - start) / step + 1 : 0;
+    else if (strcmp(loop->cmp, ">") == 0) trips = start > bound ? (start - bound - step - 1) / -step : 0;
+    else if (strcmp(loop->cmp, ">=") == 0) trips = start >= bound ? (start - bound) / -step + 1 : 0;
+    else if ((bound - start) % step == 0 && (bound - start) / step >= 0) trips = (bound - start) / step;
+    else return -1;
+
+    long long last = start + trips * step;
+    return last < INT_MIN || last > INT_MAX ? -1 : trips;
+}
+
+static int analyze_loop(ASTNode* loop, NameList* char_vars, CountedLoop* out) {
+    ASTNode* init = loop->left->left;
+    ASTNode* cond = loop->left->right;
+    ASTNode* step = loop->right->left;
+    ASTNode* body = loop->right->right;
+    static const char* mirrored[][2] = { { "<", ">" }, { ">", "<" }, { "<=", ">=" }, { ">=", "<=" }, { "!=", "!=" } };
+
+    if (!node_is(step, "assignment") || has_name(char_vars, step->value)) return 0;
+    out->var = step->value;
+    if (!(out->step = induction_step(step->right, out->var))) return 0;
+
+    out->cmp = NULL;
+    for (int i = 0; i < 5 && !out->cmp; i++) {
+        if (!node_is(cond, mirrored[i][0])) continue;
+        if (node_is(cond->left, "id") && strcmp(cond->left->value, out->var) == 0) {
+            out->cmp = mirrored[i][0];
+            out->bound = cond->right;
+        } else if (node_is(cond->right, "id") && strcmp(cond->right->value, out->var) == 0) {
+            out->cmp = mirrored[i][1];
+            out->bound = cond->left;
+        }
+    }
+    if (!out->cmp) return 0;
+    if (out->step > 0 ? out->cmp[0] == '>' : out->cmp[0] == '<') return 0;
+    if (node_is(out->bound, "id")) {
+        if (strcmp(out->bound->value, out->var) == 0 || writes_name(body, out->bound->value)) return 0;
+    } else if (!is_literal(out->bound)) {
+        return 0;
+    }
+    if (writes_name(body, out->var) || has_break(body)) return 0;
+
+    out->has_start = (node_is(init, "declaration") || node_is(init, "assignment"))
+        && strcmp(init->value, out->var) == 0 && is_literal(init->right);
+    out->start = out->has_start ? atoi(init->right->value) : 0;
+    out->trips = out->has_start && node_is(out->bound, "number") ? trip_count(out) : -1;
+    return 1;
+}
+
+static void substitute(ASTNode* node, char* var, int value) {
+    char buffer[16];
+
+    for (; node; node = node->next) {
+        if (node_is(node, "id") && strcmp(node->value, var) == 0) {
+            set_type(node, "number");
+            free(node->value);
+            sprintf(buffer, "%d", value);
+            node->value = strdup(buffer);
+        }
+        substitute(node->left, var, value);
+        substitute(node->right, var, value);
+    }
+}
+
+// A copy of the loop body; in a block of its own if it declares variables.
+static ASTNode* body_copy(ASTNode* body) {
+    ASTNode* copy = copy_tree(body);
+    if (!has_declaration(body)) return copy;
+    ASTNode* block = create_node("block", NULL);
+    block->right = copy;
+    return block;
+}
+
+static ASTNode** append(ASTNode** tail, ASTNode* list) {
+    *tail = list;
+    while (*tail) tail = &(*tail)->next;
+    return tail;
+}
+
+static ASTNode* number_node(long long value) {
+    char buffer[24];
+    sprintf(buffer, "%lld", value);
+    return create_node("number", buffer);
+}
+
+// Replaces the loop by `trips` copies of its body with the induction
+// variable substituted. An induction variable that outlives the loop gets
+// its final value assigned.
+static void unroll_fully(ASTNode* loop, CountedLoop* info) {
+    ASTNode* init = loop->left->left;
+    ASTNode* body = loop->right->right;
+    ASTNode* list = NULL;
+    ASTNode** tail = &list;
+
+    for (long long k = 0; k < info->trips; k++) {
+        ASTNode* copy = body_copy(body);
+        substitute(copy, info->var, (int)(info->start + k * info->step));
+        tail = append(tail, copy);
+    }
+    if (node_is(init, "assignment")) {
+        ASTNode* last = create_node("assignment", info->var);
+        last->right = number_node(info->start + info->trips * info->step);
+        append(tail, last);
+    }
+
+    free_ast(loop->left);
+    free_ast(loop->right);
+    set_type(loop, "block");
+    loop->left = NULL;
+    loop->right = list;
+}
+
+// Name of the precomputed bound of a partially unrolled loop; '$' keeps it
+// apart from user identifiers like ACC_NAME.
+#define LIMIT_NAME "$limit"
+
+// The unrolled loop runs while `var < limit` (`var > limit` when counting
+// down), which guarantees `factor` more iterations of the original loop.
+// For a variable bound the limit is computed once before the loop and
+// saturates instead of overflowing, in which case the unrolled loop does
+// not run and the original loop takes all iterations. Returns NULL when a
+// constant limit does not fit in an int.
+static ASTNode* unroll_guard(CountedLoop* info, int factor, ASTNode** prelude) {
+    int increasing = info->step > 0;
+    long long adjust = (long long)(factor - 1) * (increasing ? info->step : -info->step)
+        - (info->cmp[1] == '=' ? 1 : 0);
+    char* strict = increasing ? "<" : ">";
+    char* shift = increasing ? "-" : "+";
+
+    *prelude = NULL;
+    if (node_is(info->bound, "number")) {
+        long long limit = atoi(info->bound->value) + (increasing ? -adjust : adjust);
+        if (limit < INT_MIN || limit > INT_MAX) return NULL;
+        return create_binary_node(strict, create_node("id", info->var), number_node(limit));
+    }
+
+    // int $limit = INT_MIN;  if (bound >= INT_MIN + adjust) { $limit = bound - adjust; }
+    ASTNode* limit = create_node("declaration", LIMIT_NAME);
+    limit->left = create_node("type", "int");
+    limit->right = number_node(increasing ? INT_MIN : INT_MAX);
+    ASTNode* check = create_node("if", NULL);
+    check->left = create_binary_node(increasing ? ">=" : "<=", create_node("id", info->bound->value),
+                                     number_node(increasing ? INT_MIN + adjust : INT_MAX - adjust));
+    check->right = create_node("assignment", LIMIT_NAME);
+    check->right->right = create_binary_node(shift, create_node("id", info->bound->value), number_node(adjust));
+    limit->next = check;
+    *prelude = limit;
+    return create_binary_node(strict, create_node("id", info->var), create_node("id", LIMIT_NAME));
+}
+
+//   for (init; cond; step) body
+// becomes
+//   { init; [limit]; for (; guard; ) { body step body step ... } for (; cond; step) body }
+static void unroll_partially(ASTNode* loop, CountedLoop* info, int factor) {
+    ASTNode* prelude;
+    ASTNode* guard = unroll_guard(info, factor, &prelude);
+    if (!guard) return;
+
+    ASTNode* unrolled = create_node("for", NULL);
+    unrolled->left = create_node("for-control", NULL);
+    unrolled->left->right = guard;
+    unrolled->right = create_node("for-body", NULL);
+    ASTNode** tail = &unrolled->right->right;
+    for (int k = 0; k < factor; k++) {
+        tail = append(tail, body_copy(loop->right->right));
+        tail = append(tail, copy_tree(loop->right->left));
+    }
+
+    ASTNode* rest = create_node("for", NULL);
+    rest->left = loop->left;
+    rest->right = loop->right;
+    ASTNode* init = rest->left->left;
+    rest->left->left = NULL;
+
+    set_type(loop, "block");
+    loop->left = NULL;
+    loop->right = NULL;
+    tail = append(&loop->right, init);
+    tail = append(tail, prelude);
+    tail = append(tail, unrolled);
+    append(tail, rest);
+}
+
+static void unroll_statements(ASTNode* list, NameList* char_vars) {
+    for (ASTNode* stmt = list; stmt; stmt = stmt->next) {
+        if (node_is(stmt, "if") || node_is(stmt, "while") || node_is(stmt, "tail-loop") || node_is(stmt, "block")) {
+            unroll_statements(stmt->right, char_vars);
+        } else if (node_is(stmt, "if-else")) {
+            unroll_statements(stmt->right->left, char_vars);
+            unroll_statements(stmt->right->right, char_vars);
+        } else if (node_is(stmt, "switch")) {
+            for (ASTNode* clause = stmt->right; clause; clause = clause->next) {
+                unroll_statements(clause->right, char_vars);
+            }
+        } else if (node_is(stmt, "for")) {
+            // Inner loops first, so the size of the outer body is final.
+            unroll_statements(stmt->right->right, char_vars);
+
+            CountedLoop info;
+            if (!analyze_loop(stmt, char_vars, &info)) continue;
+            int size = count_nodes(stmt->right->right);
+            if (info.trips >= 0 && info.trips <= UNROLL_MAX_TRIPS && info.trips * size <= UNROLL_FULL_BUDGET) {
+                unroll_fully(stmt, &info);
+                continue;
+            }
+            int factor = UNROLL_FACTOR;
+            while (factor > 1 && factor * size > UNROLL_BODY_BUDGET) factor /= 2;
+            if (factor > 1 && strcmp(info.cmp, "!=") != 0 && (info.trips < 0 || info.trips >= 2 * factor)) {
+                unroll_partially(stmt, &info, factor);
+            }
+        }
+    }
+}
+
+void unroll_loops(ASTNode* program) {
+    for (ASTNode* function = program; function; function = function->next) {
+        if (!node_is(function, "function")) continue;
+        NameList char_vars = { NULL, 0, 0 };
+        collect_char_variables(function->right, &char_vars);
+        unroll_statements(function->right->right, &char_vars);
+        free(char_vars.items);
+    }
+}
+
+// ---- loop vectorization ---------------------------------------------------
+
+// A counted loop `for (...; i < n; i = i + 1)` is marked "vector-for" when
+// its body is straight-line code made of
+//     a[i + k] = e;    s = s + e;    s = e + s;    s = s - e;
+// where e uses + - * and unary minus over constants, i, elements a[i + k]
+// and scalars the loop does not change. The bytecode compiler runs such a
+// body as a vector kernel and keeps the loop for the remaining iterations.
+// An array that is stored to must be accessed with one offset k only;
+// otherwise an iteration could read what another one wrote.
+
+typedef struct {
+    char* array;
+    int offset;
+    int store;
+} Access;
+
+typedef struct {
+    char* var;
+    NameList sums;
+    Access* accesses;
+    int count;
+    int capacity;
+} VectorLoop;
+
+static int element_offset(ASTNode* index, char* var, int* offset) {
+    if (node_is(index, "id") && strcmp(index->value, var) == 0) {
+        *offset = 0;
+        return 1;
+    }
+    *offset = induction_step(index, var);
+    return *offset != 0;
+}
+
+static int add_access(VectorLoop* loop, ASTNode* access, int store) {
+    int offset;
+    if (!element_offset(access->left, loop->var, &offset)) return 0;
+    if (loop->count == loop->capacity) {
+        loop->capacity = loop->capacity ? loop->capacity * 2 : 8;
+        loop->accesses = realloc(loop->accesses, loop->capacity * sizeof(Access));
+    }
+    loop->accesses[loop->count].array = access->value;
+    loop->accesses[loop->count].offset = offset;
+    loop->accesses[loop->count].store = store;
+    loop->count++;
+    return 1;
+}
+
+static int vector_operand(ASTNode* expr, VectorLoop* loop) {
+    if (node_is(expr, "number")) return 1;
+    if (node_is(expr, "id")) return !has_name(&loop->sums, expr->value);
+    if (node_is(expr, "element") || node_is(expr, "unchecked-element")) return add_access(loop, expr, 0);
+    if (node_is(expr, "neg")) return vector_operand(expr->left, loop);
+    if (node_is(expr, "+") || node_is(expr, "-") || node_is(expr, "*")) {
+        return vector_operand(expr->left, loop) && vector_operand(expr->right, loop);
+    }
+    return 0;
+}
+
+// The e of `s = s + e`, `s = e + s` or `s = s - e`, else NULL.
+static ASTNode* sum_operand(ASTNode* stmt) {
+    ASTNode* value = stmt->right;
+    if (!node_is(value, "+") && !node_is(value, "-")) return NULL;
+    if (node_is(value->left, "id") && strcmp(value->left->value, stmt->value) == 0) return value->right;
+    if (node_is(value, "+") && node_is(value->right, "id") && strcmp(value->right->value, stmt->value) == 0) {
+        return value->left;
+    }
+    return NULL;
+}
+
+static int vectorizable(ASTNode* loop, CountedLoop* info) {
+    ASTNode* body = loop->right->right;
+    VectorLoop v = { info->var, { NULL, 0, 0 }, NULL, 0, 0 };
+    int ok = body && info->step == 1 && (strcmp(info->cmp, "<") == 0 || strcmp(info->cmp, "<=") == 0)
+        && (info->trips < 0 || info->trips > UNROLL_MAX_TRIPS);
+
+    for (ASTNode* stmt = body; ok && stmt; stmt = stmt->next) {
+        if (node_is(stmt, "assignment")) {
+            ok = strcmp(stmt->value, v.var) != 0 && sum_operand(stmt);
+            add_name(&v.sums, stmt->value);
+        } else {
+            ok = node_is(stmt, "element-assignment") || node_is(stmt, "unchecked-element-assignment");
+        }
+    }
+    for (ASTNode* stmt = body; ok && stmt; stmt = stmt->next) {
+        if (node_is(stmt, "assignment")) ok = vector_operand(sum_operand(stmt), &v);
+        else ok = add_access(&v, stmt, 1) && vector_operand(stmt->right, &v);
+    }
+    for (int i = 0; ok && i < v.count; i++) {
+        for (int j = 0; ok && v.accesses[i].store && j < v.count; j++) {
+            ok = strcmp(v.accesses[i].array, v.accesses[j].array) != 0
+                || v.accesses[i].offset == v.accesses[j].offset;
+        }
+    }
+    free(v.sums.items);
+    free(v.accesses);
+    return ok;
+}
+
+static void vectorize_statements(ASTNode* list, NameList* char_vars) {
+    for (ASTNode* stmt = list; stmt; stmt = stmt->next) {
+        if (node_is(stmt, "if") || node_is(stmt, "while") || node_is(stmt, "tail-loop") || node_is(stmt, "block")) {
+            vectorize_statements(stmt->right, char_vars);
+        } else if (node_is(stmt, "if-else")) {
+            vectorize_statements(stmt->right->left, char_vars);
+            vectorize_statements(stmt->right->right, char_vars);
+        } else if (node_is(stmt, "switch")) {
+            for (ASTNode* clause = stmt->right; clause; clause = clause->next) {
+                vectorize_statements(clause->right, char_vars);
+            }
+        } else if (node_is(stmt, "for")) {
+            vectorize_statements(stmt->right->right, char_vars);
+            CountedLoop info;
+            if (analyze_loop(stmt, char_vars, &info) && vectorizable(stmt, &info)) set_type(stmt, "vector-for");
+        }
+    }
+}
+
+void vectorize_loops(ASTNode* program) {
+    for (ASTNode* function = program; function; function = function->next) {
+        if (!node_is(function, "function")) continue;
+        NameList char_vars = { NULL, 0, 0 };
+        collect_char_variables(function->right, &char_vars);
+        vectorize_statements(function->right->right, &char_vars);
+        free(char_vars.items);
+    }
+}
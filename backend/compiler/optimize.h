@@ -0,0 +1,32 @@
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include "ast.h"
+
+// Rewrites self-recursive tail calls into a "tail-loop" around the function
+// body with "tail-jump" statements that rebind the parameters and restart it.
+// Returns of the form `return e + f(...)` / `return e * f(...)` are turned
+// into tail calls through an accumulator first. Remaining `return g(...)`
+// calls are marked "tail-call" so an engine can reuse the caller's frame,
+// unless a char function would return an int one's result untruncated.
+void optimize_tail_calls(ASTNode* program);
+
+// Computes trip counts of counted `for` loops (constant step, bound that
+// does not change in the body) and unrolls them: completely when the trip
+// count is small and known at compile time, otherwise by a small factor
+// under a code-size budget with the original loop handling the remainder.
+void unroll_loops(ASTNode* program);
+
+// Marks counted loops whose body only stores array elements indexed by the
+// induction variable and sums into accumulators as "vector-for", for the
+// bytecode compiler to run as vector kernels. Loops with a dependence
+// between iterations are left alone. Runs before unroll_loops.
+void vectorize_loops(ASTNode* program);
+
+// Finds pure functions (no printf/scanf, no variables other than their own
+// parameters and locals, only calls to pure functions) and replaces calls to
+// them with constant arguments by the result of a bounded compile-time
+// evaluation. Constant arithmetic is folded along the way.
+void fold_pure_calls(ASTNode* program);
+
+#endif
@@ -3,14 +3,27 @@
 #include <stdlib.h>
 #include <string.h>
 #include "ast.h"
+#include "strpool.h"
+#include "document.h"
+#include "syntax.h"
+#include "preprocess.h"
 
-void yyerror(char *);
+void yyerror(const char *);
 int yylex(void);
+int lex_token(void);
+extern int lex_offset;
+extern int lex_token_start;
 
-ASTNode* create_node(char* type, char* value);
-ASTNode* create_binary_node(char* type, ASTNode* left, ASTNode* right);
-void free_ast(ASTNode* node);
-void print_ast(ASTNode* node, int level);
+ASTNode* ast_root = NULL;
+
+// A location is the byte offset of a symbol's first token. Every node
+// gets the offset of the rule that creates it: a statement starts at its
+// first token, a binary operation at its left operand.
+static int node_offset = -1;
+#define YYLLOC_DEFAULT(Current, Rhs, N) \
+    do { (Current) = (N) ? YYRHSLOC(Rhs, 1) : YYRHSLOC(Rhs, 0); node_offset = (Current); } while (0)
+SyntaxError syntax_errors[MAX_SYNTAX_ERRORS];
+int syntax_error_count;
 %}
 
 %union {
@@ -20,31 +33,51 @@ void print_ast(ASTNode* node, int level);
     ASTNode* node;
 }
 
-%token <num> NUMBER
-%token <id> ID
-%token <str> STRING
-%token IF ELSE WHILE FOR RETURN
-%token INT CHAR VOID MAIN
-%token SCANF PRINTF
-%token PLUS MINUS TIMES DIVIDE MOD
-%token LPAREN RPAREN LBRACE RBRACE
-%token SEMICOLON EQUALS COMMA
-%token EQ NEQ LT GT LTE GTE
-%token AND OR NOT
-%token ADDRESS
-
-%type <node> program function_list function type param_list param
-%type <node> statement_list statement declaration assignment
-%type <node> if_statement while_statement return_statement
-%type <node> expression term factor
+// The aliases name tokens in error messages.
+%define parse.error verbose
+%define api.location.type {int}
+%locations
+
+%token <num> NUMBER "number"
+%token <id> ID "identifier"
+%token <str> STRING "string literal"
+%token IF "if" ELSE "else" WHILE "while" FOR "for" SWITCH "switch" CASE "case" DEFAULT "default"
+%token BREAK "break" RETURN "return"
+%token INT "int" CHAR "char" VOID "void" MAIN "main"
+%token SCANF "scanf" PRINTF "printf"
+%token PLUS "+" MINUS "-" TIMES "*" DIVIDE "/" MOD "%"
+%token LPAREN "(" RPAREN ")" LBRACE "{" RBRACE "}" LBRACKET "[" RBRACKET "]"
+%token SEMICOLON ";" COLON ":" EQUALS "=" COMMA ","
+%token EQ "==" NEQ "!=" LT "<" GT ">" LTE "<=" GTE ">="
+%token AND "&&" OR "||" NOT "!"
+%token ADDRESS "&"
+// Directives; the preprocessor consumes them.
+%token HASH "#" NEWLINE "end of line"
+%token <id> HEADER_NAME "header name"
+
+%type <node> program function_list external function type opt_params param_list param
+%type <node> statement_list body statement declaration array_declaration assignment call_statement
+%type <node> if_statement while_statement for_statement return_statement
+%type <node> switch_statement case_list case_clause break_statement
+%type <node> for_init for_condition for_step
+%type <node> printf_statement scanf_statement scanf_args scanf_target
+%type <node> expression and_expression equality_expression relational_expression
+%type <node> additive_expression term factor call arg_list
+%type <id> function_name
+%type <num> case_value
+
+// Subtrees dropped by a syntax error; a document re-parses on every edit.
+// The finished program is ast_root's and is popped on success too.
+%destructor { free_ast($$); } <node>
+%destructor { } program
 
 %%
 
-program: function_list { $$ = $1; }
+program: function_list { $$ = $1; ast_root = $1; node_offset = -1; }
 ;
 
-function_list: function { $$ = $1; }
-    | function_list function { 
+function_list: external { $$ = $1; }
+    | function_list external { 
         ASTNode* current = $1;
         while (current->next) current = current->next;
         current->next = $2;
@@ -52,19 +85,37 @@ function_list: function { $$ = $1; }
     }
 ;
 
-function: type ID LPAREN param_list RPAREN LBRACE statement_list RBRACE {
+// After a syntax error the parser skips to the next ";" or "}" and goes
+// on; the error nodes only keep the lists intact until the tree is thrown
+// away.
+external: function { $$ = $1; }
+    | array_declaration { $$ = $1; }
+    | error SEMICOLON { $$ = create_node("error", NULL); }
+    | error RBRACE { $$ = create_node("error", NULL); }
+;
+
+function: type function_name LPAREN opt_params RPAREN LBRACE body RBRACE {
     $$ = create_node("function", $2);
     $$->left = $1;
-    $$->right = $4;
-    $$->next = $7;
+    $$->right = create_node("function-body", NULL);
+    $$->right->left = $4;
+    $$->right->right = $7;
 }
 ;
 
+function_name: ID { $$ = $1; }
+    | MAIN { $$ = "main"; }
+;
+
 type: INT { $$ = create_node("type", "int"); }
     | CHAR { $$ = create_node("type", "char"); }
     | VOID { $$ = create_node("type", "void"); }
 ;
 
+opt_params: param_list { $$ = $1; }
+    | /* empty */ { $$ = NULL; }
+;
+
 param_list: param { $$ = $1; }
     | param_list COMMA param {
         ASTNode* current = $1;
@@ -72,7 +123,6 @@ param_list: param { $$ = $1; }
         current->next = $3;
         $$ = $1;
     }
-    | /* empty */ { $$ = NULL; }
 ;
 
 param: type ID {
@@ -90,11 +140,26 @@ statement_list: statement { $$ = $1; }
     }
 ;
 
+// The statements between braces; an error just before the "}" is skipped
+// up to it, so the block still closes there.
+body: statement_list { $$ = $1; }
+    | statement_list error { $$ = $1; }
+    | error { $$ = create_node("error", NULL); }
+;
+
 statement: declaration { $$ = $1; }
+    | array_declaration { $$ = $1; }
     | assignment { $$ = $1; }
     | if_statement { $$ = $1; }
     | while_statement { $$ = $1; }
+    | for_statement { $$ = $1; }
+    | switch_statement { $$ = $1; }
+    | break_statement { $$ = $1; }
     | return_statement { $$ = $1; }
+    | call_statement { $$ = $1; }
+    | printf_statement { $$ = $1; }
+    | scanf_statement { $$ = $1; }
+    | error SEMICOLON { $$ = create_node("error", NULL); }
 ;
 
 declaration: type ID SEMICOLON {
@@ -108,18 +173,66 @@ declaration: type ID SEMICOLON {
 }
 ;
 
+array_declaration: type ID LBRACKET NUMBER RBRACKET SEMICOLON {
+    $$ = create_node("array-declaration", $2);
+    $$->left = $1;
+    $$->right = create_node("number", NULL);
+    $$->right->value = malloc(20);
+    sprintf($$->right->value, "%d", $4);
+}
+;
+
 assignment: ID EQUALS expression SEMICOLON {
     $$ = create_node("assignment", $1);
     $$->right = $3;
 }
+    | ID LBRACKET expression RBRACKET EQUALS expression SEMICOLON {
+    $$ = create_node("element-assignment", $1);
+    $$->left = $3;
+    $$->right = $6;
+}
+;
+
+call_statement: call SEMICOLON { $$ = $1; }
+;
+
+printf_statement: PRINTF LPAREN STRING RPAREN SEMICOLON {
+    $$ = create_node("printf", $3);
+}
+    | PRINTF LPAREN STRING COMMA arg_list RPAREN SEMICOLON {
+    $$ = create_node("printf", $3);
+    $$->left = $5;
+}
+;
+
+scanf_statement: SCANF LPAREN STRING COMMA scanf_args RPAREN SEMICOLON {
+    $$ = create_node("scanf", $3);
+    $$->left = $5;
+}
+;
+
+scanf_args: scanf_target { $$ = $1; }
+    | scanf_args COMMA scanf_target {
+        ASTNode* current = $1;
+        while (current->next) current = current->next;
+        current->next = $3;
+        $$ = $1;
+    }
 ;
 
-if_statement: IF LPAREN expression RPAREN LBRACE statement_list RBRACE {
+scanf_target: ADDRESS ID { $$ = create_node("address", $2); }
+    | ADDRESS ID LBRACKET expression RBRACKET {
+    $$ = create_node("address", $2);
+    $$->left = $4;
+}
+;
+
+if_statement: IF LPAREN expression RPAREN LBRACE body RBRACE {
     $$ = create_node("if", NULL);
     $$->left = $3;
     $$->right = $6;
 }
-    | IF LPAREN expression RPAREN LBRACE statement_list RBRACE ELSE LBRACE statement_list RBRACE {
+    | IF LPAREN expression RPAREN LBRACE body RBRACE ELSE LBRACE body RBRACE {
     $$ = create_node("if-else", NULL);
     $$->left = $3;
     $$->right = create_node("if-body", NULL);
@@ -128,13 +241,90 @@ if_statement: IF LPAREN expression RPAREN LBRACE statement_list RBRACE {
 }
 ;
 
-while_statement: WHILE LPAREN expression RPAREN LBRACE statement_list RBRACE {
+while_statement: WHILE LPAREN expression RPAREN LBRACE body RBRACE {
     $$ = create_node("while", NULL);
     $$->left = $3;
     $$->right = $6;
 }
 ;
 
+for_statement: FOR LPAREN for_init SEMICOLON for_condition SEMICOLON for_step RPAREN LBRACE body RBRACE {
+    $$ = create_node("for", NULL);
+    $$->left = create_node("for-control", NULL);
+    $$->left->left = $3;
+    $$->left->right = $5;
+    $$->right = create_node("for-body", NULL);
+    $$->right->left = $7;
+    $$->right->right = $10;
+}
+;
+
+for_init: type ID EQUALS expression {
+    $$ = create_node("declaration", $2);
+    $$->left = $1;
+    $$->right = $4;
+}
+    | ID EQUALS expression {
+    $$ = create_node("assignment", $1);
+    $$->right = $3;
+}
+    | /* empty */ { $$ = NULL; }
+;
+
+for_condition: expression { $$ = $1; }
+    | /* empty */ { $$ = create_node("number", "1"); }
+;
+
+for_step: ID EQUALS expression {
+    $$ = create_node("assignment", $1);
+    $$->right = $3;
+}
+    | /* empty */ { $$ = NULL; }
+;
+
+// Each case is a scope of its own; falling through runs the statements of
+// the following cases.
+switch_statement: SWITCH LPAREN expression RPAREN LBRACE case_list RBRACE {
+    $$ = create_node("switch", NULL);
+    $$->left = $3;
+    $$->right = $6;
+}
+;
+
+case_list: case_clause { $$ = $1; }
+    | case_list case_clause {
+        ASTNode* current = $1;
+        while (current->next) current = current->next;
+        current->next = $2;
+        $$ = $1;
+    }
+;
+
+case_clause: CASE case_value COLON body {
+    char value[16];
+    sprintf(value, "%d", $2);
+    $$ = create_node("case", value);
+    $$->right = $4;
+}
+    | CASE case_value COLON {
+    char value[16];
+    sprintf(value, "%d", $2);
+    $$ = create_node("case", value);
+}
+    | DEFAULT COLON body {
+    $$ = create_node("default", NULL);
+    $$->right = $3;
+}
+    | DEFAULT COLON { $$ = create_node("default", NULL); }
+;
+
+case_value: NUMBER { $$ = $1; }
+    | MINUS NUMBER { $$ = -$2; }
+;
+
+break_statement: BREAK SEMICOLON { $$ = create_node("break", NULL); }
+;
+
 return_statement: RETURN expression SEMICOLON {
     $$ = create_node("return", NULL);
     $$->right = $2;
@@ -144,19 +334,60 @@ return_statement: RETURN expression SEMICOLON {
 }
 ;
 
-expression: term { $$ = $1; }
-    | expression PLUS term { $$ = create_binary_node("+", $1, $3); }
-    | expression MINUS term { $$ = create_binary_node("-", $1, $3); }
+expression: and_expression { $$ = $1; }
+    | expression OR and_expression { $$ = create_binary_node("||", $1, $3); }
+;
+
+and_expression: equality_expression { $$ = $1; }
+    | and_expression AND equality_expression { $$ = create_binary_node("&&", $1, $3); }
+;
+
+equality_expression: relational_expression { $$ = $1; }
+    | equality_expression EQ relational_expression { $$ = create_binary_node("==", $1, $3); }
+    | equality_expression NEQ relational_expression { $$ = create_binary_node("!=", $1, $3); }
+;
+
+relational_expression: additive_expression { $$ = $1; }
+    | relational_expression LT additive_expression { $$ = create_binary_node("<", $1, $3); }
+    | relational_expression GT additive_expression { $$ = create_binary_node(">", $1, $3); }
+    | relational_expression LTE additive_expression { $$ = create_binary_node("<=", $1, $3); }
+    | relational_expression GTE additive_expression { $$ = create_binary_node(">=", $1, $3); }
+;
+
+additive_expression: term { $$ = $1; }
+    | additive_expression PLUS term { $$ = create_binary_node("+", $1, $3); }
+    | additive_expression MINUS term { $$ = create_binary_node("-", $1, $3); }
 ;
 
 term: factor { $$ = $1; }
     | term TIMES factor { $$ = create_binary_node("*", $1, $3); }
     | term DIVIDE factor { $$ = create_binary_node("/", $1, $3); }
+    | term MOD factor { $$ = create_binary_node("%", $1, $3); }
 ;
 
 factor: NUMBER { $$ = create_node("number", NULL); $$->value = malloc(20); sprintf($$->value, "%d", $1); }
     | ID { $$ = create_node("id", $1); }
+    | ID LBRACKET expression RBRACKET { $$ = create_node("element", $1); $$->left = $3; }
+    | call { $$ = $1; }
     | LPAREN expression RPAREN { $$ = $2; }
+    | NOT factor { $$ = create_binary_node("!", $2, NULL); }
+    | MINUS factor { $$ = create_binary_node("neg", $2, NULL); }
+;
+
+call: ID LPAREN RPAREN { $$ = create_node("call", $1); }
+    | ID LPAREN arg_list RPAREN {
+    $$ = create_node("call", $1);
+    $$->left = $3;
+}
+;
+
+arg_list: expression { $$ = $1; }
+    | arg_list COMMA expression {
+        ASTNode* current = $1;
+        while (current->next) current = current->next;
+        current->next = $3;
+        $$ = $1;
+    }
 ;
 
 %%
@@ -164,7 +395,10 @@ factor: NUMBER { $$ = create_node("number", NULL); $$->value = malloc(20); sprin
 ASTNode* create_node(char* type, char* value) {
     ASTNode* node = (ASTNode*)malloc(sizeof(ASTNode));
     node->type = strdup(type);
-    node->value = value ? strdup(value) : NULL;
+    node->value = value && !holds_literal(node) ? strdup(value) : value;
+    node->depth = node->slot = -1;
+    node->redeclared = 0;
+    node->offset = node_offset;
     node->left = node->right = node->next = NULL;
     return node;
 }
@@ -181,8 +415,8 @@ void free_ast(ASTNode* node) {
         free_ast(node->left);
         free_ast(node->right);
         free_ast(node->next);
+        if (node->value && !holds_literal(node)) free(node->value);
         free(node->type);
-        if (node->value) free(node->value);
         free(node);
     }
 }
@@ -200,16 +434,95 @@ void print_ast(ASTNode* node, int level) {
     print_ast(node->next, level);
 }
 
-void yyerror(char *s) {
-    fprintf(stderr, "Error: %s\n", s);
+// Tokens come from the lexer, or from an array while parse_tokens or
+// parse_lexed runs.
+static Token* token_source;
+static int token_count;
+static int token_next;
+static int token_end;   // parse_lexed's input length, or -1
+
+static int source_token(Token* token) {
+    if (!token_source) {
+        token->kind = lex_token();
+        token->offset = lex_token_start;
+        token->length = lex_offset - lex_token_start;
+        token->value = yylval;
+        return token->kind;
+    }
+    if (token_next == token_count) return 0;
+    *token = token_source[token_next++];
+    return token->kind;
+}
+
+// The token yylex returned last, for yyerror.
+static Token lookahead;
+
+int yylex(void) {
+    if (syntax_error_count == MAX_SYNTAX_ERRORS) {
+        // The directives after the last error still apply.
+        while (preprocess(source_token, &lookahead)) {}
+        return 0;
+    }
+    if (!preprocess(source_token, &lookahead)) return 0;
+    yylval = lookahead.value;
+    yylloc = lookahead.offset;
+    return lookahead.kind;
+}
+
+ASTNode* parse_tokens(Token* tokens, int count, SyntaxError** errors, int* nerrors) {
+    token_source = tokens;
+    token_count = count;
+    token_next = 0;
+    token_end = -1;
+    ast_root = NULL;
+    syntax_error_count = 0;
+    preprocess_restart();
+    int status = yyparse();
+    token_source = NULL;
+    node_offset = -1;
+    *errors = NULL;
+    *nerrors = syntax_error_count;
+    if (status == 0 && syntax_error_count == 0) return ast_root;
+    if (status == 0) free_ast(ast_root);
+    if (syntax_error_count) {
+        *errors = malloc(syntax_error_count * sizeof(SyntaxError));
+        memcpy(*errors, syntax_errors, syntax_error_count * sizeof(SyntaxError));
+    }
+    return NULL;
+}
+
+int parse_lexed(Token* tokens, int count, int length) {
+    token_source = tokens;
+    token_count = count;
+    token_next = 0;
+    token_end = length;
+    ast_root = NULL;
+    syntax_error_count = 0;
+    preprocess_restart();
+    int status = yyparse();
+    token_source = NULL;
+    node_offset = -1;
+    return status;
 }
 
-int main(void) {
-    ASTNode* ast = NULL;
-    yyparse();
-    if (ast) {
-        print_ast(ast, 0);
-        free_ast(ast);
+void syntax_error_at(int offset, int length, const char* message) {
+    if (syntax_error_count == MAX_SYNTAX_ERRORS) return;
+    SyntaxError* error = &syntax_errors[syntax_error_count++];
+    error->offset = offset;
+    error->length = length;
+    snprintf(error->message, sizeof(error->message), "%s", message);
+}
+
+// The error is at the lookahead: at the end of a token array its last
+// token, at the end of the input its end.
+void yyerror(const char *s) {
+    if (yychar != YYEOF) {
+        syntax_error_at(lookahead.offset, lookahead.length, s);
+    } else if (token_source && token_end >= 0) {
+        syntax_error_at(token_end, 0, s);
+    } else if (token_source && token_count > 0) {
+        syntax_error_at(token_source[token_count - 1].offset, token_source[token_count - 1].length, s);
+    } else {
+        syntax_error_at(token_source ? 0 : lex_offset, 0, s);
     }
-    return 0;
-} 
\ No newline at end of file
+}
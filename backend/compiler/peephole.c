@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bytecode.h"
+
+// A rule matches `length` consecutive opcodes. rewrite() writes the
+// replacement (never longer than the match) to out and returns its length,
+// or -1 if the operands do not fit.
+typedef struct {
+    int length;
+    int ops[4];
+    int (*rewrite)(Instr* in, Instr* out);
+} Rule;
+
+static Instr make(int op, int a, int b) {
+    Instr in = { op, a, b };
+    return in;
+}
+
+// ---- clean-ups ----------------------------------------------------------
+
+static int drop_both(Instr* in, Instr* out) {
+    return 0;
+}
+
+static int constant_branch(Instr* in, Instr* out) {
+    if ((in[0].a == 0) != (in[1].op == OP_JUMP_IF_ZERO)) return 0;
+    out[0] = make(OP_JUMP, in[1].a, 0);
+    return 1;
+}
+
+static int inverted_branch(Instr* in, Instr* out) {
+    out[0] = make(in[1].op == OP_JUMP_IF_ZERO ? OP_JUMP_IF_NOT_ZERO : OP_JUMP_IF_ZERO, in[1].a, 0);
+    return 1;
+}
+
+static int identity_add(Instr* in, Instr* out) {
+    return in[0].a == 0 ? 0 : -1;
+}
+
+static int identity_mul(Instr* in, Instr* out) {
+    return in[0].a == 1 ? 0 : -1;
+}
+
+static int self_store(Instr* in, Instr* out) {
+    return in[0].a == in[1].a ? 0 : -1;
+}
+
+static int jump_to_next(Instr* in, Instr* out) {
+    if (in[0].a != in[1].a) return -1;
+    out[0] = in[1];
+    return 1;
+}
+
+static int redundant_trunc(Instr* in, Instr* out) {
+    out[0] = in[1];
+    return 1;
+}
+
+static Rule cleanup_rules[] = {
+    { 2, { OP_PUSH_CONST, OP_JUMP_IF_ZERO }, constant_branch },
+    { 2, { OP_PUSH_CONST, OP_JUMP_IF_NOT_ZERO }, constant_branch },
+    { 2, { OP_NOT, OP_JUMP_IF_ZERO }, inverted_branch },
+    { 2, { OP_NOT, OP_JUMP_IF_NOT_ZERO }, inverted_branch },
+    { 2, { OP_PUSH_CONST, OP_ADD }, identity_add },
+    { 2, { OP_PUSH_CONST, OP_SUB }, identity_add },
+    { 2, { OP_PUSH_CONST, OP_MUL }, identity_mul },
+    { 2, { OP_PUSH_CONST, OP_DIV }, identity_mul },
+    { 2, { OP_PUSH_CONST, OP_POP }, drop_both },
+    { 2, { OP_LOAD_LOCAL, OP_POP }, drop_both },
+    { 2, { OP_LOAD_LOCAL, OP_STORE_LOCAL }, self_store },
+    { 2, { OP_JUMP, OP_LABEL }, jump_to_next },
+    { 2, { OP_TRUNC_CHAR, OP_STORE_CHAR }, redundant_trunc },
+};
+
+// ---- superinstructions --------------------------------------------------
+
+// Picked from `compiler --run --op-pairs` over bench/: the fused pairs
+// account for roughly half of all dispatches there. Increments get a pass
+// of their own first; otherwise the STORE_LOCAL of the statement before
+// fuses with their LOAD_LOCAL.
+
+static int fuse_increment(Instr* in, Instr* out) {
+    if (in[0].a != in[3].a) return -1;
+    out[0] = make(OP_INC_LOCAL, in[0].a, in[2].op == OP_ADD ? in[1].a : (int)(0u - (unsigned)in[1].a));
+    return 1;
+}
+
+static int fuse_pair(Instr* in, Instr* out, int op, int a, int b) {
+    out[0] = make(op, a, b);
+    return 1;
+}
+
+static int fuse_load2(Instr* in, Instr* out) { return fuse_pair(in, out, OP_LOAD_LOCAL2, in[0].a, in[1].a); }
+static int fuse_add_const(Instr* in, Instr* out) { return fuse_pair(in, out, OP_ADD_CONST, in[0].a, 0); }
+static int fuse_sub_const(Instr* in, Instr* out) { return fuse_pair(in, out, OP_SUB_CONST, in[0].a, 0); }
+static int fuse_mul_const(Instr* in, Instr* out) { return fuse_pair(in, out, OP_MUL_CONST, in[0].a, 0); }
+static int fuse_add_local(Instr* in, Instr* out) { return fuse_pair(in, out, OP_ADD_LOCAL, in[0].a, 0); }
+static int fuse_sub_local(Instr* in, Instr* out) { return fuse_pair(in, out, OP_SUB_LOCAL, in[0].a, 0); }
+static int fuse_mul_local(Instr* in, Instr* out) { return fuse_pair(in, out, OP_MUL_LOCAL, in[0].a, 0); }
+static int fuse_store_load(Instr* in, Instr* out) { return fuse_pair(in, out, OP_STORE_LOAD_LOCAL, in[0].a, in[1].a); }
+static int fuse_store_jump(Instr* in, Instr* out) { return fuse_pair(in, out, OP_STORE_JUMP, in[0].a, in[1].a); }
+static int fuse_branch(Instr* in, Instr* out) { return fuse_pair(in, out, OP_JUMP_IF_LOCAL_ZERO, in[0].a, in[1].a); }
+
+// Division by a constant zero keeps the plain DIV and its runtime error.
+static int fuse_div_const(Instr* in, Instr* out) {
+    return in[0].a ? fuse_pair(in, out, OP_DIV_CONST, in[0].a, 0) : -1;
+}
+
+static Rule increment_rules[] = {
+    { 4, { OP_LOAD_LOCAL, OP_PUSH_CONST, OP_ADD, OP_STORE_LOCAL }, fuse_increment },
+    { 4, { OP_LOAD_LOCAL, OP_PUSH_CONST, OP_SUB, OP_STORE_LOCAL }, fuse_increment },
+};
+
+static Rule pair_rules[] = {
+    { 2, { OP_LOAD_LOCAL, OP_JUMP_IF_ZERO }, fuse_branch },
+    { 2, { OP_LOAD_LOCAL, OP_ADD }, fuse_add_local },
+    { 2, { OP_LOAD_LOCAL, OP_SUB }, fuse_sub_local },
+    { 2, { OP_LOAD_LOCAL, OP_MUL }, fuse_mul_local },
+    { 2, { OP_LOAD_LOCAL, OP_LOAD_LOCAL }, fuse_load2 },
+    { 2, { OP_PUSH_CONST, OP_ADD }, fuse_add_const },
+    { 2, { OP_PUSH_CONST, OP_SUB }, fuse_sub_const },
+    { 2, { OP_PUSH_CONST, OP_MUL }, fuse_mul_const },
+    { 2, { OP_PUSH_CONST, OP_DIV }, fuse_div_const },
+    { 2, { OP_STORE_LOCAL, OP_LOAD_LOCAL }, fuse_store_load },
+    { 2, { OP_STORE_LOCAL, OP_JUMP }, fuse_store_jump },
+};
+
+// -------------------------------------------------------------------------
+
+static int matches(Rule* rule, Instr* code, int remaining) {
+    if (rule->length > remaining) return 0;
+    for (int k = 0; k < rule->length; k++) {
+        if (code[k].op != rule->ops[k]) return 0;
+    }
+    return 1;
+}
+
+// One left-to-right pass; the first rule that fires at a position wins.
+// Replacements never grow, so the output is written over the input.
+static int apply_rules(Rule* rules, int nrules, Instr* code, int count, int* changed) {
+    int out = 0;
+    int i = 0;
+
+    while (i < count) {
+        int fired = 0;
+        for (int r = 0; r < nrules && !fired; r++) {
+            Instr replacement[4];
+            int n;
+            if (!matches(&rules[r], &code[i], count - i)) continue;
+            if ((n = rules[r].rewrite(&code[i], replacement)) < 0) continue;
+            memcpy(&code[out], replacement, n * sizeof(Instr));
+            out += n;
+            i += rules[r].length;
+            fired = 1;
+            *changed = 1;
+        }
+        if (!fired) code[out++] = code[i++];
+    }
+    return out;
+}
+
+static int label_target(Instr* code, int count, int label) {
+    for (int i = 0; i < count; i++) {
+        if (code[i].op == OP_LABEL && code[i].a == label) return i;
+    }
+    return -1;
+}
+
+// A jump to a label that is followed by another jump goes straight to the
+// final destination. The hop limit stops on jump cycles (empty loops).
+static void thread_jumps(Instr* code, int count, int* changed) {
+    for (int i = 0; i < count; i++) {
+        if (opcode_jump_operand[code[i].op] != 1) continue;
+        for (int hops = 0; hops < 8; hops++) {
+            int target = label_target(code, count, code[i].a);
+            while (target >= 0 && target < count && code[target].op == OP_LABEL) target++;
+            if (target < 0 || target >= count || code[target].op != OP_JUMP) break;
+            if (code[target].a == code[i].a) break;
+            code[i].a = code[target].a;
+            *changed = 1;
+        }
+    }
+}
+
+// Code after an unconditional transfer is dead until the next label.
+static int remove_unreachable(Instr* code, int count, int* changed) {
+    int out = 0;
+    int dead = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (code[i].op == OP_LABEL) dead = 0;
+        if (dead) {
+            *changed = 1;
+            continue;
+        }
+        code[out++] = code[i];
+        int op = code[i].op;
+        if (op == OP_JUMP || op == OP_RETURN || op == OP_TAIL_CALL || op == OP_HALT) dead = 1;
+    }
+    return out;
+}
+
+int peephole_optimize(Instr* code, int count) {
+    int changed = 1;
+    int nrules = sizeof(cleanup_rules) / sizeof(cleanup_rules[0]);
+
+    while (changed) {
+        changed = 0;
+        thread_jumps(code, count, &changed);
+        count = remove_unreachable(code, count, &changed);
+        count = apply_rules(cleanup_rules, nrules, code, count, &changed);
+    }
+    return count;
+}
+
+int fuse_superinstructions(Instr* code, int count) {
+    int changed = 0;
+    count = apply_rules(increment_rules, sizeof(increment_rules) / sizeof(increment_rules[0]), code, count, &changed);
+    return apply_rules(pair_rules, sizeof(pair_rules) / sizeof(pair_rules[0]), code, count, &changed);
+}
@@ -0,0 +1,574 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "preprocess.h"
+#include "strpool.h"
+#include "syntax.h"
+
+typedef struct {
+    const char* name;       // pooled; NULL in an empty slot
+    int function_like;
+    const char** params;
+    int nparams;
+    Token* body;
+    int length;
+} Macro;
+
+// Open addressing on the pooled name, so most identifiers cost one probe
+// (and none while no macro is defined).
+static Macro* macros;
+static int macro_capacity;  // a power of two
+static int macro_count;
+
+typedef struct {
+    Token* tokens;
+    int count;
+    int capacity;
+} TokenList;
+
+static void append(TokenList* list, const Token* token) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 16;
+        list->tokens = realloc(list->tokens, list->capacity * sizeof(Token));
+    }
+    list->tokens[list->count++] = *token;
+}
+
+// -- The macro table
+
+static int home_slot(const char* name) {
+    return (int)(((uintptr_t)name >> 4) * 2654435761u & (macro_capacity - 1));
+}
+
+static Macro* find_macro(const char* name) {
+    if (macro_count == 0) return NULL;
+    for (int i = home_slot(name);; i = (i + 1) & (macro_capacity - 1)) {
+        if (macros[i].name == name) return &macros[i];
+        if (!macros[i].name) return NULL;
+    }
+}
+
+static void free_macro(Macro* macro) {
+    free(macro->params);
+    free(macro->body);
+    memset(macro, 0, sizeof(Macro));
+}
+
+static void grow_macros(void) {
+    Macro* old = macros;
+    int old_capacity = macro_capacity;
+    macro_capacity = macro_capacity ? macro_capacity * 2 : 32;
+    macros = calloc(macro_capacity, sizeof(Macro));
+    for (int i = 0; i < old_capacity; i++) {
+        if (!old[i].name) continue;
+        int j = home_slot(old[i].name);
+        while (macros[j].name) j = (j + 1) & (macro_capacity - 1);
+        macros[j] = old[i];
+    }
+    free(old);
+}
+
+// Takes ownership of params and body.
+static void define_macro(const char* name, int function_like, const char** params, int nparams, Token* body,
+                         int length) {
+    Macro* macro = find_macro(name);
+    if (macro) {
+        free_macro(macro);
+    } else {
+        if ((macro_count + 1) * 2 > macro_capacity) grow_macros();
+        int i = home_slot(name);
+        while (macros[i].name) i = (i + 1) & (macro_capacity - 1);
+        macro = &macros[i];
+        macro_count++;
+    }
+    macro->name = name;
+    macro->function_like = function_like;
+    macro->params = params;
+    macro->nparams = nparams;
+    macro->body = body;
+    macro->length = length;
+}
+
+static void remove_macro(const char* name) {
+    Macro* macro = find_macro(name);
+    if (!macro) return;
+    free_macro(macro);
+    macro_count--;
+    // Moves later entries of the probe run into the hole where their own
+    // probe would pass it.
+    int mask = macro_capacity - 1;
+    int hole = macro - macros;
+    for (int i = (hole + 1) & mask; macros[i].name; i = (i + 1) & mask) {
+        int home = home_slot(macros[i].name);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            macros[hole] = macros[i];
+            memset(&macros[i], 0, sizeof(Macro));
+            hole = i;
+        }
+    }
+}
+
+// -- Standard headers
+
+typedef struct {
+    const char* name;
+    const char* value;      // tokens separated by spaces
+} Builtin;
+
+typedef struct {
+    const char* name;
+    Builtin macros[6];
+} Header;
+
+static const Header headers[] = {
+    { "stdio.h", { { "EOF", "- 1" }, { "NULL", "0" } } },
+    { "stdlib.h", { { "NULL", "0" }, { "EXIT_SUCCESS", "0" }, { "EXIT_FAILURE", "1" }, { "RAND_MAX", "2147483647" } } },
+    { "limits.h", { { "CHAR_BIT", "8" }, { "CHAR_MIN", "( - 128 )" }, { "CHAR_MAX", "127" },
+                    { "INT_MIN", "( - 2147483647 - 1 )" }, { "INT_MAX", "2147483647" } } },
+    { "stdbool.h", { { "bool", "int" }, { "true", "1" }, { "false", "0" } } },
+    { "stddef.h", { { "NULL", "0" } } },
+    { "string.h", { { "NULL", "0" } } },
+    { "ctype.h", { { NULL } } },
+    { "math.h", { { NULL } } },
+};
+
+static const Header* find_header(const char* name) {
+    for (size_t i = 0; i < sizeof(headers) / sizeof(headers[0]); i++) {
+        if (strcmp(headers[i].name, name) == 0) return &headers[i];
+    }
+    return NULL;
+}
+
+// A builtin value is made of these few tokens; it is never lexed.
+static void builtin_token(const char* word, int length, Token* token) {
+    memset(token, 0, sizeof(Token));
+    if (word[0] >= '0' && word[0] <= '9') {
+        token->kind = NUMBER;
+        token->value.num = atoi(word);
+    } else if (length == 3 && strncmp(word, "int", 3) == 0) {
+        token->kind = INT;
+    } else {
+        token->kind = word[0] == '-' ? MINUS : word[0] == '(' ? LPAREN : RPAREN;
+    }
+}
+
+static void include_header(const Header* header) {
+    for (const Builtin* builtin = header->macros; builtin->name; builtin++) {
+        TokenList body = { 0 };
+        for (const char* p = builtin->value; *p;) {
+            int length = strcspn(p, " ");
+            Token token;
+            builtin_token(p, length, &token);
+            append(&body, &token);
+            p += length;
+            p += strspn(p, " ");
+        }
+        define_macro(intern_literal(builtin->name), 0, NULL, 0, body.tokens, body.count);
+    }
+}
+
+// -- Directives
+
+static void directive_error(Token* at, const char* format, const char* name) {
+    char message[128];
+    snprintf(message, sizeof(message), format, name);
+    syntax_error_at(at->offset, at->length, message);
+}
+
+static int is_named(Token* token, const char* name) {
+    return token->kind == ID && strcmp(token->value.id, name) == 0;
+}
+
+static void include_directive(Token* hash, Token* t, int n) {
+    if (n < 2) {
+        directive_error(hash, "#include expects \"FILENAME\" or <FILENAME>", NULL);
+    } else if (t[1].kind == STRING) {
+        directive_error(&t[1], "%s: only the standard headers can be included", t[1].value.str);
+    } else if (t[1].kind != HEADER_NAME) {
+        directive_error(&t[1], "#include expects \"FILENAME\" or <FILENAME>", NULL);
+    } else if (!find_header(t[1].value.id)) {
+        directive_error(&t[1], "%s: no such header", t[1].value.id);
+    } else {
+        include_header(find_header(t[1].value.id));
+    }
+}
+
+static void define_directive(Token* hash, Token* t, int n) {
+    if (n < 2 || t[1].kind != ID) {
+        directive_error(n < 2 ? hash : &t[1], "macro names must be identifiers", NULL);
+        return;
+    }
+    const char** params = NULL;
+    int nparams = 0;
+    int first = 2;
+    // A parameter list is a "(" right after the name.
+    int function_like = n > 2 && t[2].kind == LPAREN && t[2].offset == t[1].offset + t[1].length;
+    if (function_like) {
+        params = malloc(n * sizeof(char*));
+        first = 3;
+        if (first < n && t[first].kind == RPAREN) {
+            first++;
+        } else {
+            for (;; first += 2) {
+                if (first >= n || t[first].kind != ID) {
+                    directive_error(first < n ? &t[first] : &t[1], "expected parameter name", NULL);
+                    free(params);
+                    return;
+                }
+                for (int i = 0; i < nparams; i++) {
+                    if (params[i] == t[first].value.id) {
+                        directive_error(&t[first], "duplicate macro parameter \"%s\"", t[first].value.id);
+                        free(params);
+                        return;
+                    }
+                }
+                params[nparams++] = t[first].value.id;
+                if (first + 1 < n && t[first + 1].kind == RPAREN) {
+                    first += 2;
+                    break;
+                }
+                if (first + 1 >= n || t[first + 1].kind != COMMA) {
+                    directive_error(first + 1 < n ? &t[first + 1] : &t[first], "expected ',' or ')' in macro parameters",
+                                    NULL);
+                    free(params);
+                    return;
+                }
+            }
+        }
+    }
+    for (int i = first; i < n; i++) {
+        if (t[i].kind == HASH) {
+            directive_error(&t[i], "'#' and '##' are not supported in macros", NULL);
+            free(params);
+            return;
+        }
+    }
+    Token* body = NULL;
+    if (n > first) {
+        body = malloc((n - first) * sizeof(Token));
+        memcpy(body, t + first, (n - first) * sizeof(Token));
+    }
+    define_macro(t[1].value.id, function_like, params, nparams, body, n - first);
+}
+
+// t[0 .. n) are the tokens after hash, up to the end of the line.
+static void run_directive(Token* hash, Token* t, int n) {
+    if (n == 0) return;
+    if (is_named(&t[0], "include")) {
+        include_directive(hash, t, n);
+    } else if (is_named(&t[0], "define")) {
+        define_directive(hash, t, n);
+    } else if (is_named(&t[0], "undef")) {
+        if (n < 2 || t[1].kind != ID) {
+            directive_error(n < 2 ? hash : &t[1], "macro names must be identifiers", NULL);
+        } else {
+            remove_macro(t[1].value.id);
+        }
+    } else if (is_named(&t[0], "pragma")) {
+        // Nothing to do.
+    } else if (t[0].kind == IF || t[0].kind == ELSE) {
+        directive_error(&t[0], "#%s is not supported", t[0].kind == IF ? "if" : "else");
+    } else if (t[0].kind == ID && (strcmp(t[0].value.id, "ifdef") == 0 || strcmp(t[0].value.id, "ifndef") == 0 ||
+                                   strcmp(t[0].value.id, "elif") == 0 || strcmp(t[0].value.id, "endif") == 0 ||
+                                   strcmp(t[0].value.id, "error") == 0 || strcmp(t[0].value.id, "line") == 0)) {
+        directive_error(&t[0], "#%s is not supported", t[0].value.id);
+    } else if (t[0].kind == ID) {
+        directive_error(&t[0], "invalid preprocessing directive #%s", t[0].value.id);
+    } else {
+        directive_error(&t[0], "invalid preprocessing directive", NULL);
+    }
+}
+
+// -- Expansion
+
+// The tokens of one expansion, read before what follows it.
+typedef struct {
+    Token* tokens;
+    int count;
+    int next;
+    const char* macro;      // not expanded again while this is read
+} Frame;
+
+typedef struct Expander {
+    TokenSource source;     // where tokens come from after the frames,
+    Token* input;           // or else this array
+    int ninput;
+    int next_input;
+    Frame* frames;
+    int nframes;
+    int frame_capacity;
+    Token pending;          // a token read ahead and put back
+    int has_pending;
+    int pending_expanded;
+    int expanded;           // whether the last token came from a frame
+    struct Expander* outer; // for an argument, the invocation's expander
+} Expander;
+
+static Expander stream;
+
+static int next_raw(Expander* ex, Token* token) {
+    if (ex->has_pending) {
+        *token = ex->pending;
+        ex->has_pending = 0;
+        ex->expanded = ex->pending_expanded;
+        return token->kind;
+    }
+    // A frame is dropped only once a token past it is wanted, so its macro
+    // stays disabled while the last of its tokens is expanded.
+    while (ex->nframes > 0) {
+        Frame* frame = &ex->frames[ex->nframes - 1];
+        if (frame->next < frame->count) {
+            *token = frame->tokens[frame->next++];
+            ex->expanded = 1;
+            return token->kind;
+        }
+        free(frame->tokens);
+        ex->nframes--;
+    }
+    ex->expanded = 0;
+    if (ex->source) return ex->source(token);
+    if (ex->next_input < ex->ninput) {
+        *token = ex->input[ex->next_input++];
+        return token->kind;
+    }
+    token->kind = 0;
+    return 0;
+}
+
+static int disabled(Expander* ex, const char* name) {
+    for (; ex; ex = ex->outer) {
+        for (int i = 0; i < ex->nframes; i++) {
+            if (ex->frames[i].macro == name) return 1;
+        }
+    }
+    return 0;
+}
+
+static void push_frame(Expander* ex, TokenList* tokens, const char* macro) {
+    if (ex->nframes == ex->frame_capacity) {
+        ex->frame_capacity = ex->frame_capacity ? ex->frame_capacity * 2 : 8;
+        ex->frames = realloc(ex->frames, ex->frame_capacity * sizeof(Frame));
+    }
+    ex->frames[ex->nframes++] = (Frame){ tokens->tokens, tokens->count, 0, macro };
+}
+
+static int next_expanded(Expander* ex, Token* token);
+
+// The arguments of an invocation of macro, after its "(": each fully
+// expanded. Returns the count, or -1 (reported) if the list is not closed.
+static int read_arguments(Expander* ex, Macro* macro, Token* name, TokenList** arguments) {
+    TokenList* raw = calloc(1, sizeof(TokenList));
+    int count = 1;
+    int depth = 0;
+    for (;;) {
+        Token token;
+        int kind = next_raw(ex, &token);
+        if (kind == 0) {
+            directive_error(name, "unterminated argument list invoking macro \"%s\"", macro->name);
+            for (int i = 0; i < count; i++) free(raw[i].tokens);
+            free(raw);
+            return -1;
+        }
+        if (kind == RPAREN && depth == 0) break;
+        if (kind == COMMA && depth == 0) {
+            raw = realloc(raw, (count + 1) * sizeof(TokenList));
+            memset(&raw[count++], 0, sizeof(TokenList));
+            continue;
+        }
+        if (kind == LPAREN) depth++;
+        if (kind == RPAREN) depth--;
+        append(&raw[count - 1], &token);
+    }
+    // F() passes no arguments to a macro without parameters.
+    if (count == 1 && raw[0].count == 0 && macro->nparams == 0) count = 0;
+
+    *arguments = calloc(count ? count : 1, sizeof(TokenList));
+    for (int i = 0; i < count; i++) {
+        Expander sub = { NULL, raw[i].tokens, raw[i].count, 0, NULL, 0, 0, { 0 }, 0, 0, 0, ex };
+        Token token;
+        while (next_expanded(&sub, &token)) append(&(*arguments)[i], &token);
+        free(sub.frames);
+        free(raw[i].tokens);
+    }
+    free(raw);
+    return count;
+}
+
+// Replaces the invocation starting at name with the macro's expansion.
+// Returns 0, leaving name as it is, for a function-like macro without
+// arguments.
+static int expand(Expander* ex, Macro* macro, Token* name) {
+    TokenList out = { 0 };
+    if (macro->function_like) {
+        Token next;
+        if (next_raw(ex, &next) != LPAREN) {
+            ex->pending = next;
+            ex->has_pending = 1;
+            ex->pending_expanded = ex->expanded;
+            return 0;
+        }
+        TokenList* arguments;
+        int count = read_arguments(ex, macro, name, &arguments);
+        if (count < 0) return 1;
+        if (count != macro->nparams) {
+            char message[128];
+            snprintf(message, sizeof(message), "macro \"%s\" expects %d arguments, but %d given", macro->name,
+                     macro->nparams, count);
+            syntax_error_at(name->offset, name->length, message);
+        } else {
+            for (int i = 0; i < macro->length; i++) {
+                Token* token = &macro->body[i];
+                int param = -1;
+                for (int j = 0; token->kind == ID && j < macro->nparams; j++) {
+                    if (macro->params[j] == token->value.id) param = j;
+                }
+                if (param < 0) {
+                    append(&out, token);
+                } else {
+                    for (int j = 0; j < arguments[param].count; j++) append(&out, &arguments[param].tokens[j]);
+                }
+            }
+        }
+        for (int i = 0; i < count; i++) free(arguments[i].tokens);
+        free(arguments);
+    } else {
+        for (int i = 0; i < macro->length; i++) append(&out, &macro->body[i]);
+    }
+    // What an expansion produces is placed at the invocation.
+    for (int i = 0; i < out.count; i++) {
+        out.tokens[i].offset = name->offset;
+        out.tokens[i].length = name->length;
+    }
+    push_frame(ex, &out, macro->name);
+    return 1;
+}
+
+static int next_expanded(Expander* ex, Token* token) {
+    for (;;) {
+        if (!next_raw(ex, token)) return 0;
+        if (token->kind != ID || macro_count == 0) return token->kind;
+        Macro* macro = find_macro(token->value.id);
+        if (!macro || disabled(ex, macro->name)) return token->kind;
+        Token name = *token;
+        if (!expand(ex, macro, &name)) return token->kind;
+    }
+}
+
+// A "#" that a macro argument brings into an expansion starts no
+// directive; the parser rejects it.
+static int next_token(Expander* ex, Token* token) {
+    static TokenList line;
+    for (;;) {
+        int kind = next_expanded(ex, token);
+        if (kind != HASH || ex->expanded) return kind;
+        Token hash = *token;
+        line.count = 0;
+        while (next_raw(ex, token) && token->kind != NEWLINE) append(&line, token);
+        run_directive(&hash, line.tokens, line.count);
+    }
+}
+
+static void clear_frames(Expander* ex) {
+    for (int i = 0; i < ex->nframes; i++) free(ex->frames[i].tokens);
+    ex->nframes = 0;
+    ex->has_pending = 0;
+}
+
+int preprocess(TokenSource source, Token* token) {
+    stream.source = source;
+    return next_token(&stream, token);
+}
+
+void preprocess_restart(void) {
+    clear_frames(&stream);
+}
+
+void preprocess_reset(void) {
+    preprocess_restart();
+    for (int i = 0; i < macro_capacity; i++) {
+        if (macros[i].name) free_macro(&macros[i]);
+    }
+    macro_count = 0;
+}
+
+// The end of the directive starting at tokens[first] (a HASH).
+static int directive_end(Token* tokens, int count, int first) {
+    int end = first + 1;
+    while (end < count && tokens[end].kind != NEWLINE) end++;
+    return end;
+}
+
+void preprocess_directives(Token* tokens, int count, SyntaxError** errors, int* nerrors) {
+    // Expanding what it skips is what tells a directive from the tokens
+    // of a macro argument, as in a parse.
+    Expander ex = { NULL, tokens, count, 0, NULL, 0, 0, { 0 }, 0, 0, 0, NULL };
+    Token token;
+    syntax_error_count = 0;
+    while (next_token(&ex, &token)) {}
+    clear_frames(&ex);
+    free(ex.frames);
+    if (!errors) return;
+    *errors = NULL;
+    *nerrors = syntax_error_count;
+    if (syntax_error_count) {
+        *errors = malloc(syntax_error_count * sizeof(SyntaxError));
+        memcpy(*errors, syntax_errors, syntax_error_count * sizeof(SyntaxError));
+    }
+}
+
+static int add_name(const char*** names, int n, int* capacity, const char* name) {
+    if (n == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 8;
+        *names = realloc(*names, *capacity * sizeof(char*));
+    }
+    (*names)[n] = name;
+    return n + 1;
+}
+
+int preprocess_defined_names(Token* tokens, int count, const char*** names, int n, int* capacity) {
+    for (int i = 0; i < count; i++) {
+        if (tokens[i].kind != HASH) continue;
+        int end = directive_end(tokens, count, i);
+        Token* t = tokens + i + 1;
+        if (end - i > 2 && (is_named(&t[0], "define") || is_named(&t[0], "undef")) && t[1].kind == ID) {
+            n = add_name(names, n, capacity, t[1].value.id);
+        } else if (end - i > 2 && is_named(&t[0], "include") && t[1].kind == HEADER_NAME && find_header(t[1].value.id)) {
+            for (const Builtin* builtin = find_header(t[1].value.id)->macros; builtin->name; builtin++) {
+                n = add_name(names, n, capacity, intern_literal(builtin->name));
+            }
+        }
+        i = end;
+    }
+    return n;
+}
+
+static int is_listed(const char* name, const char** names, int n) {
+    for (int i = 0; i < n; i++) {
+        if (names[i] == name) return 1;
+    }
+    return 0;
+}
+
+// Whether the expansion of macro can involve one of names; past a few
+// macros deep, assume it can.
+static int mentions(Macro* macro, const char** names, int n, int depth) {
+    if (depth == 8) return 1;
+    for (int i = 0; i < macro->length; i++) {
+        if (macro->body[i].kind != ID) continue;
+        if (is_listed(macro->body[i].value.id, names, n)) return 1;
+        Macro* inner = find_macro(macro->body[i].value.id);
+        if (inner && inner != macro && mentions(inner, names, n, depth + 1)) return 1;
+    }
+    return 0;
+}
+
+int preprocess_uses_macros(Token* tokens, int count, const char** names, int n) {
+    for (int i = 0; i < count; i++) {
+        if (tokens[i].kind != ID) continue;
+        if (is_listed(tokens[i].value.id, names, n)) return 1;
+        Macro* macro = find_macro(tokens[i].value.id);
+        if (macro && mentions(macro, names, n, 0)) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef PREPROCESS_H
+#define PREPROCESS_H
+
+#include "document.h"
+
+// The preprocessor, between the lexer and the parser: it carries out the
+// directives in the token stream and expands macros by substituting
+// tokens, so the parser sees neither.
+//
+// #include takes the standard headers only, and reads none of them: each
+// is a builtin set of macros (EOF, NULL, INT_MAX, true, ...). The
+// functions they declare need nothing, since printf and scanf are part
+// of the language. #define makes object-like and function-like macros:
+// arguments are expanded before they are substituted, and a macro is not
+// expanded again inside its own expansion; # and ## are not supported.
+// #undef removes one and #pragma is ignored. Other directives, and
+// conditionals among them, are errors, reported with syntax_error_at
+// like syntax errors.
+//
+// Macros stay defined until preprocess_reset. Not thread-safe.
+
+typedef int (*TokenSource)(Token* token);
+
+// The next token for the parser, reading source as needed. Returns its
+// kind, or 0 at the end.
+int preprocess(TokenSource source, Token* token);
+// Drops what is left of an expansion when a parse stops early.
+void preprocess_restart(void);
+
+// Forgets every macro.
+void preprocess_reset(void);
+// Carries out the directives among tokens and skips the rest, for text
+// that is not parsed (again). If errors is not NULL, *errors (malloc'd)
+// gets the *nerrors errors in them, as from parse_tokens.
+void preprocess_directives(Token* tokens, int count, SyntaxError** errors, int* nerrors);
+
+// For re-parsing part of a document: appends the names of the macros
+// the directives among tokens define or remove to *names (grown as
+// needed) and returns their new count.
+int preprocess_defined_names(Token* tokens, int count, const char*** names, int n, int* capacity);
+// Whether tokens name one of names, or a macro whose expansion may
+// involve one.
+int preprocess_uses_macros(Token* tokens, int count, const char** names, int n);
+
+#endif
@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "regalloc.h"
+
+// Caller-saved registers come first; intervals that live across a call may
+// only use the callee-saved ones, which the prologue saves once.
+static const char* register_names[] = {
+    "rcx", "rsi", "rdi", "r8", "r9", "r10",
+    "rbx", "r12", "r13", "r14", "r15"
+};
+#define CALLER_SAVED 6
+#define NUM_REGISTERS 11
+
+// Each loop level makes a use ten times more expensive to spill.
+#define MAX_LOOP_WEIGHT_DEPTH 4
+
+typedef struct {
+    int start;
+    int end;
+    int nsucc;
+    int succ[2];
+    uint64_t* use;
+    uint64_t* def;
+    uint64_t* live_in;
+    uint64_t* live_out;
+} Block;
+
+typedef struct {
+    int vreg;
+    int start;
+    int end;
+    double weight;
+    int crosses_call;
+} Interval;
+
+typedef struct {
+    IRFunction* fn;
+    int words;
+    Block* blocks;
+    int nblocks;
+    int* block_of;
+    int* depth;
+} Liveness;
+
+static int test_bit(uint64_t* set, int bit) { return (set[bit / 64] >> (bit % 64)) & 1; }
+static void set_bit(uint64_t* set, int bit) { set[bit / 64] |= (uint64_t)1 << (bit % 64); }
+static void clear_bit(uint64_t* set, int bit) { set[bit / 64] &= ~((uint64_t)1 << (bit % 64)); }
+
+// Collects the registers an instruction reads; returns the count.
+static int instr_uses(IRInstr* in, int* uses) {
+    int n = 0;
+    switch (in->op) {
+    case IR_BINARY:
+        uses[n++] = in->a;
+        uses[n++] = in->b;
+        break;
+    case IR_COND_JUMP:
+        uses[n++] = in->a;
+        if (in->b >= 0) uses[n++] = in->b;
+        break;
+    case IR_STORE_ELEM:
+        uses[n++] = in->a;
+        uses[n++] = in->b;
+        break;
+    case IR_MOVE:
+    case IR_UNARY:
+    case IR_CHECK:
+    case IR_LOAD_ELEM:
+    case IR_ARG:
+        uses[n++] = in->a;
+        break;
+    case IR_RETURN:
+        if (in->a >= 0) uses[n++] = in->a;
+        break;
+    default:
+        break;
+    }
+    return n;
+}
+
+static int ends_block(IRInstr* in) {
+    return in->op == IR_JUMP || in->op == IR_COND_JUMP || in->op == IR_RETURN;
+}
+
+static void build_blocks(Liveness* lv) {
+    IRFunction* fn = lv->fn;
+    int* label_block = malloc((fn->nlabels ? fn->nlabels : 1) * sizeof(int));
+
+    lv->block_of = malloc(fn->count * sizeof(int));
+    lv->blocks = calloc(fn->count, sizeof(Block));
+    lv->nblocks = 0;
+    for (int i = 0; i < fn->count; i++) {
+        int leader = i == 0 || fn->code[i].op == IR_LABEL || ends_block(&fn->code[i - 1]);
+        if (leader) {
+            if (lv->nblocks) lv->blocks[lv->nblocks - 1].end = i - 1;
+            lv->blocks[lv->nblocks++].start = i;
+        }
+        lv->block_of[i] = lv->nblocks - 1;
+        if (fn->code[i].op == IR_LABEL) label_block[fn->code[i].label] = lv->nblocks - 1;
+    }
+    lv->blocks[lv->nblocks - 1].end = fn->count - 1;
+
+    for (int b = 0; b < lv->nblocks; b++) {
+        Block* block = &lv->blocks[b];
+        IRInstr* last = &fn->code[block->end];
+        if (last->op == IR_JUMP || last->op == IR_COND_JUMP) block->succ[block->nsucc++] = label_block[last->label];
+        if (last->op != IR_JUMP && last->op != IR_RETURN && b + 1 < lv->nblocks) block->succ[block->nsucc++] = b + 1;
+
+        block->use = calloc(lv->words, sizeof(uint64_t));
+        block->def = calloc(lv->words, sizeof(uint64_t));
+        block->live_in = calloc(lv->words, sizeof(uint64_t));
+        block->live_out = calloc(lv->words, sizeof(uint64_t));
+        for (int i = block->start; i <= block->end; i++) {
+            int uses[2];
+            int n = instr_uses(&fn->code[i], uses);
+            for (int u = 0; u < n; u++) {
+                if (!test_bit(block->def, uses[u])) set_bit(block->use, uses[u]);
+            }
+            if (fn->code[i].dst >= 0) set_bit(block->def, fn->code[i].dst);
+        }
+    }
+    free(label_block);
+}
+
+// Standard backward dataflow: live_out = U live_in(succ),
+// live_in = use | (live_out & ~def), iterated to a fixpoint.
+static void solve_liveness(Liveness* lv) {
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int b = lv->nblocks - 1; b >= 0; b--) {
+            Block* block = &lv->blocks[b];
+            for (int w = 0; w < lv->words; w++) {
+                uint64_t out = 0;
+                for (int s = 0; s < block->nsucc; s++) out |= lv->blocks[block->succ[s]].live_in[w];
+                uint64_t in = block->use[w] | (out & ~block->def[w]);
+                if (out != block->live_out[w] || in != block->live_in[w]) changed = 1;
+                block->live_out[w] = out;
+                block->live_in[w] = in;
+            }
+        }
+    }
+}
+
+// Every backward branch closes a loop around the instructions it spans.
+static void compute_loop_depth(Liveness* lv) {
+    IRFunction* fn = lv->fn;
+    int* label_pos = malloc((fn->nlabels ? fn->nlabels : 1) * sizeof(int));
+
+    lv->depth = calloc(fn->count, sizeof(int));
+    for (int i = 0; i < fn->count; i++) {
+        if (fn->code[i].op == IR_LABEL) label_pos[fn->code[i].label] = i;
+    }
+    for (int i = 0; i < fn->count; i++) {
+        IRInstr* in = &fn->code[i];
+        if ((in->op == IR_JUMP || in->op == IR_COND_JUMP) && label_pos[in->label] <= i) {
+            for (int k = label_pos[in->label]; k <= i; k++) lv->depth[k]++;
+        }
+    }
+    free(label_pos);
+}
+
+static void extend(Interval* iv, int pos) {
+    if (pos < iv->start) iv->start = pos;
+    if (pos > iv->end) iv->end = pos;
+}
+
+static void build_intervals(Liveness* lv, Interval* intervals) {
+    IRFunction* fn = lv->fn;
+    uint64_t* live = malloc(lv->words * sizeof(uint64_t));
+    int* calls_before = malloc((fn->count + 1) * sizeof(int));
+
+    for (int v = 0; v < fn->nvregs; v++) {
+        intervals[v].vreg = v;
+        intervals[v].start = INT_MAX;
+        intervals[v].end = -1;
+        intervals[v].weight = 0;
+        intervals[v].crosses_call = 0;
+    }
+
+    for (int b = 0; b < lv->nblocks; b++) {
+        Block* block = &lv->blocks[b];
+        memcpy(live, block->live_out, lv->words * sizeof(uint64_t));
+        for (int v = 0; v < fn->nvregs; v++) {
+            if (test_bit(live, v)) extend(&intervals[v], block->end);
+        }
+        for (int i = block->end; i >= block->start; i--) {
+            IRInstr* in = &fn->code[i];
+            double weight = 1;
+            int uses[2];
+            int n = instr_uses(in, uses);
+
+            for (int d = 0; d < lv->depth[i] && d < MAX_LOOP_WEIGHT_DEPTH; d++) weight *= 10;
+            if (in->dst >= 0) {
+                extend(&intervals[in->dst], i);
+                intervals[in->dst].weight += weight;
+                clear_bit(live, in->dst);
+            }
+            for (int u = 0; u < n; u++) {
+                extend(&intervals[uses[u]], i);
+                intervals[uses[u]].weight += weight;
+                set_bit(live, uses[u]);
+            }
+        }
+        for (int v = 0; v < fn->nvregs; v++) {
+            if (test_bit(live, v)) extend(&intervals[v], block->start);
+        }
+    }
+
+    calls_before[0] = 0;
+    for (int i = 0; i < fn->count; i++) {
+        calls_before[i + 1] = calls_before[i] + (fn->code[i].op == IR_CALL);
+    }
+    for (int v = 0; v < fn->nvregs; v++) {
+        Interval* iv = &intervals[v];
+        if (iv->end > iv->start) iv->crosses_call = calls_before[iv->end] - calls_before[iv->start + 1] > 0;
+    }
+
+    free(calls_before);
+    free(live);
+}
+
+static double spill_priority(Interval* iv) {
+    return iv->weight / (iv->end - iv->start + 1);
+}
+
+static int compare_start(const void* a, const void* b) {
+    const Interval* x = *(const Interval* const*)a;
+    const Interval* y = *(const Interval* const*)b;
+    if (x->start != y->start) return x->start - y->start;
+    return x->vreg - y->vreg;
+}
+
+static int pick_register(int* busy, int crosses_call) {
+    for (int r = crosses_call ? CALLER_SAVED : 0; r < NUM_REGISTERS; r++) {
+        if (!busy[r]) return r;
+    }
+    return -1;
+}
+
+static void linear_scan(Interval** order, int count, Allocation* alloc) {
+    Interval* active[NUM_REGISTERS];
+    int nactive = 0;
+    int busy[NUM_REGISTERS] = { 0 };
+    int ever_used[NUM_REGISTERS] = { 0 };
+
+    for (int i = 0; i < count; i++) {
+        Interval* cur = order[i];
+
+        // Expire intervals that ended strictly before this one starts: an
+        // operand dying at an instruction must not share the result's register.
+        for (int a = 0; a < nactive; a++) {
+            if (active[a]->end < cur->start) {
+                busy[alloc->reg[active[a]->vreg]] = 0;
+                active[a--] = active[--nactive];
+            }
+        }
+
+        int reg = pick_register(busy, cur->crosses_call);
+        if (reg < 0) {
+            // Spill whichever of the current and the compatible active
+            // intervals is cheapest per instruction it keeps a register.
+            int victim = -1;
+            for (int a = 0; a < nactive; a++) {
+                if (cur->crosses_call && alloc->reg[active[a]->vreg] < CALLER_SAVED) continue;
+                if (victim < 0 || spill_priority(active[a]) < spill_priority(active[victim])) victim = a;
+            }
+            if (victim < 0 || spill_priority(active[victim]) >= spill_priority(cur)) {
+                alloc->spilled++;
+                continue;
+            }
+            reg = alloc->reg[active[victim]->vreg];
+            alloc->reg[active[victim]->vreg] = -1;
+            alloc->spilled++;
+            active[victim] = active[--nactive];
+        }
+
+        alloc->reg[cur->vreg] = reg;
+        busy[reg] = 1;
+        ever_used[reg] = 1;
+        active[nactive++] = cur;
+    }
+
+    for (int r = 0; r < NUM_REGISTERS; r++) alloc->registers_used += ever_used[r];
+}
+
+// Spilled and address-taken variables share a stack slot whenever their
+// live ranges do not overlap.
+static void color_stack_slots(IRFunction* fn, Interval** order, int count, Allocation* alloc) {
+    int* slot_end = malloc((count ? count : 1) * sizeof(int));
+
+    for (int i = 0; i < count; i++) {
+        Interval* iv = order[i];
+        if (alloc->reg[iv->vreg] >= 0) continue;
+
+        int slot = -1;
+        for (int s = 0; s < alloc->slots; s++) {
+            if (slot_end[s] < iv->start) {
+                slot = s;
+                break;
+            }
+        }
+        if (slot < 0) slot = alloc->slots++;
+        slot_end[slot] = iv->end;
+        alloc->slot[iv->vreg] = slot;
+    }
+    alloc->frame_size = (alloc->slots * 8 + fn->array_bytes + 15) & ~15;
+    free(slot_end);
+}
+
+void regalloc_function(IRFunction* fn, Allocation* alloc) {
+    Liveness lv = { fn, (fn->nvregs + 63) / 64, NULL, 0, NULL, NULL };
+    Interval* intervals = malloc((fn->nvregs ? fn->nvregs : 1) * sizeof(Interval));
+    Interval** order = malloc((fn->nvregs ? fn->nvregs : 1) * sizeof(Interval*));
+    Interval** memory = malloc((fn->nvregs ? fn->nvregs : 1) * sizeof(Interval*));
+    int count = 0;
+    int nmemory = 0;
+
+    memset(alloc, 0, sizeof(Allocation));
+    alloc->nvregs = fn->nvregs;
+    alloc->reg = malloc((fn->nvregs ? fn->nvregs : 1) * sizeof(int));
+    alloc->slot = malloc((fn->nvregs ? fn->nvregs : 1) * sizeof(int));
+    for (int v = 0; v < fn->nvregs; v++) alloc->reg[v] = alloc->slot[v] = -1;
+
+    build_blocks(&lv);
+    solve_liveness(&lv);
+    compute_loop_depth(&lv);
+    build_intervals(&lv, intervals);
+
+    for (int v = 0; v < fn->nvregs; v++) {
+        if (intervals[v].end < 0) continue;
+        alloc->intervals++;
+        if (fn->address_taken[v]) {
+            memory[nmemory++] = &intervals[v];
+            alloc->memory_vars++;
+        } else {
+            order[count++] = &intervals[v];
+        }
+    }
+    qsort(order, count, sizeof(Interval*), compare_start);
+    linear_scan(order, count, alloc);
+
+    for (int i = 0; i < nmemory; i++) order[count++] = memory[i];
+    qsort(order, count, sizeof(Interval*), compare_start);
+    color_stack_slots(fn, order, count, alloc);
+
+    for (int b = 0; b < lv.nblocks; b++) {
+        free(lv.blocks[b].use);
+        free(lv.blocks[b].def);
+        free(lv.blocks[b].live_in);
+        free(lv.blocks[b].live_out);
+    }
+    free(lv.blocks);
+    free(lv.block_of);
+    free(lv.depth);
+    free(memory);
+    free(order);
+    free(intervals);
+}
+
+void regalloc_free(Allocation* alloc) {
+    free(alloc->reg);
+    free(alloc->slot);
+}
+
+const char* regalloc_register_name(int reg) {
+    return reg >= 0 && reg < NUM_REGISTERS ? register_names[reg] : "stack";
+}
+
+void regalloc_print_stats(IRProgram* program, FILE* out) {
+    Allocation total;
+
+    memset(&total, 0, sizeof(Allocation));
+    fprintf(out, "%-20s %8s %8s %8s %8s %8s %8s %8s\n",
+            "function", "vregs", "ranges", "regs", "spilled", "memory", "slots", "frame");
+    for (int i = 0; i < program->count; i++) {
+        IRFunction* fn = &program->functions[i];
+        Allocation alloc;
+        regalloc_function(fn, &alloc);
+        fprintf(out, "%-20s %8d %8d %8d %8d %8d %8d %8d\n", fn->name, fn->nvregs, alloc.intervals,
+                alloc.registers_used, alloc.spilled, alloc.memory_vars, alloc.slots, alloc.frame_size);
+        total.nvregs += fn->nvregs;
+        total.intervals += alloc.intervals;
+        total.spilled += alloc.spilled;
+        total.memory_vars += alloc.memory_vars;
+        total.slots += alloc.slots;
+        total.frame_size += alloc.frame_size;
+        regalloc_free(&alloc);
+    }
+    fprintf(out, "%-20s %8d %8d %8s %8d %8d %8d %8d\n", "total", total.nvregs, total.intervals, "-",
+            total.spilled, total.memory_vars, total.slots, total.frame_size);
+}
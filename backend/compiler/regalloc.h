@@ -0,0 +1,29 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+#include <stdio.h>
+#include "ir.h"
+
+// Linear-scan register allocation over the x86-64 System V register set.
+// rax, rdx and r11 are kept free for returns, division and spill reloads;
+// rsp and rbp hold the frame.
+typedef struct {
+    int nvregs;
+    int* reg;            // physical register per vreg, -1 if not in a register
+    int* slot;           // stack slot per vreg, -1 if not on the stack
+    int intervals;       // vregs with a non-empty live range
+    int spilled;         // intervals that did not get a register
+    int memory_vars;     // address-taken variables, always on the stack
+    int slots;           // stack slots after coloring
+    int frame_size;      // bytes of spill area and local arrays, 16-byte aligned
+    int registers_used;
+} Allocation;
+
+void regalloc_function(IRFunction* fn, Allocation* alloc);
+void regalloc_free(Allocation* alloc);
+const char* regalloc_register_name(int reg);
+
+// One row per function plus totals: live intervals, spills and frame size.
+void regalloc_print_stats(IRProgram* program, FILE* out);
+
+#endif
@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <string.h>
+#include "runtime.h"
+
+static char output[RUNTIME_BUFFER_SIZE];
+static int output_length;
+
+static unsigned char input[RUNTIME_BUFFER_SIZE];
+static int input_position;
+static int input_length;
+
+// "00" "01" ... "99": integers are converted two digits at a time.
+static const char digit_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+void runtime_flush(void) {
+    if (output_length) fwrite(output, 1, output_length, stdout);
+    output_length = 0;
+    fflush(stdout);
+}
+
+static void write_text(const char* text, int length) {
+    if (output_length + length > RUNTIME_BUFFER_SIZE) {
+        fwrite(output, 1, output_length, stdout);
+        output_length = 0;
+        if (length > RUNTIME_BUFFER_SIZE) {
+            fwrite(text, 1, length, stdout);
+            return;
+        }
+    }
+    memcpy(output + output_length, text, length);
+    output_length += length;
+}
+
+static void write_int(int value) {
+    char digits[12];
+    char* end = digits + sizeof(digits);
+    char* p = end;
+    unsigned magnitude = value < 0 ? 0u - (unsigned)value : (unsigned)value;
+
+    while (magnitude >= 100) {
+        unsigned pair = magnitude % 100 * 2;
+        magnitude /= 100;
+        *--p = digit_pairs[pair + 1];
+        *--p = digit_pairs[pair];
+    }
+    if (magnitude >= 10) {
+        *--p = digit_pairs[magnitude * 2 + 1];
+        *--p = digit_pairs[magnitude * 2];
+    } else {
+        *--p = (char)('0' + magnitude);
+    }
+    if (value < 0) *--p = '-';
+    write_text(p, end - p);
+}
+
+void runtime_printf(const Format* format, const int* args, int nargs) {
+    int next = 0;
+    for (int i = 0; i < format->count; i++) {
+        const FormatOp* op = &format->ops[i];
+        int value = op->kind != FORMAT_TEXT && next < nargs ? args[next++] : 0;
+        if (op->kind == FORMAT_TEXT) {
+            write_text(op->text, op->length);
+        } else if (op->kind == FORMAT_INT) {
+            write_int(value);
+        } else {
+            char ch = (char)value;
+            write_text(&ch, 1);
+        }
+    }
+}
+
+// Next input byte without consuming it, EOF at the end of the input.
+static int peek_input(void) {
+    if (input_position == input_length) {
+        input_length = (int)fread(input, 1, sizeof(input), stdin);
+        input_position = 0;
+        if (input_length <= 0) {
+            input_length = 0;
+            return EOF;
+        }
+    }
+    return input[input_position];
+}
+
+static int is_space(int ch) {
+    return ch == ' ' || (ch >= '\t' && ch <= '\r');
+}
+
+static int skip_spaces(void) {
+    int ch = peek_input();
+    while (is_space(ch)) {
+        input_position++;
+        ch = peek_input();
+    }
+    return ch;
+}
+
+// Whitespace in the format skips any run of input whitespace; any other
+// character has to come next in the input.
+static int match_text(const char* text, int length) {
+    for (int i = 0; i < length; i++) {
+        if (is_space((unsigned char)text[i])) {
+            skip_spaces();
+        } else if (peek_input() == (unsigned char)text[i]) {
+            input_position++;
+        } else {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static int read_int(int* target) {
+    int ch = skip_spaces();
+    int negative = ch == '-';
+    if (ch == '-' || ch == '+') {
+        input_position++;
+        ch = peek_input();
+    }
+    if (ch < '0' || ch > '9') return 0;
+
+    unsigned value = 0;
+    while (ch >= '0' && ch <= '9') {
+        value = value * 10 + (unsigned)(ch - '0');
+        input_position++;
+        ch = peek_input();
+    }
+    *target = (int)(negative ? 0u - value : value);
+    return 1;
+}
+
+void runtime_scanf(const Format* format, int* targets, int ntargets) {
+    int next = 0;
+    for (int i = 0; i < format->count; i++) {
+        const FormatOp* op = &format->ops[i];
+        if (op->kind == FORMAT_TEXT) {
+            if (!match_text(op->text, op->length)) return;
+        } else if (next == ntargets) {
+            return;
+        } else if (op->kind == FORMAT_INT) {
+            if (!read_int(&targets[next])) return;
+            next++;
+        } else {
+            int ch = peek_input();
+            if (ch == EOF) return;
+            input_position++;
+            targets[next++] = ch;
+        }
+    }
+}
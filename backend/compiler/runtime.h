@@ -0,0 +1,22 @@
+#ifndef RUNTIME_H
+#define RUNTIME_H
+
+#include "format.h"
+
+// Buffered I/O for programs run by the VM. Output collects in a
+// RUNTIME_BUFFER_SIZE buffer that is written out when full and by
+// runtime_flush; input is read from stdin in blocks of the same size.
+#define RUNTIME_BUFFER_SIZE (1 << 16)
+
+// printf: conversions beyond nargs print as 0.
+void runtime_printf(const Format* format, const int* args, int nargs);
+
+// scanf: fills targets in order and stops at the first conversion or
+// literal character that does not match, leaving the remaining targets
+// unchanged. %d skips whitespace and reads an optional sign and decimal
+// digits; %c reads the next character.
+void runtime_scanf(const Format* format, int* targets, int ntargets);
+
+void runtime_flush(void);
+
+#endif
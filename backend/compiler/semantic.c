@@ -0,0 +1,310 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include "semantic.h"
+#include "switch.h"
+
+typedef struct {
+    const char* name;
+    ASTNode* function;
+    int nparams;
+} Signature;
+
+typedef struct {
+    Signature* functions;   // sorted by name
+    int nfunctions;
+    ASTNode** globals;      // global arrays by slot
+    int nglobals;
+    ASTNode** bodies;       // functions in source order
+    int nbodies;
+} ProgramInfo;
+
+// Messages of one function, printed after all functions are checked.
+typedef struct {
+    char* text;
+    size_t length;
+    size_t capacity;
+    int errors;
+} Diagnostics;
+
+typedef struct {
+    const ProgramInfo* info;
+    ASTNode* function;
+    ASTNode** vars;         // declaration of each live slot
+    int vars_capacity;
+    int breakable;          // enclosing loops and switches
+    Diagnostics* out;
+} Checker;
+
+static void append(Diagnostics* out, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (out->length + n + 1 > out->capacity) {
+        out->capacity = (out->length + n + 1) * 2;
+        out->text = realloc(out->text, out->capacity);
+    }
+    va_start(args, format);
+    vsnprintf(out->text + out->length, n + 1, format, args);
+    va_end(args);
+    out->length += n;
+}
+
+// Same wording as the errors of the bytecode compiler.
+static void error(Diagnostics* out, ASTNode* function, const char* message, const char* name) {
+    if (node_is(function, "function")) {
+        append(out, "Error: %s '%s' in function %s\n", message, name, function->value);
+    } else {
+        append(out, "Error: %s '%s'\n", message, name);
+    }
+    out->errors++;
+}
+
+static int is_void(ASTNode* type) {
+    return type && strcmp(type->value, "void") == 0;
+}
+
+static int compare_signatures(const void* a, const void* b) {
+    return strcmp(((const Signature*)a)->name, ((const Signature*)b)->name);
+}
+
+static const Signature* find_signature(const ProgramInfo* info, const char* name) {
+    Signature key = { name, NULL, 0 };
+    return bsearch(&key, info->functions, info->nfunctions, sizeof(Signature), compare_signatures);
+}
+
+// ---- per-function checks ------------------------------------------------------
+
+static void check_expr(Checker* ck, ASTNode* expr, int want_value);
+static void check_list(Checker* ck, ASTNode* list);
+
+static void report(Checker* ck, const char* message, const char* name) {
+    error(ck->out, ck->function, message, name);
+}
+
+static void declare(Checker* ck, ASTNode* declaration) {
+    if (is_void(declaration->left)) report(ck, "variable declared void", declaration->value);
+    if (declaration->redeclared) report(ck, "redeclaration of", declaration->value);
+    if (declaration->slot < 0) return;
+    if (declaration->slot >= ck->vars_capacity) {
+        ck->vars_capacity = declaration->slot * 2 + 16;
+        ck->vars = realloc(ck->vars, ck->vars_capacity * sizeof(ASTNode*));
+    }
+    ck->vars[declaration->slot] = declaration;
+}
+
+// The declaration a resolved reference points to, NULL if undeclared.
+static ASTNode* declaration_of(Checker* ck, ASTNode* ref) {
+    if (ref->depth < 0) {
+        report(ck, "undeclared variable", ref->value);
+        return NULL;
+    }
+    return ref->depth == 0 ? ck->info->globals[ref->slot] : ck->vars[ref->slot];
+}
+
+static void check_scalar(Checker* ck, ASTNode* ref) {
+    ASTNode* declaration = declaration_of(ck, ref);
+    if (node_is(declaration, "array-declaration")) report(ck, "array used as a value", ref->value);
+}
+
+static void check_element(Checker* ck, ASTNode* access) {
+    ASTNode* declaration = declaration_of(ck, access);
+    if (declaration && !node_is(declaration, "array-declaration")) {
+        report(ck, "subscripted value is not an array", access->value);
+    }
+    check_expr(ck, access->left, 1);
+}
+
+static void check_call(Checker* ck, ASTNode* call, int want_value) {
+    const Signature* callee = find_signature(ck->info, call->value);
+    int nargs = 0;
+
+    for (ASTNode* arg = call->left; arg; arg = arg->next, nargs++) check_expr(ck, arg, 1);
+    if (!callee) {
+        report(ck, "call to undefined function", call->value);
+    } else if (callee->nparams != nargs) {
+        report(ck, "wrong number of arguments to", call->value);
+    } else if (want_value && is_void(callee->function->left)) {
+        report(ck, "use of the result of void function", call->value);
+    }
+}
+
+static void check_expr(Checker* ck, ASTNode* expr, int want_value) {
+    if (!expr || node_is(expr, "number")) return;
+    if (node_is(expr, "id")) {
+        check_scalar(ck, expr);
+    } else if (node_is(expr, "element") || node_is(expr, "unchecked-element")) {
+        check_element(ck, expr);
+    } else if (node_is(expr, "call") || node_is(expr, "tail-call")) {
+        check_call(ck, expr, want_value);
+    } else {
+        check_expr(ck, expr->left, 1);
+        check_expr(ck, expr->right, 1);
+    }
+}
+
+static void check_switch(Checker* ck, ASTNode* stmt) {
+    SwitchPlan plan;
+
+    check_expr(ck, stmt->left, 1);
+    plan_switch(stmt, &plan);
+    if (plan.has_duplicate) {
+        char value[16];
+        sprintf(value, "%d", plan.duplicate);
+        report(ck, "duplicate case value", value);
+    }
+    if (plan.defaults > 1) report(ck, "multiple labels", "default");
+    free_switch_plan(&plan);
+
+    ck->breakable++;
+    for (ASTNode* clause = stmt->right; clause; clause = clause->next) check_list(ck, clause->right);
+    ck->breakable--;
+}
+
+static void check_statement(Checker* ck, ASTNode* stmt) {
+    if (node_is(stmt, "declaration")) {
+        check_expr(ck, stmt->right, 1);
+        declare(ck, stmt);
+    } else if (node_is(stmt, "array-declaration")) {
+        if (atoi(stmt->right->value) <= 0) report(ck, "invalid size for array", stmt->value);
+        declare(ck, stmt);
+    } else if (node_is(stmt, "assignment")) {
+        check_scalar(ck, stmt);
+        check_expr(ck, stmt->right, 1);
+    } else if (node_is(stmt, "element-assignment") || node_is(stmt, "unchecked-element-assignment")) {
+        check_element(ck, stmt);
+        check_expr(ck, stmt->right, 1);
+    } else if (node_is(stmt, "if")) {
+        check_expr(ck, stmt->left, 1);
+        check_list(ck, stmt->right);
+    } else if (node_is(stmt, "if-else")) {
+        check_expr(ck, stmt->left, 1);
+        check_list(ck, stmt->right->left);
+        check_list(ck, stmt->right->right);
+    } else if (node_is(stmt, "while")) {
+        check_expr(ck, stmt->left, 1);
+        ck->breakable++;
+        check_list(ck, stmt->right);
+        ck->breakable--;
+    } else if (node_is(stmt, "for") || node_is(stmt, "vector-for")) {
+        check_list(ck, stmt->left->left);
+        check_expr(ck, stmt->left->right, 1);
+        ck->breakable++;
+        check_list(ck, stmt->right->right);
+        ck->breakable--;
+        check_list(ck, stmt->right->left);
+    } else if (node_is(stmt, "switch")) {
+        check_switch(ck, stmt);
+    } else if (node_is(stmt, "break")) {
+        if (!ck->breakable) report(ck, "misplaced", "break");
+    } else if (node_is(stmt, "block") || node_is(stmt, "tail-loop")) {
+        check_list(ck, stmt->right);
+    } else if (node_is(stmt, "return")) {
+        int returns_void = is_void(ck->function->left);
+        if (stmt->right && returns_void) report(ck, "unexpected value for", "return");
+        if (!stmt->right && !returns_void) report(ck, "missing value for", "return");
+        check_expr(ck, stmt->right, 1);
+    } else if (node_is(stmt, "call")) {
+        check_call(ck, stmt, 0);
+    } else if (node_is(stmt, "tail-jump") || node_is(stmt, "printf")) {
+        for (ASTNode* arg = stmt->left; arg; arg = arg->next) check_expr(ck, arg, 1);
+    } else if (node_is(stmt, "scanf")) {
+        for (ASTNode* target = stmt->left; target; target = target->next) {
+            if (target->left) check_element(ck, target);
+            else check_scalar(ck, target);
+        }
+    }
+}
+
+static void check_list(Checker* ck, ASTNode* list) {
+    for (ASTNode* stmt = list; stmt; stmt = stmt->next) check_statement(ck, stmt);
+}
+
+typedef struct {
+    const ProgramInfo* info;
+    Diagnostics* results;   // one per function
+} CheckRun;
+
+// Runs on a pool thread: reads the AST and ProgramInfo, writes only its
+// own Diagnostics.
+static void check_function(void* context, int task) {
+    CheckRun* run = context;
+    ASTNode* function = run->info->bodies[task];
+    Checker ck = { run->info, function, NULL, 0, 0, &run->results[task] };
+
+    for (ASTNode* param = function->right->left; param; param = param->next) declare(&ck, param);
+    check_list(&ck, function->right->right);
+    free(ck.vars);
+}
+
+// ---- program -----------------------------------------------------------------
+
+int check_program(ASTNode* program, ThreadPool* pool) {
+    ProgramInfo info;
+    Diagnostics globals = { NULL, 0, 0, 0 };
+    int errors;
+
+    memset(&info, 0, sizeof(info));
+    for (ASTNode* node = program; node; node = node->next) {
+        if (node_is(node, "function")) info.nbodies++;
+        else if (node_is(node, "array-declaration")) info.nglobals++;
+    }
+    info.bodies = malloc((info.nbodies ? info.nbodies : 1) * sizeof(ASTNode*));
+    info.functions = malloc((info.nbodies ? info.nbodies : 1) * sizeof(Signature));
+    info.globals = malloc((info.nglobals ? info.nglobals : 1) * sizeof(ASTNode*));
+
+    // Symbol collection: everything the per-function checks share.
+    info.nbodies = info.nglobals = 0;
+    for (ASTNode* node = program; node; node = node->next) {
+        if (node_is(node, "array-declaration")) {
+            if (is_void(node->left)) error(&globals, node, "variable declared void", node->value);
+            if (atoi(node->right->value) <= 0) error(&globals, node, "invalid size for array", node->value);
+            for (int i = 0; i < info.nglobals; i++) {
+                if (strcmp(info.globals[i]->value, node->value) == 0) error(&globals, node, "redefinition of", node->value);
+            }
+            info.globals[info.nglobals++] = node;
+        } else if (node_is(node, "function")) {
+            Signature* signature = &info.functions[info.nfunctions++];
+            signature->name = node->value;
+            signature->function = node;
+            signature->nparams = 0;
+            for (ASTNode* param = node->right->left; param; param = param->next) signature->nparams++;
+            info.bodies[info.nbodies++] = node;
+        }
+    }
+    // A stable order keeps the first definition of a redefined function.
+    for (int i = 1; i < info.nfunctions; i++) {
+        Signature key = info.functions[i];
+        int j = i;
+        for (; j > 0 && strcmp(info.functions[j - 1].name, key.name) > 0; j--) info.functions[j] = info.functions[j - 1];
+        info.functions[j] = key;
+    }
+    for (int i = 1; i < info.nfunctions; i++) {
+        if (strcmp(info.functions[i].name, info.functions[i - 1].name) == 0) {
+            error(&globals, info.functions[i].function, "redefinition of", info.functions[i].name);
+        }
+    }
+    if (!find_signature(&info, "main")) {
+        append(&globals, "Error: no main function\n");
+        globals.errors++;
+    }
+
+    CheckRun run = { &info, calloc(info.nbodies ? info.nbodies : 1, sizeof(Diagnostics)) };
+    thread_pool_run(pool, info.nbodies, check_function, &run);
+
+    errors = globals.errors;
+    if (globals.length) fputs(globals.text, stderr);
+    for (int i = 0; i < info.nbodies; i++) {
+        if (run.results[i].length) fputs(run.results[i].text, stderr);
+        errors += run.results[i].errors;
+        free(run.results[i].text);
+    }
+    free(run.results);
+    free(globals.text);
+    free(info.bodies);
+    free(info.functions);
+    free(info.globals);
+    return errors;
+}
@@ -0,0 +1,19 @@
+#ifndef SEMANTIC_H
+#define SEMANTIC_H
+
+#include "ast.h"
+#include "threadpool.h"
+
+// Semantic checks on a resolved program (see resolve_symbols): variables
+// declared void or twice in one scope (parameters included), undeclared
+// variables, arrays used as values and scalars subscripted, calls to
+// unknown functions, wrong argument counts, results of void functions used
+// as values, returns that do not match the return type, break outside a
+// loop or switch and bad case labels.
+//
+// Functions and global arrays are collected first; the functions are then
+// checked independently on the pool. Diagnostics go to stderr in source
+// order whatever the number of threads. Returns the number of errors.
+int check_program(ASTNode* program, ThreadPool* pool);
+
+#endif
@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "stats.h"
+
+static const char* phase_names[PHASE_COUNT] = {
+    "lex", "parse", "semantic", "tail_calls", "bounds_checks", "vectorize", "unroll", "resolve", "fold_pure_calls",
+    "codegen", "execute",
+};
+
+typedef struct {
+    int runs;
+    double wall;            // seconds
+    double cpu;
+    long allocations;
+    long peak_rss;          // KiB, when the phase last ended
+    double started_wall;
+    double started_cpu;
+    long started_allocations;
+} PhaseStats;
+
+typedef struct {
+    const char* name;
+    long value;
+} Count;
+
+#define MAX_COUNTS 16
+
+static int enabled;
+static double enabled_wall, enabled_cpu;
+static PhaseStats phases[PHASE_COUNT];
+static Count counts[MAX_COUNTS];
+static int ncounts;
+
+// Updated from any thread, so atomically.
+static long allocations, reallocations, frees, allocated_bytes;
+
+static double clock_seconds(clockid_t clock) {
+    struct timespec t;
+    clock_gettime(clock, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static long peak_rss(void) {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+void stats_enable(void) {
+    enabled = 1;
+    enabled_wall = clock_seconds(CLOCK_MONOTONIC);
+    enabled_cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+}
+
+void stats_begin(Phase phase) {
+    if (!enabled) return;
+    PhaseStats* stats = &phases[phase];
+    stats->started_wall = clock_seconds(CLOCK_MONOTONIC);
+    stats->started_cpu = clock_seconds(CLOCK_PROCESS_CPUTIME_ID);
+    stats->started_allocations = __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+}
+
+void stats_end(Phase phase) {
+    if (!enabled) return;
+    PhaseStats* stats = &phases[phase];
+    stats->runs++;
+    stats->wall += clock_seconds(CLOCK_MONOTONIC) - stats->started_wall;
+    stats->cpu += clock_seconds(CLOCK_PROCESS_CPUTIME_ID) - stats->started_cpu;
+    stats->allocations += __atomic_load_n(&allocations, __ATOMIC_RELAXED) - stats->started_allocations;
+    stats->peak_rss = peak_rss();
+}
+
+void stats_count(const char* name, long value) {
+    if (!enabled) return;
+    int i = 0;
+    while (i < ncounts && strcmp(counts[i].name, name) != 0) i++;
+    if (i == MAX_COUNTS) return;
+    if (i == ncounts) ncounts++;
+    counts[i] = (Count){ name, value };
+}
+
+int stats_count_nodes(ASTNode* node) {
+    int count = 0;
+    for (; node; node = node->next) count += 1 + stats_count_nodes(node->left) + stats_count_nodes(node->right);
+    return count;
+}
+
+void stats_write(FILE* out) {
+    fputs("{\"phases\":[", out);
+    int first = 1;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        PhaseStats* stats = &phases[i];
+        if (!stats->runs) continue;
+        fprintf(out, "%s{\"name\":\"%s\",\"wall_ms\":%.3f,\"cpu_ms\":%.3f,\"allocations\":%ld,\"peak_rss_kb\":%ld}",
+                first ? "" : ",", phase_names[i], stats->wall * 1e3, stats->cpu * 1e3, stats->allocations,
+                stats->peak_rss);
+        first = 0;
+    }
+    fprintf(out, "],\"total\":{\"wall_ms\":%.3f,\"cpu_ms\":%.3f},\"peak_rss_kb\":%ld,",
+            (clock_seconds(CLOCK_MONOTONIC) - enabled_wall) * 1e3,
+            (clock_seconds(CLOCK_PROCESS_CPUTIME_ID) - enabled_cpu) * 1e3, peak_rss());
+    fprintf(out, "\"memory\":{\"allocations\":%ld,\"reallocations\":%ld,\"frees\":%ld,\"allocated_bytes\":%ld},",
+            allocations, reallocations, frees, allocated_bytes);
+    fputs("\"counts\":{", out);
+    for (int i = 0; i < ncounts; i++) fprintf(out, "%s\"%s\":%ld", i ? "," : "", counts[i].name, counts[i].value);
+    fputs("}}\n", out);
+}
+
+// -- Allocation counting; the linker sends every call to these.
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+char* __real_strdup(const char* text);
+void __real_free(void* pointer);
+
+static void count_allocation(long* counter, size_t size) {
+    __atomic_fetch_add(counter, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&allocated_bytes, (long)size, __ATOMIC_RELAXED);
+}
+
+void* __wrap_malloc(size_t size) {
+    if (enabled) count_allocation(&allocations, size);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    if (enabled) count_allocation(&allocations, count * size);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+    if (enabled) count_allocation(pointer ? &reallocations : &allocations, size);
+    return __real_realloc(pointer, size);
+}
+
+char* __wrap_strdup(const char* text) {
+    if (enabled) count_allocation(&allocations, strlen(text) + 1);
+    return __real_strdup(text);
+}
+
+void __wrap_free(void* pointer) {
+    if (enabled && pointer) __atomic_fetch_add(&frees, 1, __ATOMIC_RELAXED);
+    __real_free(pointer);
+}
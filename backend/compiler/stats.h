@@ -0,0 +1,43 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include "ast.h"
+
+// --stats: wall and CPU time per compiler phase, peak memory, counts of
+// tokens, nodes and the like, and allocation counts, written as one line
+// of JSON.
+//
+// CPU time is the whole process's, so a phase run on the thread pool can
+// take more of it than wall time. Allocations are counted by wrapping
+// malloc, calloc, realloc, strdup and free at link time (-Wl,--wrap, see
+// the Makefile): they cover the compiler's own calls, not the C
+// library's. Nothing is counted or timed until stats_enable.
+
+typedef enum {
+    PHASE_LEX,
+    PHASE_PARSE,            // with preprocessing
+    PHASE_SEMANTIC,
+    PHASE_TAIL_CALLS,
+    PHASE_BOUNDS_CHECKS,
+    PHASE_VECTORIZE,
+    PHASE_UNROLL,
+    PHASE_RESOLVE,          // resolving symbols again after the rewrites
+    PHASE_FOLD_PURE_CALLS,
+    PHASE_CODEGEN,          // IR lowering, or bytecode with its peephole passes
+    PHASE_EXECUTE,
+    PHASE_COUNT
+} Phase;
+
+void stats_enable(void);
+// Phases may run more than once; their times add up.
+void stats_begin(Phase phase);
+void stats_end(Phase phase);
+// Records a count under name (a literal), replacing any earlier value.
+void stats_count(const char* name, long value);
+int stats_count_nodes(ASTNode* node);
+
+// Writes everything recorded so far.
+void stats_write(FILE* out);
+
+#endif
@@ -0,0 +1,184 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include "strpool.h"
+
+#define POOL_BLOCK_SIZE 4096
+#define POOL_SHARD_BITS 6
+#define POOL_SHARDS (1 << POOL_SHARD_BITS)
+#define POOL_SEGMENT_BASE 64
+#define POOL_SEGMENTS 20        // 64 << 20 entries per shard, 2^26 ids
+
+// A handle is (index << POOL_SHARD_BITS | shard), index counting the
+// strings of its shard. Entries live in segments of 64, 128, 256, ...
+// that are never moved, so an id stays valid while the shard grows.
+typedef struct {
+    const char* text;
+    unsigned hash;
+    unsigned length;
+} PoolEntry;
+
+// Strings are packed into blocks that are never moved.
+typedef struct PoolBlock {
+    struct PoolBlock* next;
+    size_t used;
+    size_t size;
+    char data[];
+} PoolBlock;
+
+// Open addressing with linear probing, at most half full. A slot holds
+// id + 1 (0 when free) and is written once, with release order, after
+// its entry is complete. When the table grows the old one is kept until
+// free_string_pool, so a reader still probing it stays safe; it may miss
+// strings added since, and then retries under the lock.
+typedef struct PoolTable {
+    struct PoolTable* retired;
+    unsigned capacity;          // a power of two
+    StringId slots[];
+} PoolTable;
+
+typedef struct {
+    PoolTable* table;           // loaded without the lock
+    PoolEntry* segments[POOL_SEGMENTS];
+    unsigned count;
+    PoolBlock* blocks;
+    pthread_mutex_t lock;       // taken to add a string
+} __attribute__((aligned(64))) PoolShard;
+
+static PoolShard shards[POOL_SHARDS] = {
+    [0 ... POOL_SHARDS - 1] = { .lock = PTHREAD_MUTEX_INITIALIZER }
+};
+
+static unsigned hash_text(const char* text, size_t length) {
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) hash = (hash ^ (unsigned char)text[i]) * 16777619u;
+    return hash;
+}
+
+static PoolEntry* entry_at(PoolShard* shard, unsigned index) {
+    unsigned segment = 31 - __builtin_clz(index / POOL_SEGMENT_BASE + 1);
+    return &shard->segments[segment][index - POOL_SEGMENT_BASE * ((1u << segment) - 1)];
+}
+
+static PoolEntry* entry_of(StringId id) {
+    return entry_at(&shards[id & (POOL_SHARDS - 1)], id >> POOL_SHARD_BITS);
+}
+
+// Returns the id + 1 of the string, or 0 with *free_slot set to where it
+// would go.
+static StringId probe(PoolShard* shard, PoolTable* table, const char* text, unsigned length,
+                      unsigned hash, unsigned* free_slot) {
+    unsigned mask = table->capacity - 1;
+    for (unsigned slot = hash & mask;; slot = (slot + 1) & mask) {
+        StringId stored = __atomic_load_n(&table->slots[slot], __ATOMIC_ACQUIRE);
+        if (!stored) {
+            *free_slot = slot;
+            return 0;
+        }
+        PoolEntry* entry = entry_at(shard, (stored - 1) >> POOL_SHARD_BITS);
+        if (entry->hash == hash && entry->length == length && memcmp(entry->text, text, length) == 0) {
+            return stored;
+        }
+    }
+}
+
+static char* allocate(PoolShard* shard, size_t size) {
+    PoolBlock* block = shard->blocks;
+    if (!block || block->size - block->used < size) {
+        size_t block_size = size > POOL_BLOCK_SIZE ? size : POOL_BLOCK_SIZE;
+        block = malloc(sizeof(PoolBlock) + block_size);
+        block->next = shard->blocks;
+        block->used = 0;
+        block->size = block_size;
+        shard->blocks = block;
+    }
+    char* p = block->data + block->used;
+    block->used += size;
+    return p;
+}
+
+// Under the shard lock.
+static PoolTable* grow(PoolShard* shard) {
+    PoolTable* old = shard->table;
+    unsigned capacity = old ? old->capacity * 2 : 64;
+    PoolTable* table = calloc(1, sizeof(PoolTable) + capacity * sizeof(StringId));
+
+    table->retired = old;
+    table->capacity = capacity;
+    for (unsigned i = 0; old && i < old->capacity; i++) {
+        StringId stored = old->slots[i];
+        if (!stored) continue;
+        unsigned slot = entry_at(shard, (stored - 1) >> POOL_SHARD_BITS)->hash & (capacity - 1);
+        while (table->slots[slot]) slot = (slot + 1) & (capacity - 1);
+        table->slots[slot] = stored;
+    }
+    __atomic_store_n(&shard->table, table, __ATOMIC_RELEASE);
+    return table;
+}
+
+StringId intern_string(const char* text, size_t length) {
+    unsigned hash = hash_text(text, length);
+    PoolShard* shard = &shards[hash >> (32 - POOL_SHARD_BITS)];
+    PoolTable* table = __atomic_load_n(&shard->table, __ATOMIC_ACQUIRE);
+    unsigned slot;
+    StringId stored;
+
+    if (table && (stored = probe(shard, table, text, length, hash, &slot))) return stored - 1;
+
+    pthread_mutex_lock(&shard->lock);
+    table = shard->table;
+    if (!table || (shard->count + 1) * 2 > table->capacity) table = grow(shard);
+    if ((stored = probe(shard, table, text, length, hash, &slot))) {
+        pthread_mutex_unlock(&shard->lock);
+        return stored - 1;
+    }
+    unsigned index = shard->count++;
+    unsigned segment = 31 - __builtin_clz(index / POOL_SEGMENT_BASE + 1);
+    if (!shard->segments[segment]) {
+        shard->segments[segment] = malloc(((size_t)POOL_SEGMENT_BASE << segment) * sizeof(PoolEntry));
+    }
+    char* copy = allocate(shard, length + 1);
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    PoolEntry* entry = entry_at(shard, index);
+    entry->text = copy;
+    entry->hash = hash;
+    entry->length = length;
+    StringId id = index << POOL_SHARD_BITS | (StringId)(shard - shards);
+    __atomic_store_n(&table->slots[slot], id + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&shard->lock);
+    return id;
+}
+
+const char* string_text(StringId id) {
+    return entry_of(id)->text;
+}
+
+size_t string_length(StringId id) {
+    return entry_of(id)->length;
+}
+
+const char* intern_literal(const char* text) {
+    return string_text(intern_string(text, strlen(text)));
+}
+
+void free_string_pool(void) {
+    for (int i = 0; i < POOL_SHARDS; i++) {
+        PoolShard* shard = &shards[i];
+        while (shard->blocks) {
+            PoolBlock* next = shard->blocks->next;
+            free(shard->blocks);
+            shard->blocks = next;
+        }
+        while (shard->table) {
+            PoolTable* retired = shard->table->retired;
+            free(shard->table);
+            shard->table = retired;
+        }
+        for (int s = 0; s < POOL_SEGMENTS; s++) {
+            free(shard->segments[s]);
+            shard->segments[s] = NULL;
+        }
+        shard->count = 0;
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef STRPOOL_H
+#define STRPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Strings of one compilation (identifiers and literals), interned as the
+// lexer reads them: equal strings share one copy, so later passes can
+// compare them by pointer or by handle. A handle is a stable 32-bit id;
+// the copies stay valid until free_string_pool.
+//
+// Interning and lookups are safe from any number of threads at once: the
+// pool is split into shards by hash, finding a string already in the pool
+// takes no lock, and adding one locks only its shard. free_string_pool
+// must not race with anything.
+typedef uint32_t StringId;
+
+StringId intern_string(const char* text, size_t length);
+const char* string_text(StringId id);
+size_t string_length(StringId id);
+
+// Same as string_text(intern_string(text, strlen(text))).
+const char* intern_literal(const char* text);
+
+void free_string_pool(void);
+
+#endif
@@ -0,0 +1,107 @@
+// Contention benchmark for the string pool: every thread interns the same
+// vocabulary of identifiers, in its own order, so early operations race to
+// add strings and later ones look up strings another thread added. The
+// "locked" rows run the same pool behind one global mutex, the way a
+// single-lock interner would behave.
+//
+//   make strpool-bench
+//   ./strpool_bench [words] [operations per thread] [max threads]
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "strpool.h"
+
+typedef struct {
+    char** words;
+    size_t* lengths;
+    int nwords;
+    long operations;
+    unsigned seed;
+    int locked;
+    StringId checksum;
+} Worker;
+
+static pthread_mutex_t global_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+static void* run_worker(void* arg) {
+    Worker* w = arg;
+    unsigned state = w->seed;
+
+    for (long i = 0; i < w->operations; i++) {
+        state = state * 1103515245u + 12345u;
+        int word = (state >> 8) % w->nwords;
+        StringId id;
+        if (w->locked) pthread_mutex_lock(&global_lock);
+        id = intern_string(w->words[word], w->lengths[word]);
+        if (w->locked) pthread_mutex_unlock(&global_lock);
+        w->checksum += id;
+    }
+    return NULL;
+}
+
+// Returns million operations per second.
+static double measure(char** words, size_t* lengths, int nwords, long operations, int nthreads, int locked) {
+    pthread_t* threads = malloc(nthreads * sizeof(pthread_t));
+    Worker* workers = calloc(nthreads, sizeof(Worker));
+
+    free_string_pool();
+    double start = now();
+    for (int t = 0; t < nthreads; t++) {
+        workers[t] = (Worker){ words, lengths, nwords, operations, 2654435761u * (t + 1), locked, 0 };
+        pthread_create(&threads[t], NULL, run_worker, &workers[t]);
+    }
+    for (int t = 0; t < nthreads; t++) pthread_join(threads[t], NULL);
+    double seconds = now() - start;
+
+    // Every word has exactly one id, whichever thread added it.
+    for (int i = 0; i < nwords; i++) {
+        StringId id = intern_string(words[i], lengths[i]);
+        if (string_length(id) != lengths[i] || memcmp(string_text(id), words[i], lengths[i]) != 0) {
+            fprintf(stderr, "mismatch for %s\n", words[i]);
+            exit(1);
+        }
+    }
+    free(threads);
+    free(workers);
+    return nthreads * (double)operations / seconds / 1e6;
+}
+
+int main(int argc, char** argv) {
+    int nwords = argc > 1 ? atoi(argv[1]) : 50000;
+    long operations = argc > 2 ? atol(argv[2]) : 2000000;
+    int max_threads = argc > 3 ? atoi(argv[3]) : 64;
+    char** words = malloc(nwords * sizeof(char*));
+    size_t* lengths = malloc(nwords * sizeof(size_t));
+
+    // Identifier-like names: a few common stems with numeric suffixes.
+    static const char* stems[] = { "i", "count", "total", "buffer", "index", "result", "node", "value" };
+    for (int i = 0; i < nwords; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "%s_%d", stems[i % 8], i / 8);
+        words[i] = strdup(name);
+        lengths[i] = strlen(name);
+    }
+
+    printf("%d words, %ld operations per thread\n", nwords, operations);
+    printf("%8s %16s %16s\n", "threads", "sharded Mops/s", "locked Mops/s");
+    for (int n = 1; n <= max_threads; n *= 2) {
+        double sharded = measure(words, lengths, nwords, operations, n, 0);
+        double locked = measure(words, lengths, nwords, operations, n, 1);
+        printf("%8d %16.1f %16.1f\n", n, sharded, locked);
+    }
+
+    free_string_pool();
+    for (int i = 0; i < nwords; i++) free(words[i]);
+    free(words);
+    free(lengths);
+    return 0;
+}
@@ -0,0 +1,50 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "switch.h"
+
+static int compare_cases(const void* a, const void* b) {
+    const SwitchCase* x = a;
+    const SwitchCase* y = b;
+    return (x->value > y->value) - (x->value < y->value);
+}
+
+void plan_switch(ASTNode* stmt, SwitchPlan* plan) {
+    memset(plan, 0, sizeof(SwitchPlan));
+    plan->default_position = -1;
+
+    for (ASTNode* clause = stmt->right; clause; clause = clause->next) plan->clauses++;
+    plan->cases = malloc((plan->clauses ? plan->clauses : 1) * sizeof(SwitchCase));
+    int position = 0;
+    for (ASTNode* clause = stmt->right; clause; clause = clause->next, position++) {
+        if (node_is(clause, "default")) {
+            if (plan->defaults++ == 0) plan->default_position = position;
+            continue;
+        }
+        plan->cases[plan->count].value = atoi(clause->value);
+        plan->cases[plan->count].position = position;
+        plan->count++;
+    }
+    qsort(plan->cases, plan->count, sizeof(SwitchCase), compare_cases);
+    for (int i = 1; i < plan->count && !plan->has_duplicate; i++) {
+        if (plan->cases[i].value == plan->cases[i - 1].value) {
+            plan->duplicate = plan->cases[i].value;
+            plan->has_duplicate = 1;
+        }
+    }
+
+    if (plan->count < SWITCH_MIN_CASES) {
+        plan->strategy = SWITCH_COMPARE_CHAIN;
+        return;
+    }
+    long long range = (long long)plan->cases[plan->count - 1].value - plan->cases[0].value + 1;
+    if (range <= SWITCH_MAX_TABLE && plan->count * 100LL >= range * SWITCH_MIN_DENSITY) {
+        plan->strategy = SWITCH_JUMP_TABLE;
+    } else {
+        plan->strategy = SWITCH_BINARY_SEARCH;
+    }
+}
+
+void free_switch_plan(SwitchPlan* plan) {
+    free(plan->cases);
+}
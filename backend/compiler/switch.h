@@ -0,0 +1,41 @@
+#ifndef SWITCH_H
+#define SWITCH_H
+
+#include "ast.h"
+
+// Lowering strategy for a "switch", chosen by the number of cases and how
+// densely they cover their value range. Fewer than SWITCH_MIN_CASES cases
+// are compared one by one; a jump table needs SWITCH_MIN_DENSITY percent
+// of the range covered and at most SWITCH_MAX_TABLE entries; everything
+// else becomes a binary search over the sorted values with compare chains
+// of up to SWITCH_MIN_CASES - 1 cases at the leaves.
+#define SWITCH_MIN_CASES 4
+#define SWITCH_MIN_DENSITY 50
+#define SWITCH_MAX_TABLE 4096
+
+typedef enum {
+    SWITCH_COMPARE_CHAIN,
+    SWITCH_BINARY_SEARCH,
+    SWITCH_JUMP_TABLE
+} SwitchStrategy;
+
+typedef struct {
+    int value;
+    int position;       // index of the "case" node in the switch body
+} SwitchCase;
+
+typedef struct {
+    SwitchCase* cases;  // sorted by value
+    int count;
+    int clauses;        // "case" and "default" nodes in the body
+    int default_position; // -1 without default
+    int defaults;       // more than one is an error
+    int duplicate;      // a repeated case value, valid if has_duplicate
+    int has_duplicate;
+    SwitchStrategy strategy;
+} SwitchPlan;
+
+void plan_switch(ASTNode* stmt, SwitchPlan* plan);
+void free_switch_plan(SwitchPlan* plan);
+
+#endif
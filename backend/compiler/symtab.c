@@ -0,0 +1,180 @@
+#include <stdlib.h>
+#include <string.h>
+#include "symtab.h"
+
+static unsigned hash_name(const char* name) {
+    unsigned hash = 2166136261u;
+    for (; *name; name++) hash = (hash ^ (unsigned char)*name) * 16777619u;
+    return hash;
+}
+
+// Entry for name in scope: the one holding it, or the free one where it
+// belongs.
+static Symbol* probe(Scope* scope, const char* name) {
+    unsigned mask = scope->capacity - 1;
+    unsigned i = hash_name(name) & mask;
+    while (scope->entries[i].name && strcmp(scope->entries[i].name, name) != 0) i = (i + 1) & mask;
+    return &scope->entries[i];
+}
+
+static void grow(Scope* scope) {
+    Symbol* old = scope->entries;
+    int old_capacity = scope->capacity;
+
+    scope->capacity = old_capacity ? old_capacity * 2 : 8;
+    scope->entries = calloc(scope->capacity, sizeof(Symbol));
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i].name) *probe(scope, old[i].name) = old[i];
+    }
+    free(old);
+}
+
+void symtab_push(SymbolTable* table) {
+    if (table->depth == table->capacity) {
+        int old_capacity = table->capacity;
+        table->capacity = old_capacity ? old_capacity * 2 : 8;
+        table->scopes = realloc(table->scopes, table->capacity * sizeof(Scope));
+        memset(table->scopes + old_capacity, 0, (table->capacity - old_capacity) * sizeof(Scope));
+    }
+    // Maps of closed scopes are kept and cleared for reuse.
+    Scope* scope = &table->scopes[table->depth++];
+    if (scope->count) memset(scope->entries, 0, scope->capacity * sizeof(Symbol));
+    scope->count = 0;
+    scope->first_slot = table->next_slot;
+}
+
+void symtab_pop(SymbolTable* table) {
+    table->next_slot = table->scopes[--table->depth].first_slot;
+}
+
+void symtab_free(SymbolTable* table) {
+    for (int i = 0; i < table->capacity; i++) free(table->scopes[i].entries);
+    free(table->scopes);
+    memset(table, 0, sizeof(SymbolTable));
+}
+
+Symbol* symtab_declare(SymbolTable* table, const char* name, int* redeclared) {
+    Scope* scope = &table->scopes[table->depth - 1];
+    if ((scope->count + 1) * 2 > scope->capacity) grow(scope);
+    Symbol* symbol = probe(scope, name);
+    *redeclared = symbol->name != NULL;
+    if (!symbol->name) scope->count++;
+    symbol->name = name;
+    symbol->slot = table->next_slot++;
+    return symbol;
+}
+
+Symbol* symtab_lookup(SymbolTable* table, const char* name, int* depth) {
+    for (int d = table->depth - 1; d >= 0; d--) {
+        Scope* scope = &table->scopes[d];
+        if (!scope->count) continue;
+        Symbol* symbol = probe(scope, name);
+        if (symbol->name) {
+            *depth = d;
+            return symbol;
+        }
+    }
+    return NULL;
+}
+
+// ---- resolution -------------------------------------------------------------
+
+static void resolve_list(SymbolTable* table, ASTNode* list);
+
+static void bind(SymbolTable* table, ASTNode* node) {
+    int depth;
+    Symbol* symbol = symtab_lookup(table, node->value, &depth);
+    node->depth = symbol ? depth : -1;
+    node->slot = symbol ? symbol->slot : -1;
+}
+
+static void declare(SymbolTable* table, ASTNode* node) {
+    node->depth = table->depth - 1;
+    node->slot = symtab_declare(table, node->value, &node->redeclared)->slot;
+}
+
+static void resolve_expr(SymbolTable* table, ASTNode* expr) {
+    if (!expr) return;
+    if (node_is(expr, "call") || node_is(expr, "tail-call")) {
+        for (ASTNode* arg = expr->left; arg; arg = arg->next) resolve_expr(table, arg);
+        return;
+    }
+    if (node_is(expr, "id") || node_is(expr, "element") || node_is(expr, "unchecked-element")) {
+        bind(table, expr);
+    }
+    resolve_expr(table, expr->left);
+    resolve_expr(table, expr->right);
+}
+
+static void resolve_block(SymbolTable* table, ASTNode* list) {
+    symtab_push(table);
+    resolve_list(table, list);
+    symtab_pop(table);
+}
+
+static void resolve_statement(SymbolTable* table, ASTNode* stmt) {
+    if (node_is(stmt, "declaration")) {
+        resolve_expr(table, stmt->right);
+        declare(table, stmt);
+    } else if (node_is(stmt, "array-declaration")) {
+        declare(table, stmt);
+    } else if (node_is(stmt, "assignment")) {
+        resolve_expr(table, stmt->right);
+        bind(table, stmt);
+    } else if (node_is(stmt, "element-assignment") || node_is(stmt, "unchecked-element-assignment")) {
+        bind(table, stmt);
+        resolve_expr(table, stmt->left);
+        resolve_expr(table, stmt->right);
+    } else if (node_is(stmt, "if") || node_is(stmt, "while")) {
+        resolve_expr(table, stmt->left);
+        resolve_block(table, stmt->right);
+    } else if (node_is(stmt, "if-else")) {
+        resolve_expr(table, stmt->left);
+        resolve_block(table, stmt->right->left);
+        resolve_block(table, stmt->right->right);
+    } else if (node_is(stmt, "for") || node_is(stmt, "vector-for")) {
+        symtab_push(table);
+        resolve_list(table, stmt->left->left);
+        resolve_expr(table, stmt->left->right);
+        resolve_block(table, stmt->right->right);
+        resolve_list(table, stmt->right->left);
+        symtab_pop(table);
+    } else if (node_is(stmt, "switch")) {
+        resolve_expr(table, stmt->left);
+        for (ASTNode* clause = stmt->right; clause; clause = clause->next) resolve_block(table, clause->right);
+    } else if (node_is(stmt, "block") || node_is(stmt, "tail-loop")) {
+        resolve_block(table, stmt->right);
+    } else if (node_is(stmt, "return")) {
+        resolve_expr(table, stmt->right);
+    } else if (node_is(stmt, "call") || node_is(stmt, "tail-jump") || node_is(stmt, "printf")) {
+        for (ASTNode* arg = stmt->left; arg; arg = arg->next) resolve_expr(table, arg);
+    } else if (node_is(stmt, "scanf")) {
+        for (ASTNode* target = stmt->left; target; target = target->next) {
+            bind(table, target);
+            resolve_expr(table, target->left);
+        }
+    }
+}
+
+static void resolve_list(SymbolTable* table, ASTNode* list) {
+    for (ASTNode* stmt = list; stmt; stmt = stmt->next) resolve_statement(table, stmt);
+}
+
+void resolve_symbols(ASTNode* program) {
+    SymbolTable table;
+
+    memset(&table, 0, sizeof(table));
+    symtab_push(&table);
+    for (ASTNode* global = program; global; global = global->next) {
+        if (node_is(global, "array-declaration")) declare(&table, global);
+    }
+    for (ASTNode* function = program; function; function = function->next) {
+        if (!node_is(function, "function")) continue;
+        symtab_push(&table);
+        table.next_slot = 0;
+        for (ASTNode* param = function->right->left; param; param = param->next) declare(&table, param);
+        resolve_list(&table, function->right->right);
+        symtab_pop(&table);
+    }
+    symtab_free(&table);
+}
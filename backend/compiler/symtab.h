@@ -0,0 +1,52 @@
+#ifndef SYMTAB_H
+#define SYMTAB_H
+
+#include "ast.h"
+
+// Scoped symbol table: a stack of open-addressing hash maps, one per scope.
+// Depth 0 holds the global arrays, depth 1 a function's parameters and
+// top-level locals, and every nested block adds one. Slots number the
+// variables live at the same time: globals from 0 in program order, locals
+// from 0 per function with parameters first; a slot is reused once the
+// scope that declared it is closed.
+typedef struct {
+    const char* name;   // NULL for a free entry
+    int slot;
+} Symbol;
+
+typedef struct {
+    Symbol* entries;
+    int capacity;       // a power of two, at most half full
+    int count;
+    int first_slot;
+} Scope;
+
+typedef struct {
+    Scope* scopes;
+    int depth;
+    int capacity;
+    int next_slot;
+} SymbolTable;
+
+void symtab_push(SymbolTable* table);
+void symtab_pop(SymbolTable* table);
+void symtab_free(SymbolTable* table);
+
+// A name declared twice in one scope refers to the later declaration;
+// *redeclared tells whether it was (an error the semantic checks report).
+Symbol* symtab_declare(SymbolTable* table, const char* name, int* redeclared);
+
+// Innermost declaration of name, its depth in *depth; NULL if undeclared.
+Symbol* symtab_lookup(SymbolTable* table, const char* name, int* depth);
+
+// Sets depth and slot on every declaration, parameter and variable
+// reference, following the scoping of the engines: the initializer of a
+// declaration is resolved before the name comes into scope, and the
+// control part of a `for` is a scope around its body. Unresolved names get
+// depth -1 and are reported by the engine that meets them; declarations
+// that repeat a name of their scope get redeclared. Runs after the
+// AST rewrites in optimize.c, which work on names and create variables of
+// their own.
+void resolve_symbols(ASTNode* program);
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef SYNTAX_H
+#define SYNTAX_H
+
+// Syntax errors of the last parse (parser.y). The parser resumes after
+// the next ";" or "}" instead of stopping, so one parse finds every error
+// up to the cap; it gives up on the rest of the input there.
+#define MAX_SYNTAX_ERRORS 20
+
+typedef struct {
+    int offset;         // of the token the error was found at, like its node offsets
+    int length;
+    char message[128];
+} SyntaxError;
+
+extern SyntaxError syntax_errors[MAX_SYNTAX_ERRORS];
+extern int syntax_error_count;
+
+// Adds an error to the list (the preprocessor's, for one).
+void syntax_error_at(int offset, int length, const char* message);
+
+// lexer.l: has yyparse read text[0..length) from memory, with offsets
+// counted from its start; yylex_destroy() lets go of it.
+void lex_string(const char* text, int length);
+int yylex_destroy(void);
+
+#endif
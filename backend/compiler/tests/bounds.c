@@ -0,0 +1,40 @@
+// Indexes the interval analysis proves in range next to ones it cannot;
+// the last loop runs one past the end and must stop with an error.
+int g[10];
+
+int sum(int n) {
+    int a[8];
+    int s = 0;
+    for (int i = 0; i < 8; i = i + 1) {
+        a[i] = i * n;
+    }
+    for (int i = 7; i >= 0; i = i - 1) {
+        s = s + a[i] + a[7 - i];
+    }
+    if (n >= 0) {
+        if (n < 8) {
+            s = s + a[n];
+        }
+    }
+    return s;
+}
+
+int main() {
+    int n;
+    scanf("%d", &n);
+    for (int i = 0; i < 10; i = i + 1) {
+        g[i] = i + n;
+    }
+    printf("%d %d %d\n", sum(3), sum(7), sum(12));
+    for (int i = 0; i < n; i = i + 1) {
+        g[i % 10] = g[(i + 3) % 10] + 1;
+    }
+    printf("%d %d\n", g[0], g[9]);
+    int k = 0;
+    while (k <= 10) {
+        printf("%d\n", g[k]);
+        k = k + 1;
+    }
+    printf("not reached\n");
+    return 0;
+}
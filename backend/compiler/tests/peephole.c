@@ -0,0 +1,40 @@
+// The peephole clean-ups and superinstructions, each next to code the
+// rewrite must leave alone.
+char wrap(int x) {
+    char c = x;
+    c = c;
+    return c;
+}
+
+int main() {
+    int n;
+    int total = 0;
+    int i;
+    scanf("%d", &n);
+    for (i = 0; i < n; i = i + 1) {
+        total = total + i * 3 - 2;
+        total = total + 0;
+        total = total * 1;
+        if (!(i % 7)) {
+            total = total - i;
+        }
+        if (0) {
+            total = 0;
+        }
+        if (1) {
+            total = total + 1;
+        }
+    }
+    printf("%d\n", total);
+    i = n;
+    while (i) {
+        i = i - 1;
+        total = total / 3;
+    }
+    printf("%d %d\n", i, total);
+    printf("%d %d %d\n", wrap(200), wrap(-129), wrap(n * 100));
+    char c = 97;
+    c = c + 200;
+    printf("%d %c\n", c, c + 81);
+    return 0;
+}
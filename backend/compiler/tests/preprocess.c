@@ -0,0 +1,37 @@
+// Builtin headers, object-like and function-like macros, nested and
+// self-referencing expansions, and #undef.
+#include <stdio.h>
+#include <limits.h>
+#include <stdbool.h>
+#pragma once
+
+#define N 12
+#define SQUARE(x) ((x) * (x))
+#define PICK(a, b) ((a) * 2 + (b))
+#define TWICE(f, x) f(f(x))
+#define LIMIT INT_MAX
+#define EMPTY()
+
+int square_sum(int n) {
+    int s = 0;
+    for (int i = 1; i <= n; i = i + 1) {
+        s = s + SQUARE(i + 1) EMPTY();
+    }
+    return s;
+}
+
+int main() {
+    int total = 0;
+    bool flag = true;
+    int n;
+    scanf("%d", &n);
+#define total (total + 1)
+    int bumped = total;
+    printf("%d %d %d\n", square_sum(N), TWICE(SQUARE, 3), PICK(n, N));
+    printf("%d %d %d\n", LIMIT, INT_MIN, CHAR_MAX);
+    printf("%d %d %d %d\n", total, bumped, flag, EOF);
+#undef N
+#define N 5
+    printf("%d %d\n", N, SQUARE(N + 1));
+    return 0;
+}
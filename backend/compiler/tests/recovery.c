@@ -0,0 +1,32 @@
+// Several syntax and directive errors: each is reported, and parsing
+// carries on after it to find the next.
+#include <stdio.h>
+#include <missing.h>
+#include "local.h"
+#if 1
+#define TWICE(x) ((x) * 2)
+
+int broken(int x) {
+    int y = x +;
+    return y
+}
+
+int fine(int x) {
+    return TWICE(x);
+}
+
+int leading(, int a) {
+    return a;
+}
+
+int main() {
+    int a[3];
+    a[0] = fine(2;
+    while (a[0] > 0) {
+        a[0] = a[0] - ;
+    }
+    printf("%d\n", TWICE(a[0]);
+    return 0;
+}
+
+int trailing( {
@@ -0,0 +1,22 @@
+// Names declared twice in one scope are errors; shadowing one in an inner
+// scope is not.
+int f(int x, int x) {
+    return x;
+}
+
+int g(int y) {
+    int y = 2;
+    return y;
+}
+
+int main() {
+    int a = 1;
+    int a = 2;
+    if (a) {
+        int a = 3;
+    }
+    for (int i = 0; i < 2; i = i + 1) {
+        int i = 5;
+    }
+    return f(1, 2) + g(a);
+}
@@ -0,0 +1,57 @@
+// Each switch lowering: a compare chain, a jump table and a binary search,
+// with fallthrough, defaults in the middle and values outside the range.
+int chain(int x) {
+    int r = 0;
+    switch (x) {
+        case 1: r = 10;
+        case 2: r = r + 20; break;
+        case -3: r = 30; break;
+    }
+    return r;
+}
+
+int table(int x) {
+    int r = 0;
+    switch (x - 2) {
+        case -2: r = 1; break;
+        case -1: r = 2;
+        case 0: r = r + 3; break;
+        default: r = -1;
+        case 1: r = r * 5; break;
+        case 2: r = 7; break;
+        case 4: r = 9; break;
+        case 5: r = 11;
+    }
+    return r;
+}
+
+int search(int x) {
+    switch (x) {
+        case -2147483647: return 1;
+        case -1000000: return 2;
+        case -7: return 3;
+        case 0: return 4;
+        case 13: return 5;
+        case 500: return 6;
+        case 99999: return 7;
+        case 2147483647: return 8;
+        default: return 0;
+    }
+    return -1;
+}
+
+int main() {
+    int n;
+    int total = 0;
+    scanf("%d", &n);
+    for (int i = -4; i < 9; i = i + 1) {
+        printf("%d %d %d\n", i, chain(i), table(i));
+    }
+    printf("%d %d %d %d\n", search(-2147483647), search(-1000000), search(2147483647), search(99999));
+    printf("%d %d %d %d\n", search(-7), search(500), search(14), search(-2147483646));
+    for (int i = 0; i < n; i = i + 1) {
+        total = total + table(i % 11 - 1) + search(i * 37 % 600 - 100) + chain(i % 5 - 3);
+    }
+    printf("%d\n", total);
+    return 0;
+}
@@ -0,0 +1,51 @@
+// Tail calls, self-recursion turned into loops, and returns that must
+// stay plain calls because the caller's return type is narrower.
+int g(int x) {
+    return x * 2;
+}
+
+char f(int x) {
+    return g(x);
+}
+
+char h(char c) {
+    return c;
+}
+
+char k(int x) {
+    return h(x + 1);
+}
+
+int widen(int x) {
+    return h(x);
+}
+
+int count(int n, int acc) {
+    if (n == 0) {
+        return acc;
+    }
+    return count(n - 1, acc + 1);
+}
+
+int sum(int n) {
+    if (n == 0) {
+        return 0;
+    }
+    return n + sum(n - 1);
+}
+
+char product(int n) {
+    if (n == 0) {
+        return 1;
+    }
+    return n * product(n - 1);
+}
+
+int main() {
+    int x;
+    scanf("%d", &x);
+    printf("%d %d\n", f(x), g(x));
+    printf("%d %d\n", k(x), widen(x));
+    printf("%d %d %d\n", count(x * 100, 0), sum(x * 10), product(x / 30));
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "threadpool.h"
+
+// One run of thread_pool_run, on the caller's stack. The tasks are split
+// into one contiguous range per thread. A thread takes tasks from the
+// front of its own range and, once that is empty, steals the back half of
+// the fullest other range, so long functions do not hold a thread back
+// while the others sit idle. Ranges are packed as begin << 32 | end and
+// only change by compare-and-swap; a task index is handed out once, so a
+// stale range can never match again. The lock is only taken to join and
+// leave a run.
+typedef struct {
+    TaskFunction function;
+    void* context;
+    int ntasks;
+    unsigned long long* ranges; // one per thread
+    int nranges;
+    int joined;         // threads that took a range so far
+    int active;         // workers inside the run, under the pool lock
+} Job;
+
+struct ThreadPool {
+    pthread_t* threads;
+    int nthreads;       // workers plus the calling thread
+    unsigned long long* ranges;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    Job* job;           // the current run, NULL between runs
+    unsigned long generation; // counts runs
+    int shutdown;
+};
+
+#define RANGE(begin, end) ((unsigned long long)(begin) << 32 | (unsigned)(end))
+#define RANGE_BEGIN(range) ((int)((range) >> 32))
+#define RANGE_END(range) ((int)((range) & 0xffffffffu))
+
+// Next task of the range, -1 once it is empty.
+static int take_front(unsigned long long* range) {
+    unsigned long long old = __atomic_load_n(range, __ATOMIC_ACQUIRE);
+    while (RANGE_BEGIN(old) < RANGE_END(old)) {
+        if (__atomic_compare_exchange_n(range, &old, RANGE(RANGE_BEGIN(old) + 1, RANGE_END(old)), 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            return RANGE_BEGIN(old);
+        }
+    }
+    return -1;
+}
+
+// Moves the back half of the fullest other range into the (empty) range of
+// thread self; 0 when every range is empty.
+static int steal(Job* job, int self) {
+    for (;;) {
+        int victim = -1, most = 0;
+        unsigned long long seen = 0;
+        for (int i = 0; i < job->nranges; i++) {
+            unsigned long long range = __atomic_load_n(&job->ranges[i], __ATOMIC_ACQUIRE);
+            if (i != self && RANGE_END(range) - RANGE_BEGIN(range) > most) {
+                victim = i;
+                most = RANGE_END(range) - RANGE_BEGIN(range);
+                seen = range;
+            }
+        }
+        if (victim < 0) return 0;
+        int middle = RANGE_END(seen) - (most + 1) / 2;
+        if (__atomic_compare_exchange_n(&job->ranges[victim], &seen, RANGE(RANGE_BEGIN(seen), middle), 0,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            __atomic_store_n(&job->ranges[self], RANGE(middle, RANGE_END(seen)), __ATOMIC_RELEASE);
+            return 1;
+        }
+    }
+}
+
+static void run_job(Job* job) {
+    int self = __atomic_fetch_add(&job->joined, 1, __ATOMIC_RELAXED);
+    if (self >= job->nranges) return;
+    do {
+        for (int task; (task = take_front(&job->ranges[self])) >= 0;) job->function(job->context, task);
+    } while (steal(job, self));
+}
+
+static void* worker(void* arg) {
+    ThreadPool* pool = arg;
+    unsigned long seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->shutdown && (!pool->job || pool->generation == seen)) {
+            pthread_cond_wait(&pool->start, &pool->lock);
+        }
+        if (pool->shutdown) break;
+        Job* job = pool->job;
+        seen = pool->generation;
+        job->active++;
+        pthread_mutex_unlock(&pool->lock);
+        run_job(job);
+        pthread_mutex_lock(&pool->lock);
+        if (--job->active == 0) pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool* thread_pool_create(int nthreads) {
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    pool->nthreads = nthreads > 1 ? nthreads : 1;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    pool->threads = malloc(pool->nthreads * sizeof(pthread_t));
+    pool->ranges = malloc(pool->nthreads * sizeof(unsigned long long));
+    for (int i = 1; i < pool->nthreads; i++) {
+        if (pthread_create(&pool->threads[i], NULL, worker, pool) != 0) {
+            pool->nthreads = i;
+            break;
+        }
+    }
+    return pool;
+}
+
+void thread_pool_run(ThreadPool* pool, int ntasks, TaskFunction function, void* context) {
+    Job job = { function, context, ntasks, pool->ranges, pool->nthreads, 0, 0 };
+
+    if (pool->nthreads == 1 || ntasks <= 1) {
+        for (int task = 0; task < ntasks; task++) function(context, task);
+        return;
+    }
+    for (int i = 0; i < pool->nthreads; i++) {
+        pool->ranges[i] = RANGE((long long)ntasks * i / pool->nthreads, (long long)ntasks * (i + 1) / pool->nthreads);
+    }
+    pthread_mutex_lock(&pool->lock);
+    pool->job = &job;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_job(&job);
+
+    // Workers that have not picked the job up yet will not find it anymore.
+    pthread_mutex_lock(&pool->lock);
+    pool->job = NULL;
+    while (job.active > 0) pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_destroy(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->nthreads; i++) pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool->ranges);
+    free(pool);
+}
+
+int thread_pool_size(ThreadPool* pool) {
+    return pool->nthreads;
+}
+
+int default_thread_count(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 1 ? (int)n : 1;
+}
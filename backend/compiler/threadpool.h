@@ -0,0 +1,22 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+// Fixed set of worker threads for the per-function compiler passes. A run
+// hands out tasks 0..ntasks-1 to the workers and the calling thread, with
+// work stealing between them, and returns when all of them have finished.
+// Tasks run in no particular order; callers keep one result per task and
+// merge them in task order afterwards.
+typedef struct ThreadPool ThreadPool;
+
+typedef void (*TaskFunction)(void* context, int task);
+
+// nthreads counts the calling thread; 1 or less runs every task inline.
+ThreadPool* thread_pool_create(int nthreads);
+void thread_pool_run(ThreadPool* pool, int ntasks, TaskFunction function, void* context);
+void thread_pool_destroy(ThreadPool* pool);
+int thread_pool_size(ThreadPool* pool);
+
+// Online processors, at least 1.
+int default_thread_count(void);
+
+#endif
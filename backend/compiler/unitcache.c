@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "unitcache.h"
+
+// Two FNV-1a streams with different offsets, so a collision needs both
+// 64-bit halves to collide at once.
+void hash_init(TreeHash* hash) {
+    hash->a = 14695981039346656037ull;
+    hash->b = 0x9e3779b97f4a7c15ull;
+}
+
+void hash_bytes(TreeHash* hash, const void* data, size_t length) {
+    const unsigned char* p = data;
+    for (size_t i = 0; i < length; i++) {
+        hash->a = (hash->a ^ p[i]) * 1099511628211ull;
+        hash->b = (hash->b ^ p[i]) * 0x100000001b3ull + 0x9e37u;
+    }
+}
+
+void hash_int(TreeHash* hash, int value) {
+    hash_bytes(hash, &value, sizeof(value));
+}
+
+static void hash_string(TreeHash* hash, const char* text) {
+    if (text) hash_bytes(hash, text, strlen(text) + 1);
+    else hash_int(hash, -1);
+}
+
+// Children are hashed as lists (arguments and statements hang off next),
+// each element behind a marker and the list closed by another, so
+// different shapes never hash alike.
+static void hash_node(TreeHash* hash, const ASTNode* node);
+
+static void hash_list(TreeHash* hash, const ASTNode* list) {
+    for (; list; list = list->next) {
+        hash_int(hash, 1);
+        hash_node(hash, list);
+    }
+    hash_int(hash, 0);
+}
+
+static void hash_node(TreeHash* hash, const ASTNode* node) {
+    hash_string(hash, node->type);
+    hash_string(hash, node->value);
+    hash_list(hash, node->left);
+    hash_list(hash, node->right);
+}
+
+void hash_tree(TreeHash* hash, const ASTNode* node) {
+    if (node) hash_node(hash, node);
+    else hash_int(hash, -1);
+}
+
+static void entry_path(char* path, size_t size, const char* directory, const TreeHash* key) {
+    snprintf(path, size, "%s/%016llx%016llx.unit", directory, (unsigned long long)key->a,
+             (unsigned long long)key->b);
+}
+
+void* unit_cache_load(const char* directory, const TreeHash* key, size_t* size) {
+    char path[4096];
+    entry_path(path, sizeof(path), directory, key);
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    char* data = NULL;
+    long length;
+    if (fseek(f, 0, SEEK_END) == 0 && (length = ftell(f)) > 0 && fseek(f, 0, SEEK_SET) == 0) {
+        data = malloc(length);
+        if (fread(data, 1, length, f) != (size_t)length) {
+            free(data);
+            data = NULL;
+        }
+        *size = length;
+    }
+    fclose(f);
+    return data;
+}
+
+void unit_cache_store(const char* directory, const TreeHash* key, const void* data, size_t size) {
+    static unsigned long counter;
+    char path[4096], temp[4200];
+    entry_path(path, sizeof(path), directory, key);
+    snprintf(temp, sizeof(temp), "%s.%ld.%lu.tmp", path, (long)getpid(),
+             __atomic_fetch_add(&counter, 1, __ATOMIC_RELAXED));
+
+    FILE* f = fopen(temp, "wb");
+    if (!f) return;
+    int ok = fwrite(data, 1, size, f) == size;
+    if (fclose(f) != 0) ok = 0;
+    if (!ok || rename(temp, path) != 0) remove(temp);
+}
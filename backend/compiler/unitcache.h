@@ -0,0 +1,29 @@
+#ifndef UNITCACHE_H
+#define UNITCACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ast.h"
+
+// On-disk cache of per-function compilation results, keyed by a 128-bit
+// structural hash. The hash covers node types and values only, so two
+// sources that differ in whitespace or comments hash the same. Entries are
+// written to a temporary name and renamed, so concurrent compilers (and
+// the pool threads of one) never see a partial file.
+typedef struct {
+    uint64_t a;
+    uint64_t b;
+} TreeHash;
+
+void hash_init(TreeHash* hash);
+void hash_bytes(TreeHash* hash, const void* data, size_t length);
+void hash_int(TreeHash* hash, int value);
+
+// Mixes in the subtree rooted at node, not counting node->next.
+void hash_tree(TreeHash* hash, const ASTNode* node);
+
+// Returns the malloc'ed entry and its size, NULL if there is none.
+void* unit_cache_load(const char* directory, const TreeHash* key, size_t* size);
+void unit_cache_store(const char* directory, const TreeHash* key, const void* data, size_t size);
+
+#endif
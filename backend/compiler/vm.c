@@ -0,0 +1,443 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "runtime.h"
+#include "vm.h"
+
+#define VM_PROFILE_TOP_PAIRS 40
+
+typedef struct {
+    int return_pc;
+    int* locals;
+} Frame;
+
+static void runtime_error(const char* message) {
+    runtime_flush();
+    fprintf(stderr, "Runtime error: %s\n", message);
+}
+
+// ---- vector kernels -------------------------------------------------------
+
+// Eight lanes: one AVX2 register, or a pair of SSE2 registers in the
+// baseline build. Unsigned, so wrap-around is defined as in the scalar ops.
+typedef unsigned int Lanes __attribute__((vector_size(32)));
+typedef int SignedLanes __attribute__((vector_size(32)));
+#define LANES 8
+#define BLOCK_VECTORS (VECTOR_BLOCK / LANES)
+
+// On x86-64 Linux the block loop is compiled twice and the AVX2 version is
+// picked at load time when the CPU has it.
+#if defined(__x86_64__) && defined(__linux__) && (defined(__clang__) || __GNUC__ >= 6)
+#define VECTOR_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define VECTOR_CLONES
+#endif
+
+VECTOR_CLONES
+static void run_blocks(VectorKernel* kernel, int* locals, int* globals, int first, long long blocks,
+                       Lanes (*regs)[BLOCK_VECTORS]) {
+    const Lanes lane = { 0, 1, 2, 3, 4, 5, 6, 7 };
+
+    for (long long block = 0; block < blocks; block++) {
+        int base = first + (int)(block * VECTOR_BLOCK);
+        for (VectorInstr* in = kernel->code; in < kernel->code + kernel->count; in++) {
+            Lanes* dst = regs[in->dst];
+            Lanes* x = regs[in->x];
+            Lanes* y = regs[in->y];
+            int* memory = in->op == V_LOAD_GLOBAL || in->op == V_STORE_GLOBAL ? globals : locals;
+            switch (in->op) {
+            case V_CONST:
+                for (int v = 0; v < BLOCK_VECTORS; v++) dst[v] = (Lanes){ 0 } + (unsigned)in->a;
+                break;
+            case V_SPLAT:
+                for (int v = 0; v < BLOCK_VECTORS; v++) dst[v] = (Lanes){ 0 } + (unsigned)locals[in->a];
+                break;
+            case V_COUNTER:
+                for (int v = 0; v < BLOCK_VECTORS; v++) dst[v] = lane + (unsigned)(base + v * LANES);
+                break;
+            case V_LOAD:
+            case V_LOAD_GLOBAL:
+                memcpy(dst, memory + in->a + base + in->b, VECTOR_BLOCK * sizeof(int));
+                break;
+            case V_STORE:
+            case V_STORE_GLOBAL:
+                memcpy(memory + in->a + base + in->b, x, VECTOR_BLOCK * sizeof(int));
+                break;
+            case V_ADD:
+                for (int v = 0; v < BLOCK_VECTORS; v++) dst[v] = x[v] + y[v];
+                break;
+            case V_SUB:
+                for (int v = 0; v < BLOCK_VECTORS; v++) dst[v] = x[v] - y[v];
+                break;
+            case V_MUL:
+                for (int v = 0; v < BLOCK_VECTORS; v++) dst[v] = x[v] * y[v];
+                break;
+            case V_NEG:
+                for (int v = 0; v < BLOCK_VECTORS; v++) dst[v] = -x[v];
+                break;
+            case V_TRUNC_CHAR:
+                for (int v = 0; v < BLOCK_VECTORS; v++) dst[v] = (Lanes)((SignedLanes)(x[v] << 24) >> 24);
+                break;
+            case V_SUM:
+                for (int v = 0; v < BLOCK_VECTORS; v++) dst[v] += x[v];
+                break;
+            }
+        }
+    }
+}
+
+// Runs the whole blocks left before the loop limit and advances the
+// counter past them. If any access of those blocks would fall outside its
+// array nothing is done, and the scalar loop reports the bad index.
+static void run_kernel(VectorKernel* kernel, int* locals, int* globals) {
+    long long first = locals[kernel->counter];
+    long long end = (kernel->limit_is_local ? locals[kernel->limit] : kernel->limit) + (long long)kernel->inclusive;
+    long long blocks = end > first ? (end - first) / VECTOR_BLOCK : 0;
+    Lanes regs[VECTOR_MAX_REGS][BLOCK_VECTORS];
+
+    for (VectorInstr* in = kernel->code; blocks && in < kernel->code + kernel->count; in++) {
+        if (in->op != V_LOAD && in->op != V_LOAD_GLOBAL && in->op != V_STORE && in->op != V_STORE_GLOBAL) continue;
+        if (first + in->b < 0 || first + in->b + blocks * VECTOR_BLOCK > in->length) blocks = 0;
+    }
+    if (!blocks) return;
+
+    memset(regs, 0, kernel->nsums * sizeof(regs[0]));
+    run_blocks(kernel, locals, globals, (int)first, blocks, regs);
+    for (VectorInstr* in = kernel->code; in < kernel->code + kernel->count; in++) {
+        if (in->op != V_SUM) continue;
+        unsigned total = (unsigned)locals[in->a];
+        for (int v = 0; v < BLOCK_VECTORS; v++) {
+            for (int l = 0; l < LANES; l++) total += regs[in->dst][v][l];
+        }
+        locals[in->a] = (int)total;
+    }
+    locals[kernel->counter] = (int)(first + blocks * VECTOR_BLOCK);
+}
+
+// -------------------------------------------------------------------------
+
+int vm_run(Chunk* chunk, VMProfile* profile, int* exit_code) {
+    static void* dispatch_table[OP_COUNT] = {
+#define OPCODE_LABEL(name, jump) &&do_##name,
+        OPCODES(OPCODE_LABEL)
+#undef OPCODE_LABEL
+    };
+    int* stack = malloc(VM_STACK_SIZE * sizeof(int));
+    int* globals = calloc(chunk->nglobals ? chunk->nglobals : 1, sizeof(int));
+    Frame* frames = malloc(VM_MAX_FRAMES * sizeof(Frame));
+    int* stack_end = stack + VM_STACK_SIZE;
+    Frame* frame = frames;
+    Frame* frames_end = frames + VM_MAX_FRAMES;
+    Instr* code = chunk->code;
+    BCFunction* functions = chunk->functions;
+    int* sp = stack - 1;
+    int* locals = stack;
+    int ok = 0;
+    int pc = 0;
+    int prev = OP_HALT;
+    Instr* in;
+    BCFunction* fn;
+    int value;
+    int index;
+
+// Dispatch is threaded through a table of label addresses (GNU C).
+#define DISPATCH() do { \
+        in = &code[pc++]; \
+        if (profile) { \
+            profile->dispatches++; \
+            profile->pairs[prev][in->op]++; \
+            prev = in->op; \
+        } \
+        goto *dispatch_table[in->op]; \
+    } while (0)
+
+    DISPATCH();
+
+do_LABEL:
+    DISPATCH();
+do_PUSH_CONST:
+    *++sp = in->a;
+    DISPATCH();
+do_LOAD_LOCAL:
+    *++sp = locals[in->a];
+    DISPATCH();
+do_STORE_LOCAL:
+    locals[in->a] = *sp--;
+    DISPATCH();
+do_STORE_CHAR:
+    locals[in->a] = (signed char)*sp--;
+    DISPATCH();
+do_TRUNC_CHAR:
+    *sp = (signed char)*sp;
+    DISPATCH();
+do_POP:
+    sp--;
+    DISPATCH();
+do_LOAD_ELEM:
+    if ((unsigned)*sp >= (unsigned)in->b) goto out_of_bounds;
+    *sp = locals[in->a + *sp];
+    DISPATCH();
+do_STORE_ELEM:
+    index = sp[-1];
+    if ((unsigned)index >= (unsigned)in->b) goto out_of_bounds;
+    locals[in->a + index] = *sp;
+    sp -= 2;
+    DISPATCH();
+do_LOAD_GLOBAL_ELEM:
+    if ((unsigned)*sp >= (unsigned)in->b) goto out_of_bounds;
+    *sp = globals[in->a + *sp];
+    DISPATCH();
+do_STORE_GLOBAL_ELEM:
+    index = sp[-1];
+    if ((unsigned)index >= (unsigned)in->b) goto out_of_bounds;
+    globals[in->a + index] = *sp;
+    sp -= 2;
+    DISPATCH();
+do_LOAD_ELEM_UNCHECKED:
+    *sp = locals[in->a + *sp];
+    DISPATCH();
+do_STORE_ELEM_UNCHECKED:
+    locals[in->a + sp[-1]] = *sp;
+    sp -= 2;
+    DISPATCH();
+do_LOAD_GLOBAL_ELEM_UNCHECKED:
+    *sp = globals[in->a + *sp];
+    DISPATCH();
+do_STORE_GLOBAL_ELEM_UNCHECKED:
+    globals[in->a + sp[-1]] = *sp;
+    sp -= 2;
+    DISPATCH();
+do_ADD:
+    sp--;
+    *sp = (int)((unsigned)*sp + (unsigned)sp[1]);
+    DISPATCH();
+do_SUB:
+    sp--;
+    *sp = (int)((unsigned)*sp - (unsigned)sp[1]);
+    DISPATCH();
+do_MUL:
+    sp--;
+    *sp = (int)((unsigned)*sp * (unsigned)sp[1]);
+    DISPATCH();
+do_DIV:
+    sp--;
+    if (sp[1] == 0 || (*sp == INT_MIN && sp[1] == -1)) {
+        runtime_error("division by zero or overflow");
+        goto done;
+    }
+    *sp /= sp[1];
+    DISPATCH();
+do_MOD:
+    sp--;
+    if (sp[1] == 0 || (*sp == INT_MIN && sp[1] == -1)) {
+        runtime_error("division by zero or overflow");
+        goto done;
+    }
+    *sp %= sp[1];
+    DISPATCH();
+do_EQ:
+    sp--;
+    *sp = *sp == sp[1];
+    DISPATCH();
+do_NE:
+    sp--;
+    *sp = *sp != sp[1];
+    DISPATCH();
+do_LT:
+    sp--;
+    *sp = *sp < sp[1];
+    DISPATCH();
+do_GT:
+    sp--;
+    *sp = *sp > sp[1];
+    DISPATCH();
+do_LE:
+    sp--;
+    *sp = *sp <= sp[1];
+    DISPATCH();
+do_GE:
+    sp--;
+    *sp = *sp >= sp[1];
+    DISPATCH();
+do_NOT:
+    *sp = !*sp;
+    DISPATCH();
+do_NEG:
+    *sp = (int)(0u - (unsigned)*sp);
+    DISPATCH();
+do_JUMP:
+    pc = in->a;
+    DISPATCH();
+do_JUMP_IF_ZERO:
+    if (!*sp--) pc = in->a;
+    DISPATCH();
+do_JUMP_IF_NOT_ZERO:
+    if (*sp--) pc = in->a;
+    DISPATCH();
+do_JUMP_IF_EQ:
+    sp -= 2;
+    if (sp[1] == sp[2]) pc = in->a;
+    DISPATCH();
+do_JUMP_IF_NE:
+    sp -= 2;
+    if (sp[1] != sp[2]) pc = in->a;
+    DISPATCH();
+do_JUMP_IF_LT:
+    sp -= 2;
+    if (sp[1] < sp[2]) pc = in->a;
+    DISPATCH();
+do_JUMP_IF_GT:
+    sp -= 2;
+    if (sp[1] > sp[2]) pc = in->a;
+    DISPATCH();
+do_JUMP_IF_LE:
+    sp -= 2;
+    if (sp[1] <= sp[2]) pc = in->a;
+    DISPATCH();
+do_JUMP_IF_GE:
+    sp -= 2;
+    if (sp[1] >= sp[2]) pc = in->a;
+    DISPATCH();
+do_JUMP_TABLE:
+    index = (int)((unsigned)*sp-- - (unsigned)in->a);
+    pc = code[pc + ((unsigned)index < (unsigned)in->b ? index : in->b)].a;
+    DISPATCH();
+do_TABLE_ENTRY:
+    DISPATCH();
+do_CALL:
+    fn = &functions[in->a];
+    if (frame == frames_end) {
+        runtime_error("call stack overflow");
+        goto done;
+    }
+    frame->return_pc = pc;
+    frame->locals = locals;
+    frame++;
+    locals = sp - in->b + 1;
+    goto enter;
+do_TAIL_CALL:
+    fn = &functions[in->a];
+    memmove(locals, sp - in->b + 1, in->b * sizeof(int));
+enter:
+    sp = locals + fn->nlocals - 1;
+    if (sp >= stack_end - BYTECODE_MAX_STACK) {
+        runtime_error("stack overflow");
+        goto done;
+    }
+    for (int* slot = locals + in->b; slot <= sp; slot++) *slot = 0;
+    pc = fn->entry;
+    DISPATCH();
+do_RETURN:
+    value = *sp;
+    sp = locals - 1;
+    *++sp = value;
+    frame--;
+    pc = frame->return_pc;
+    locals = frame->locals;
+    DISPATCH();
+do_PRINTF:
+    sp -= in->b;
+    runtime_printf(&chunk->formats[in->a], sp + 1, in->b);
+    DISPATCH();
+do_SCANF:
+    runtime_scanf(&chunk->formats[in->a], sp - in->b + 1, in->b);
+    DISPATCH();
+do_VECTOR_LOOP:
+    run_kernel(&chunk->kernels[in->a], locals, globals);
+    DISPATCH();
+do_HALT:
+    *exit_code = *sp;
+    ok = 1;
+    goto done;
+do_LOAD_LOCAL2:
+    sp += 2;
+    sp[-1] = locals[in->a];
+    *sp = locals[in->b];
+    DISPATCH();
+do_ADD_CONST:
+    *sp = (int)((unsigned)*sp + (unsigned)in->a);
+    DISPATCH();
+do_SUB_CONST:
+    *sp = (int)((unsigned)*sp - (unsigned)in->a);
+    DISPATCH();
+do_MUL_CONST:
+    *sp = (int)((unsigned)*sp * (unsigned)in->a);
+    DISPATCH();
+do_DIV_CONST:
+    if (*sp == INT_MIN && in->a == -1) {
+        runtime_error("division by zero or overflow");
+        goto done;
+    }
+    *sp /= in->a;
+    DISPATCH();
+do_ADD_LOCAL:
+    *sp = (int)((unsigned)*sp + (unsigned)locals[in->a]);
+    DISPATCH();
+do_SUB_LOCAL:
+    *sp = (int)((unsigned)*sp - (unsigned)locals[in->a]);
+    DISPATCH();
+do_MUL_LOCAL:
+    *sp = (int)((unsigned)*sp * (unsigned)locals[in->a]);
+    DISPATCH();
+do_INC_LOCAL:
+    locals[in->a] = (int)((unsigned)locals[in->a] + (unsigned)in->b);
+    DISPATCH();
+do_STORE_LOAD_LOCAL:
+    locals[in->a] = *sp;
+    *sp = locals[in->b];
+    DISPATCH();
+do_STORE_JUMP:
+    locals[in->a] = *sp--;
+    pc = in->b;
+    DISPATCH();
+do_JUMP_IF_LOCAL_ZERO:
+    if (!locals[in->a]) pc = in->b;
+    DISPATCH();
+
+#undef DISPATCH
+out_of_bounds:
+    runtime_error("array index out of bounds");
+done:
+    runtime_flush();
+    free(frames);
+    free(globals);
+    free(stack);
+    return ok;
+}
+
+typedef struct {
+    long long count;
+    int first;
+    int second;
+} PairCount;
+
+static int compare_pairs(const void* a, const void* b) {
+    const PairCount* x = a;
+    const PairCount* y = b;
+    return (x->count < y->count) - (x->count > y->count);
+}
+
+void vm_print_profile(VMProfile* profile, FILE* out) {
+    PairCount* pairs = malloc(OP_COUNT * OP_COUNT * sizeof(PairCount));
+    int n = 0;
+
+    for (int a = 0; a < OP_COUNT; a++) {
+        for (int b = 0; b < OP_COUNT; b++) {
+            if (!profile->pairs[a][b]) continue;
+            pairs[n].count = profile->pairs[a][b];
+            pairs[n].first = a;
+            pairs[n].second = b;
+            n++;
+        }
+    }
+    qsort(pairs, n, sizeof(PairCount), compare_pairs);
+
+    fprintf(out, "dispatches: %lld\n", profile->dispatches);
+    for (int i = 0; i < n && i < VM_PROFILE_TOP_PAIRS; i++) {
+        fprintf(out, "%12lld  %5.1f%%  %s -> %s\n", pairs[i].count,
+                100.0 * pairs[i].count / profile->dispatches,
+                opcode_names[pairs[i].first], opcode_names[pairs[i].second]);
+    }
+    free(pairs);
+}
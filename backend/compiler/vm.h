@@ -0,0 +1,23 @@
+#ifndef VM_H
+#define VM_H
+
+#include <stdio.h>
+#include "bytecode.h"
+
+#define VM_STACK_SIZE (1 << 20)
+#define VM_MAX_FRAMES (1 << 16)
+
+typedef struct {
+    long long dispatches;
+    long long pairs[OP_COUNT][OP_COUNT];
+} VMProfile;
+
+// Runs the program from main. Returns 0 and reports on stderr on a runtime
+// error, otherwise stores main's return value in *exit_code. When profile
+// is non-NULL every dispatch and every adjacent opcode pair is counted.
+int vm_run(Chunk* chunk, VMProfile* profile, int* exit_code);
+
+// Prints the dispatch count and the most frequent opcode pairs.
+void vm_print_profile(VMProfile* profile, FILE* out);
+
+#endif